@@ -0,0 +1,140 @@
+// Measures each LZF compression level and decompressor on LZFBufferedOutput sized blocks.
+//
+//	Open_AlteryxYXDBCompressionBench [file]
+//
+// With no file it uses generated data that looks roughly like YXDB records.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "Base/LzfWrapper.h"
+
+using namespace SRC::LzfWrapper;
+
+namespace {
+const unsigned BlockSize = 0x40000;
+
+std::vector<unsigned char> GenerateData(size_t nSize)
+{
+	static const char* words[] = { "Boulder", "Denver",  "Colorado", "Main St",  "Smith",    "Johnson",
+								   "Alteryx", "Invoice", "Shipped",  "Pending", "Returned", "" };
+	std::mt19937 r;
+	std::vector<unsigned char> v;
+	v.reserve(nSize);
+	while (v.size() < nSize)
+	{
+		// an id, a couple of strings, a date and a double - most of it is repetitive, but not exactly
+		unsigned nId = unsigned(v.size() / 40);
+		v.insert(v.end(), reinterpret_cast<unsigned char*>(&nId), reinterpret_cast<unsigned char*>(&nId) + 4);
+		for (int x = 0; x < 2; ++x)
+		{
+			const char* p = words[r() % (sizeof(words) / sizeof(words[0]))];
+			v.insert(v.end(), p, p + strlen(p) + 1);
+		}
+		char date[16];
+		snprintf(date, sizeof(date), "2024-%02u-%02u", unsigned(1 + r() % 12), unsigned(1 + r() % 28));
+		v.insert(v.end(), date, date + 10);
+		double d = double(r() % 100000) / 100;
+		v.insert(v.end(), reinterpret_cast<unsigned char*>(&d), reinterpret_cast<unsigned char*>(&d) + 8);
+	}
+	v.resize(nSize);
+	return v;
+}
+
+double Seconds(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+typedef unsigned int (*CompressFn)(const void* const, unsigned int, void*, unsigned int);
+
+unsigned int CompressDense(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	return lzf_compress_dense(in_data, in_len, out_data, out_len);
+}
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+	std::vector<unsigned char> vData;
+	if (argc > 1)
+	{
+		std::ifstream file(argv[1], std::ios::binary);
+		vData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		if (vData.empty())
+		{
+			fprintf(stderr, "Unable to read %s\n", argv[1]);
+			return 1;
+		}
+	}
+	else
+		vData = GenerateData(64 << 20);
+
+	const size_t nBlocks = (vData.size() + BlockSize - 1) / BlockSize;
+	std::vector<std::vector<unsigned char>> vCompressed(nBlocks, std::vector<unsigned char>(BlockSize));
+	std::vector<unsigned> vCompressedSize(nBlocks);
+	std::vector<unsigned char> vOut(BlockSize);
+	const double nMB = double(vData.size()) / (1 << 20);
+
+	const struct
+	{
+		const char* pName;
+		CompressFn compress;
+	} levels[] = { { "fast", &lzf_compress_fast }, { "default", &lzf_compress }, { "dense", &CompressDense } };
+
+	printf("%.1f MB in %u byte blocks\n", nMB, BlockSize);
+	for (const auto& level : levels)
+	{
+		auto start = std::chrono::steady_clock::now();
+		size_t nTotal = 0;
+		size_t nDecompressed = 0;
+		for (size_t x = 0; x < nBlocks; ++x)
+		{
+			unsigned nSize = unsigned(std::min(size_t(BlockSize), vData.size() - x * BlockSize));
+			// like LZFBufferedOutput, a block that doesn't shrink is stored as is
+			vCompressedSize[x] = level.compress(&vData[x * BlockSize], nSize, vCompressed[x].data(), nSize - 1);
+			nTotal += vCompressedSize[x] == 0 ? nSize : vCompressedSize[x];
+			nDecompressed += vCompressedSize[x] == 0 ? 0 : nSize;
+		}
+		double nCompressSeconds = Seconds(start);
+		printf(
+			"%-8s ratio %.3f  compress %7.1f MB/s", level.pName, double(nTotal) / vData.size(), nMB / nCompressSeconds);
+
+		const struct
+		{
+			const char* pName;
+			E_LzfDecompressor eDecompressor;
+		} decompressors[] = { { "reference", E_LzfDecompressor_Reference },
+							  { "sse2", E_LzfDecompressor_SSE2 },
+							  { "avx2", E_LzfDecompressor_AVX2 } };
+		for (const auto& decompressor : decompressors)
+		{
+			// stored blocks aren't decompressed at all
+			if (nDecompressed == 0 || SetDecompressor(decompressor.eDecompressor) != decompressor.eDecompressor)
+				continue;
+
+			start = std::chrono::steady_clock::now();
+			for (size_t x = 0; x < nBlocks; ++x)
+			{
+				if (vCompressedSize[x] == 0)
+					continue;
+				unsigned nSize = unsigned(std::min(size_t(BlockSize), vData.size() - x * BlockSize));
+				if (lzf_decompress(vCompressed[x].data(), vCompressedSize[x], vOut.data(), BlockSize) != nSize
+					|| memcmp(vOut.data(), &vData[x * BlockSize], nSize) != 0)
+				{
+					printf("\n%s level failed to round trip block %u\n", level.pName, unsigned(x));
+					return 1;
+				}
+			}
+			printf("  %s %7.1f MB/s", decompressor.pName, double(nDecompressed) / (1 << 20) / Seconds(start));
+		}
+		printf("\n");
+	}
+	SetDecompressor(GetBestDecompressor());
+	return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Base/Base_ImpExp.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace SRC {
+// which file a cached block came from.  The modification time and size are part of it so a file that is rewritten
+// in place doesn't pick up the blocks of its old contents
+struct FileIdentity
+{
+	uint64_t nDevice = 0;
+	uint64_t nInode = 0;
+	int64_t nModifiedTime = 0;
+	int64_t nSize = 0;
+
+	inline bool operator==(const FileIdentity& o) const
+	{
+		return nDevice == o.nDevice && nInode == o.nInode && nModifiedTime == o.nModifiedTime && nSize == o.nSize;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class BlockCache
+//
+// A memory bounded LRU cache of decompressed LZFBufferedInput blocks, keyed by the file and where the block starts
+// in it, so any number of readers of the same file (see LZFBufferedInput::SetBlockCache) only decompress each block
+// once while it stays cached.  The entries are spread over NumStripes independently locked stripes, so readers on
+// different threads rarely wait on each other.  The memory limit is on the whole cache, however the blocks happen to
+// fall into the stripes: when it is over, the least recently used blocks of the stripe being added to go first, then
+// those of the other stripes in turn.  Thread safe.
+class BASE_EXPORT BlockCache
+{
+public:
+	// a decompressed block, and where the block after it starts in the file
+	struct Block
+	{
+		std::vector<unsigned char> m_vData;
+		int64_t m_nEndPos = 0;
+	};
+	typedef std::shared_ptr<const Block> T_Block;
+
+	struct Stats
+	{
+		uint64_t nHits = 0;
+		uint64_t nMisses = 0;
+		size_t nBlocks = 0;
+		size_t nBytes = 0;
+	};
+
+	static const unsigned NumStripes = 16;
+
+private:
+	struct Key
+	{
+		FileIdentity file;
+		int64_t nPos;
+
+		inline bool operator==(const Key& o) const
+		{
+			return nPos == o.nPos && file == o.file;
+		}
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	typedef std::list<std::pair<Key, T_Block>> T_LRU;
+	struct Stripe
+	{
+		std::mutex m_mutex;
+		// most recently used first
+		T_LRU m_lru;
+		std::unordered_map<Key, T_LRU::iterator, KeyHash> m_map;
+		size_t m_nBytes = 0;
+		uint64_t m_nHits = 0;
+		uint64_t m_nMisses = 0;
+	};
+	Stripe m_stripes[NumStripes];
+	std::atomic<size_t> m_nMaxBytes;
+	// across all the stripes
+	std::atomic<size_t> m_nBytes;
+	// the stripe EvictOverBudget starts with, so no one stripe takes all the evictions
+	std::atomic<unsigned> m_nNextEvictStripe;
+
+	Stripe& GetStripe(const Key& key);
+	// drops the stripe's least recently used blocks until the whole cache is down to nMaxBytes or the stripe is empty.
+	// Call with the stripe's mutex locked
+	void Evict(Stripe& stripe, size_t nMaxBytes);
+	// the same over the stripes in turn.  Call without any of their mutexes locked
+	void EvictOverBudget(size_t nMaxBytes);
+
+public:
+	explicit BlockCache(size_t nMaxBytes = 0);
+	BlockCache(const BlockCache&) = delete;
+	BlockCache& operator=(const BlockCache&) = delete;
+
+	// the one every Open_AlteryxYXDB shares unless it is given another.  It starts out at 0 bytes, which turns it off
+	static BlockCache& Global();
+
+	// the most memory the blocks can take up, all together.  Shrinking it evicts blocks straight away
+	void SetMaxBytes(size_t nMaxBytes);
+	size_t GetMaxBytes() const;
+
+	// NULL if the block isn't cached
+	T_Block Find(const FileIdentity& file, int64_t nPos);
+
+	// adds a block, unless another thread has already added it, and returns whichever one is cached.
+	// A block bigger than the whole cache isn't kept, but is still returned
+	T_Block Insert(const FileIdentity& file, int64_t nPos, T_Block pBlock);
+
+	void Clear();
+
+	Stats GetStats();
+};
+}  // namespace SRC
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Base/Base_ImpExp.h"
+
+namespace SRC {
+// the ids of the built in codecs.  In a YXDB this is what is stored in HeaderData::nCompressionVersion
+// (where 0 means not compressed at all).  Only LZF can be read by Alteryx itself.
+enum E_CodecId
+{
+	E_Codec_LZF = 1,
+	E_Codec_LZ4 = 2,    // LZ4 block format, fast
+	E_Codec_LZ4HC = 3,  // LZ4 block format, slower to write for a better ratio.  Reads as fast as E_Codec_LZ4
+};
+
+// how hard Codec::WithLevel's codec works.  It only changes the compression, never the format.
+enum E_CompressionLevel
+{
+	E_CompressionLevel_Fast,
+	E_CompressionLevel_Default,
+	E_CompressionLevel_Dense,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// class Codec
+//
+// Compresses the individual blocks of an LZFBufferedOutput stream and decompresses them
+// in LZFBufferedInput.  The framing of the blocks is the same whichever codec is used.
+// The functions must be thread safe, since the blocks are compressed on several threads at once.
+class BASE_EXPORT Codec
+{
+public:
+	virtual ~Codec();
+
+	virtual unsigned GetId() const = 0;
+	virtual const char* GetName() const = 0;
+
+	// returns the compressed size, or 0 if it would not fit in nOutSize bytes (the block is then stored uncompressed)
+	virtual unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const = 0;
+
+	// returns the decompressed size, or 0 if the data is corrupt or would not fit in nOutSize bytes
+	virtual unsigned Decompress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const = 0;
+
+	// a codec with the same id that compresses at eLevel.  By default it is this one, whatever the level.
+	virtual const Codec& WithLevel(E_CompressionLevel eLevel) const;
+};
+
+namespace CodecRegistry {
+// returns NULL if there is no codec with that id
+BASE_EXPORT const Codec* FindCodec(unsigned nId);
+
+// throws if there is no codec with that id
+BASE_EXPORT const Codec& GetCodec(unsigned nId);
+
+// adds a codec, replacing any already registered with the same id.
+// The registry doesn't take ownership, so it needs to live as long as anything might use it.
+BASE_EXPORT void RegisterCodec(const Codec* pCodec);
+}  // namespace CodecRegistry
+}  // namespace SRC
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Base/Base_ImpExp.h"
+
+// A self contained implementation of the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md)
+// so the blocks can be read by any LZ4 decoder, but without depending on the lz4 library.
+// The arguments and return values follow LzfWrapper.
+namespace SRC { namespace Lz4Block {
+
+// returns the compressed size, or 0 if it would not fit in out_len bytes
+BASE_EXPORT unsigned int lz4_compress(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len);
+
+// slower, but searches harder for matches (hash chains and lazy matching) for a better ratio.
+// nMaxAttempts is how many earlier positions to try for each match.
+BASE_EXPORT unsigned int lz4_compress_hc(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len,
+	unsigned nMaxAttempts = 256);
+
+// returns the decompressed size, or 0 if the data is corrupt or would not fit in out_len bytes
+BASE_EXPORT unsigned int lz4_decompress(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len);
+
+}}  // namespace SRC::Lz4Block
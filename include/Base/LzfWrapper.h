@@ -16,4 +16,48 @@ BASE_EXPORT unsigned int lzf_decompress(
 	void* out_data,
 	unsigned int out_len);
 
+// faster than lzf_compress for a somewhat worse ratio - a smaller hash table, and the longer it goes without
+// a match the further it skips ahead
+BASE_EXPORT unsigned int lzf_compress_fast(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len);
+
+// slower than lzf_compress for a better ratio - a bigger hash table with chains and lazy matching.
+// nMaxAttempts is how many earlier positions to try for each match.
+// Both write standard LZF, so lzf_decompress can read them.
+BASE_EXPORT unsigned int lzf_compress_dense(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len,
+	unsigned nMaxAttempts = 64);
+
+// the implementations lzf_decompress can use.  They all give exactly the same results.
+// E_LzfDecompressor_Reference is the original lzf_d.c, which mostly copies a byte at a time.
+// The others copy literals and matches 16 or 32 bytes at a time.  Without SSE2 (i.e. not on x86)
+// E_LzfDecompressor_SSE2 is the same thing done with plain 16 byte copies.
+enum E_LzfDecompressor
+{
+	E_LzfDecompressor_Reference,
+	E_LzfDecompressor_SSE2,
+	E_LzfDecompressor_AVX2,
+};
+
+// the fastest one this CPU supports, which is what is used by default
+BASE_EXPORT E_LzfDecompressor GetBestDecompressor();
+
+// selects the implementation used by lzf_decompress for the whole process.
+// Returns the one actually used, which is GetBestDecompressor() if the CPU doesn't support the one asked for.
+BASE_EXPORT E_LzfDecompressor SetDecompressor(E_LzfDecompressor eDecompressor);
+BASE_EXPORT E_LzfDecompressor GetDecompressor();
+
+// always uses lzf_d.c, for checking the others against
+BASE_EXPORT unsigned int lzf_decompress_reference(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len);
+
 }}  // namespace SRC::LzfWrapper
@@ -12,11 +12,12 @@
 #pragma once
 
 #ifdef SRCLIB_REPLACEMENT
-	#include "Base/LzfWrapper.h"
+	#include "Base/Codec.h"
 #else
 	#include "Base/Glot.h"
-	#include "Base/LzfWrapper.h"
+	#include "Base/Codec.h"
 #endif
+#include "Base/BlockCache.h"
 
 #ifndef __GNUC__
 	#define STDCALL __stdcall
@@ -24,7 +25,15 @@
 	#define STDCALL
 #endif
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #ifndef __GNUC__
 	#pragma warning(push)
@@ -32,78 +41,81 @@
 #endif
 
 namespace SRC {
+// despite the names, LZFBufferedOutput and LZFBufferedInput work with any Codec.  NULL means LZF
+inline const Codec& GetLZFBufferedCodec(const Codec* pCodec)
+{
+	return pCodec ? *pCodec : CodecRegistry::GetCodec(E_Codec_LZF);
+}
+
+// each block starts with its size, with the high bit set if it is stored uncompressed.
+// That is 2 bytes if the block size fits in 15 bits, otherwise 4.
+inline bool LZFShortBlockHeader(unsigned nBlockSize)
+{
+	return nBlockSize <= 0x7fff;
+}
+inline unsigned LZFBlockHeaderSize(unsigned nBlockSize)
+{
+	return LZFShortBlockHeader(nBlockSize) ? sizeof(unsigned short) : sizeof(unsigned);
+}
+
 // TFileP is usually a SmartPointer to a file
+//
+// BufferSize is only the default block size - the actual one is given to the constructor.
+// With nThreads > 0 the blocks are compressed on that many worker threads while the caller
+// keeps filling the next one.  The compressed blocks are always written out in order, and only
+// from the thread calling Write/FlushBuffer, so the file itself doesn't need to be thread safe.
 template <class TFileP, class TEngine, unsigned BufferSize = 0x40000>
 class LZFBufferedOutput
 {
 	struct CompressBuffer
 	{
-		unsigned char m_pOutBuffer[BufferSize];
+		const unsigned m_nBlockSize;
+		std::vector<unsigned char> m_vOutBuffer;
 		unsigned m_nOutBufferUsed;
-		unsigned char m_pInBuffer[BufferSize];
+		std::vector<unsigned char> m_vInBuffer;
 		unsigned m_nInBufferUsed;
 
 		TFileP m_pFile;
-#ifndef __GNUC__
-		HANDLE m_hEvent;
-#endif
-		inline CompressBuffer(TFileP pFile, bool bCreateEvent)
-			: m_nOutBufferUsed(0)
+		const Codec& m_codec;
+
+		// set (under m_mutex) by the worker thread once m_vOutBuffer is ready to be written
+		bool m_bCompressed;
+
+		inline CompressBuffer(TFileP pFile, const Codec& codec, unsigned nBlockSize)
+			: m_nBlockSize(nBlockSize)
+			, m_vOutBuffer(nBlockSize)
+			, m_nOutBufferUsed(0)
+			, m_vInBuffer(nBlockSize)
 			, m_nInBufferUsed(0)
 			, m_pFile(pFile)
+			, m_codec(codec)
+			, m_bCompressed(false)
 		{
-#ifndef __GNUC__
-			if (bCreateEvent)
-				m_hEvent = CreateEvent(NULL, false, false, NULL);
-			else
-				m_hEvent = NULL;
-#endif
-		}
-
-		inline ~CompressBuffer()
-		{
-#ifndef __GNUC__
-			if (m_hEvent != NULL)
-				CloseHandle(m_hEvent);
-#endif
 		}
 
+		// this may be called in a worker thread
+		// hence it cannot modify m_nInBufferUsed because
+		// we use that in the master thread to know if anything happened
 		void DoCompress()
 		{
 			assert(m_nInBufferUsed != 0);
 			m_nOutBufferUsed =
-				LzfWrapper::lzf_compress(m_pInBuffer, m_nInBufferUsed, m_pOutBuffer, m_nInBufferUsed - 1);
-		}
-
-		// this will be called in a worker thread
-		// hence it cannot modify m_nInBufferUsed because
-		// we use that in the master thread to know if anything happened
-		static void STDCALL DoCompress(void* _pThis)
-		{
-			CompressBuffer* pThis = static_cast<CompressBuffer*>(_pThis);
-			pThis->DoCompress();
-#ifndef __GNUC__
-			SetEvent(pThis->m_hEvent);
-#endif
+				m_codec.Compress(m_vInBuffer.data(), m_nInBufferUsed, m_vOutBuffer.data(), m_nInBufferUsed - 1);
 		}
 
-#ifndef __GNUC__
-		inline void WaitForCompletion()
-		{
-			WaitForSingleObject(m_hEvent, INFINITE);
-		}
-#endif
 		// this should always be called from the master thread
-		inline void DoWrite()
+		// returns the # of bytes written to the file
+		inline unsigned DoWrite()
 		{
 			assert(m_nInBufferUsed != 0);
+			unsigned nWritten;
 
 			// it wasn't able to compress, just write the data straight out
 			if (m_nOutBufferUsed == 0)
 			{
-				assert(m_nInBufferUsed <= BufferSize);
+				assert(m_nInBufferUsed <= m_nBlockSize);
 				unsigned nResultBytes = m_nInBufferUsed;
-				if (BufferSize <= 0x7fff)
+				if (LZFShortBlockHeader(m_nBlockSize))
 				{
 					unsigned short snResultBytes = static_cast<unsigned short>(nResultBytes | 0x8000);
 					m_pFile->Write(&snResultBytes, sizeof(snResultBytes));
@@ -113,119 +125,273 @@ class LZFBufferedOutput
 					nResultBytes |= 0x80000000;
 					m_pFile->Write(&nResultBytes, sizeof(nResultBytes));
 				}
-				m_pFile->Write((const char*)m_pInBuffer, m_nInBufferUsed);
+				m_pFile->Write((const char*)m_vInBuffer.data(), m_nInBufferUsed);
+				nWritten = m_nInBufferUsed;
 			}
 			else
 			{
-				assert(m_nOutBufferUsed <= BufferSize);
-				if (BufferSize <= 0x7fff)
+				assert(m_nOutBufferUsed <= m_nBlockSize);
+				if (LZFShortBlockHeader(m_nBlockSize))
 				{
 					unsigned short snResultBytes = static_cast<unsigned short>(m_nOutBufferUsed);
 					m_pFile->Write(&snResultBytes, sizeof(snResultBytes));
 				}
 				else
 					m_pFile->Write(&m_nOutBufferUsed, sizeof(m_nOutBufferUsed));
-				m_pFile->Write((const char*)m_pOutBuffer, m_nOutBufferUsed);
+				m_pFile->Write((const char*)m_vOutBuffer.data(), m_nOutBufferUsed);
+				nWritten = m_nOutBufferUsed;
 			}
 			m_nInBufferUsed = 0;
 			m_nOutBufferUsed = 0;
+			return nWritten + LZFBlockHeaderSize(m_nBlockSize);
 		}
 	};
 
-	inline void DoWrite(CompressBuffer* pCurrentBuffer)
-	{
-		try
-		{
-			pCurrentBuffer->DoWrite();
-		}
-		catch (...)
-		{
-			pCurrentBuffer->m_nInBufferUsed = 0;
-			pCurrentBuffer->m_nOutBufferUsed = 0;
-
-			// go through all the buffers and flush them WITHOUT Writing, starting with the next one.
-			if (m_pNextBuffer->m_nInBufferUsed != 0)
-			{
-#ifndef __GNUC__
-				m_pNextBuffer->WaitForCompletion();
-#endif
-				m_pNextBuffer->m_nInBufferUsed = 0;
-				m_pNextBuffer->m_nOutBufferUsed = 0;
-			}
-			if (m_pCurrentBuffer->m_nInBufferUsed != 0)
-			{
-#ifndef __GNUC__
-				m_pCurrentBuffer->WaitForCompletion();
-#endif
-				m_pCurrentBuffer->m_nInBufferUsed = 0;
-				m_pCurrentBuffer->m_nOutBufferUsed = 0;
-			}
-			throw;
-		}
-	}
+	const unsigned m_nBlockSize;
 
-	CompressBuffer m_buffer1;
-	// this isn't always used, so we don't allocate it until we need it.
-	std::unique_ptr<CompressBuffer> m_pBuffer2;
+	// the buffer currently being filled by Write
 	CompressBuffer* m_pCurrentBuffer;
-	CompressBuffer* m_pNextBuffer;
 
-	const TEngine* m_pEngine;
+	std::vector<std::unique_ptr<CompressBuffer>> m_vBuffers;
+	std::vector<CompressBuffer*> m_vFreeBuffers;
+
+	// buffers handed to the workers, in the order they need to be written.  Only touched by the master thread.
+	std::deque<CompressBuffer*> m_qInFlight;
+
+	// shared with the worker threads
+	std::mutex m_mutex;
+	std::condition_variable m_cvCompress;
+	std::condition_variable m_cvCompressed;
+	std::deque<CompressBuffer*> m_qToCompress;
+	bool m_bShutdown;
+	std::vector<std::thread> m_vThreads;
+
+	// the # of blocks handed off for writing so far
+	uint64_t m_nNumBlocks;
+
+	// see TrackBlockPositions
+	bool m_bTrackBlockPositions;
+	int64_t m_nFilePos;
+	std::vector<int64_t> m_vBlockPos;
+
+	void CompressThread();
+	bool IsCompressed(CompressBuffer* pBuffer);
+	void QueueCompress(CompressBuffer* pBuffer);
+	void WriteOldest();
+	void DoWrite(CompressBuffer* pBuffer);
+	void StopThreads();
 
 public:
-	LZFBufferedOutput(const TEngine* pEngine, TFileP pFile);
+	// if nThreads is 0, a single worker thread is used when there is an engine, otherwise everything is
+	// compressed synchronously on the calling thread.  See Open_AlteryxYXDB::SetCompressionThreads
+	LZFBufferedOutput(
+		const TEngine* pEngine,
+		TFileP pFile,
+		unsigned nThreads = 0,
+		const Codec* pCodec = NULL,
+		unsigned nBlockSize = BufferSize);
 	inline void FlushBuffer();
 	~LZFBufferedOutput();
 	void Write(const void* pBuffer, unsigned nSize);
+
+	// where the next byte written will be - the # of the block it will be in, and how far into the
+	// uncompressed data of that block
+	inline uint64_t GetBlockNum() const
+	{
+		return m_nNumBlocks;
+	}
+	inline unsigned GetBlockOffset() const
+	{
+		return m_pCurrentBuffer->m_nInBufferUsed;
+	}
+
+	// remembers the file position of every block as it is written.  nFilePos is the current position of the file
+	void TrackBlockPositions(int64_t nFilePos)
+	{
+		m_bTrackBlockPositions = true;
+		m_nFilePos = nFilePos;
+	}
+	// the file positions of the blocks written so far, indexed by GetBlockNum
+	inline const std::vector<int64_t>& GetBlockPositions() const
+	{
+		return m_vBlockPos;
+	}
 };
 
 template <class TFileP, class TEngine, unsigned BufferSize>
-LZFBufferedOutput<TFileP, TEngine, BufferSize>::LZFBufferedOutput(const TEngine* pEngine, TFileP pFile)
-	: m_buffer1(pFile, pEngine != NULL)
-	, m_pEngine(pEngine)
+LZFBufferedOutput<TFileP, TEngine, BufferSize>::LZFBufferedOutput(
+	const TEngine* pEngine,
+	TFileP pFile,
+	unsigned nThreads /*= 0*/,
+	const Codec* pCodec /*= NULL*/,
+	unsigned nBlockSize /*= BufferSize*/)
+	: m_nBlockSize(nBlockSize)
+	, m_bShutdown(false)
+	, m_nNumBlocks(0)
+	, m_bTrackBlockPositions(false)
+	, m_nFilePos(0)
 {
-	m_pCurrentBuffer = &m_buffer1;
-	if (m_pEngine)
+	if (nThreads == 0 && pEngine != NULL)
+		nThreads = 1;
+
+	// 2 buffers per thread keeps the workers busy while the next buffer is being filled and the last one written
+	unsigned nNumBuffers = nThreads == 0 ? 1 : nThreads * 2;
+	for (unsigned x = 0; x < nNumBuffers; ++x)
 	{
-		m_pBuffer2 = std::make_unique<CompressBuffer>(pFile, pEngine != NULL);
-		m_pNextBuffer = m_pBuffer2.get();
+		m_vBuffers.push_back(std::make_unique<CompressBuffer>(pFile, GetLZFBufferedCodec(pCodec), nBlockSize));
+		m_vFreeBuffers.push_back(m_vBuffers.back().get());
+	}
+	m_pCurrentBuffer = m_vFreeBuffers.back();
+	m_vFreeBuffers.pop_back();
+
+	try
+	{
+		for (unsigned x = 0; x < nThreads; ++x)
+			m_vThreads.emplace_back(&LZFBufferedOutput::CompressThread, this);
+	}
+	catch (...)
+	{
+		StopThreads();
+		throw;
 	}
-	else
-		m_pNextBuffer = NULL;
 }
 
 template <class TFileP, class TEngine, unsigned BufferSize>
-void LZFBufferedOutput<TFileP, TEngine, BufferSize>::FlushBuffer()
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::CompressThread()
 {
-#ifndef __GNUC__
-	if (m_pEngine)
+	for (;;)
 	{
-		// queue up compressing this buffer so it can happen while we are writing the previos data
-		if (m_pCurrentBuffer->m_nInBufferUsed != 0)
-			m_pEngine->QueueThread(CompressBuffer::DoCompress, m_pCurrentBuffer);
+		CompressBuffer* pBuffer;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cvCompress.wait(lock, [this] { return m_bShutdown || !m_qToCompress.empty(); });
+			if (m_qToCompress.empty())
+				return;
+
+			pBuffer = m_qToCompress.front();
+			m_qToCompress.pop_front();
+		}
+
+		pBuffer->DoCompress();
 
-		// the Next in this case might actually be the previous so we have to write it 1st
-		// if it has no data, the write does nothing
-		if (m_pNextBuffer->m_nInBufferUsed != 0)
 		{
-			m_pNextBuffer->WaitForCompletion();
-			DoWrite(m_pNextBuffer);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			pBuffer->m_bCompressed = true;
 		}
-		if (m_pCurrentBuffer->m_nInBufferUsed != 0)
+		m_cvCompressed.notify_all();
+	}
+}
+
+template <class TFileP, class TEngine, unsigned BufferSize>
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::StopThreads()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bShutdown = true;
+	}
+	m_cvCompress.notify_all();
+	for (auto& thread : m_vThreads)
+		thread.join();
+	m_vThreads.clear();
+}
+
+template <class TFileP, class TEngine, unsigned BufferSize>
+bool LZFBufferedOutput<TFileP, TEngine, BufferSize>::IsCompressed(CompressBuffer* pBuffer)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return pBuffer->m_bCompressed;
+}
+
+template <class TFileP, class TEngine, unsigned BufferSize>
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::QueueCompress(CompressBuffer* pBuffer)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pBuffer->m_bCompressed = false;
+		m_qToCompress.push_back(pBuffer);
+	}
+	m_cvCompress.notify_one();
+	m_qInFlight.push_back(pBuffer);
+	m_nNumBlocks++;
+}
+
+// waits for the oldest queued buffer to finish compressing and writes it
+template <class TFileP, class TEngine, unsigned BufferSize>
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::WriteOldest()
+{
+	CompressBuffer* pBuffer = m_qInFlight.front();
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cvCompressed.wait(lock, [pBuffer] { return pBuffer->m_bCompressed; });
+	}
+	m_qInFlight.pop_front();
+	m_vFreeBuffers.push_back(pBuffer);
+	DoWrite(pBuffer);
+}
+
+template <class TFileP, class TEngine, unsigned BufferSize>
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::DoWrite(CompressBuffer* pBuffer)
+{
+	try
+	{
+		if (m_bTrackBlockPositions)
+			m_vBlockPos.push_back(m_nFilePos);
+		m_nFilePos += pBuffer->DoWrite();
+	}
+	catch (...)
+	{
+		pBuffer->m_nInBufferUsed = 0;
+		pBuffer->m_nOutBufferUsed = 0;
+
+		// go through all the buffers and flush them WITHOUT Writing.
+		// The workers may still be using the queued ones, so wait for them first
+		while (!m_qInFlight.empty())
 		{
-			m_pCurrentBuffer->WaitForCompletion();
-			DoWrite(m_pCurrentBuffer);
+			CompressBuffer* pInFlight = m_qInFlight.front();
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cvCompressed.wait(lock, [pInFlight] { return pInFlight->m_bCompressed; });
+			}
+			m_qInFlight.pop_front();
+			pInFlight->m_nInBufferUsed = 0;
+			pInFlight->m_nOutBufferUsed = 0;
+			m_vFreeBuffers.push_back(pInFlight);
 		}
+		m_pCurrentBuffer->m_nInBufferUsed = 0;
+		m_pCurrentBuffer->m_nOutBufferUsed = 0;
+		throw;
 	}
-	else
-#endif
+}
+
+template <class TFileP, class TEngine, unsigned BufferSize>
+void LZFBufferedOutput<TFileP, TEngine, BufferSize>::FlushBuffer()
+{
+	if (m_vThreads.empty())
 	{
 		// single threaded mode
 		if (m_pCurrentBuffer->m_nInBufferUsed != 0)
 		{
 			m_pCurrentBuffer->DoCompress();
+			m_nNumBlocks++;
 			DoWrite(m_pCurrentBuffer);
 		}
+		return;
+	}
+
+	// queue up compressing this buffer so it can happen while we are writing the previous data
+	if (m_pCurrentBuffer->m_nInBufferUsed != 0)
+	{
+		QueueCompress(m_pCurrentBuffer);
+		m_pCurrentBuffer = nullptr;
+	}
+
+	while (!m_qInFlight.empty())
+		WriteOldest();
+
+	if (!m_pCurrentBuffer)
+	{
+		m_pCurrentBuffer = m_vFreeBuffers.back();
+		m_vFreeBuffers.pop_back();
 	}
 }
 
@@ -234,36 +400,33 @@ void LZFBufferedOutput<TFileP, TEngine, BufferSize>::Write(const void* pBuffer,
 {
 	while (nSize > 0)
 	{
-		unsigned nCopySize = std::min(BufferSize - m_pCurrentBuffer->m_nInBufferUsed, nSize);
-		memcpy(m_pCurrentBuffer->m_pInBuffer + m_pCurrentBuffer->m_nInBufferUsed, pBuffer, nCopySize);
+		unsigned nCopySize = std::min(m_nBlockSize - m_pCurrentBuffer->m_nInBufferUsed, nSize);
+		memcpy(m_pCurrentBuffer->m_vInBuffer.data() + m_pCurrentBuffer->m_nInBufferUsed, pBuffer, nCopySize);
 		m_pCurrentBuffer->m_nInBufferUsed += nCopySize;
 		nSize -= nCopySize;
 		pBuffer = ((char*)pBuffer) + nCopySize;
 
-		if (m_pCurrentBuffer->m_nInBufferUsed == BufferSize)
+		if (m_pCurrentBuffer->m_nInBufferUsed == m_nBlockSize)
 		{
-#ifndef __GNUC__
-			if (m_pEngine)
+			if (!m_vThreads.empty())
 			{
 				// queue up the data for compressing
-				m_pEngine->QueueThread(CompressBuffer::DoCompress, m_pCurrentBuffer);
+				QueueCompress(m_pCurrentBuffer);
+				m_pCurrentBuffer = nullptr;
 
-				// switch to the next buffer that is hopefully already done compressing
-				std::swap(m_pCurrentBuffer, m_pNextBuffer);
+				// write out anything that has already finished, and if every buffer is
+				// busy, wait for the oldest so we can reuse it
+				while (!m_qInFlight.empty() && (m_vFreeBuffers.empty() || IsCompressed(m_qInFlight.front())))
+					WriteOldest();
 
-				// and write any previously compressed data in this buffer
-				// the DoWrite will take care of waiting for the compression to be done if needed
-				if (m_pCurrentBuffer->m_nInBufferUsed != 0)
-				{
-					m_pCurrentBuffer->WaitForCompletion();
-					DoWrite(m_pCurrentBuffer);
-				}
+				m_pCurrentBuffer = m_vFreeBuffers.back();
+				m_vFreeBuffers.pop_back();
 			}
 			else
-#endif
 			{
 				// single threaded mode
 				m_pCurrentBuffer->DoCompress();
+				m_nNumBlocks++;
 				DoWrite(m_pCurrentBuffer);
 			}
 		}
@@ -273,24 +436,127 @@ void LZFBufferedOutput<TFileP, TEngine, BufferSize>::Write(const void* pBuffer,
 template <class TFileP, class TEngine, unsigned BufferSize>
 LZFBufferedOutput<TFileP, TEngine, BufferSize>::~LZFBufferedOutput()
 {
-	FlushBuffer();
+	// the owner should have already called FlushBuffer so it could see any errors.
+	// We can't throw from here, and we have to stop the threads either way
+	try
+	{
+		FlushBuffer();
+	}
+	catch (...)
+	{
+	}
+	StopThreads();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// LZFFileHasGet
+// A file that can hand back a pointer to its next N bytes (like File_Mapped or BlobDataRead)
+// lets LZFBufferedInput work on blocks in place rather than reading them into its own buffer first
+template <class TFileP, class = void>
+struct LZFFileHasGet : std::false_type
+{
+};
+template <class TFileP>
+struct LZFFileHasGet<TFileP, std::void_t<decltype(std::declval<TFileP&>()->Get(0u))>> : std::true_type
+{
+};
+
+// LZFFileHasGetAt
+// A file that can read at a position without moving the file position, and from several threads at once
+// (like File_Mapped) lets LZFBufferedInput read ahead on a helper thread
+template <class TFileP, class = void>
+struct LZFFileHasGetAt : std::false_type
+{
+};
+template <class TFileP>
+struct LZFFileHasGetAt<
+	TFileP,
+	std::void_t<decltype(std::declval<TFileP&>()->GetAt(
+		int64_t(0),
+		size_t(0),
+		std::declval<std::vector<unsigned char>&>()))>> : std::true_type
+{
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // class LZFBufferedInput
 // TFileP is usually a SmartPointer to a file
+// BufferSize is only the default block size - it has to match what the file was written with.
 template <class TFileP, unsigned BufferSize = 0x40000>
 class LZFBufferedInput
 {
-	unsigned char m_pOutBuffer[BufferSize];
-	unsigned char m_pInBuffer[BufferSize];
+	const unsigned m_nBlockSize;
+	std::vector<unsigned char> m_vOutBuffer;
+	std::vector<unsigned char> m_vInBuffer;
 	unsigned nInBufferNext;
 	unsigned nInBufferSize;
 
+	// the current decompressed block.  Usually m_vOutBuffer, but an uncompressed block
+	// can be used straight from the file if the file supports Get
+	const unsigned char* m_pOut;
+
 	TFileP m_pFile;
+	const Codec& m_codec;
+
+	// see EnableReadAhead.  The helper thread reads and decompresses the blocks following m_nPos
+	// into m_qReady, and NextBlock takes them from there as long as the file is still where it expects.
+	struct ReadAhead
+	{
+		struct Block
+		{
+			std::vector<unsigned char> m_vData;
+			unsigned m_nSize = 0;
+			int64_t m_nEndPos = 0;
+			bool m_bEOF = false;
+			std::exception_ptr m_pError;
+			// the data is in here instead of m_vData when it came from, or went into, the block cache
+			BlockCache::T_Block m_pCached;
+		};
+
+		unsigned m_nMaxBlocks;
+		int64_t m_nEndPos;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_cvReady;
+		std::condition_variable m_cvSpace;
+		bool m_bStop = false;
+
+		// the file position of the next block the helper thread will read
+		int64_t m_nPos = 0;
+		// the file position of the next block NextBlock will get from m_qReady
+		int64_t m_nNextPos = -1;
+
+		std::deque<std::unique_ptr<Block>> m_qReady;
+		std::vector<std::unique_ptr<Block>> m_vFree;
+
+		// the block currently in m_pOut
+		std::unique_ptr<Block> m_pCurrent;
+	};
+	std::unique_ptr<ReadAhead> m_pReadAhead;
+
+	// see SetBlockCache.  m_pCachedBlock holds on to the block in m_pOut when it came from the cache
+	BlockCache* m_pBlockCache;
+	FileIdentity m_fileIdentity;
+	BlockCache::T_Block m_pCachedBlock;
+
+	// whether there is a block cache, and it hasn't been turned off with BlockCache::SetMaxBytes(0)
+	inline bool UsesBlockCache() const
+	{
+		return m_pBlockCache != NULL && m_pBlockCache->GetMaxBytes() != 0;
+	}
+
+	void ReadAheadThread();
+	void StartReadAhead(int64_t nPos);
+	void StopReadAhead();
+
+	// loads the next block into m_pOut.  Returns false at the end of the file
+	bool NextBlock();
+	bool NextReadAheadBlock();
 
 public:
-	LZFBufferedInput(TFileP pFile);
+	LZFBufferedInput(TFileP pFile, const Codec* pCodec = NULL, unsigned nBlockSize = BufferSize);
+	~LZFBufferedInput();
 	void Reset()
 	{
 		nInBufferSize = 0;
@@ -298,84 +564,518 @@ public:
 	}
 	unsigned Read(void* pBuffer, unsigned nSize);
 
+	// like Read, but throws the data away.  Only the blocks it lands in are decompressed
+	unsigned Skip(unsigned nSize);
+
+	// starts a helper thread that reads and decompresses up to nMaxBlocks blocks ahead of where Read is,
+	// so the I/O and decompression overlap with whatever the caller is doing with the data.
+	// It never reads at or past nEndPos, which should be the end of the compressed data.
+	// Any errors it hits are only thrown if Read actually gets that far.
+	// Seeking the file (and calling Reset) still works, it just restarts the read ahead.
+	// nMaxBlocks == 0 turns it back off.  The file has to support GetAt, and be at the start of a block
+	// since this does a Reset.
+	void EnableReadAhead(unsigned nMaxBlocks, int64_t nEndPos);
+
+	// shares the decompressed blocks through pCache with every other LZFBufferedInput using it (and
+	// LZFDecompressBlocks), so a block that any of them has decompressed recently is just looked up.
+	// fileIdentity has to identify the file.  The read ahead uses it too.  NULL turns it back off.
+	// The file has to support GetAt.
+	void SetBlockCache(BlockCache* pCache, const FileIdentity& fileIdentity);
+
 	TFileP GetFile()
 	{
 		return m_pFile;
 	}
 };
 template <class TFileP, unsigned BufferSize>
-LZFBufferedInput<TFileP, BufferSize>::LZFBufferedInput(TFileP pFile)
-	: nInBufferNext(0)
+LZFBufferedInput<TFileP, BufferSize>::LZFBufferedInput(
+	TFileP pFile,
+	const Codec* pCodec /*= NULL*/,
+	unsigned nBlockSize /*= BufferSize*/)
+	: m_nBlockSize(nBlockSize)
+	, m_vOutBuffer(nBlockSize)
+	, nInBufferNext(0)
 	, nInBufferSize(0)
+	, m_pOut(m_vOutBuffer.data())
+	, m_codec(GetLZFBufferedCodec(pCodec))
+	, m_pBlockCache(NULL)
 {
 	m_pFile = pFile;
+
+	// a file with Get hands us the compressed data in place
+	if constexpr (!LZFFileHasGet<TFileP>::value)
+		m_vInBuffer.resize(nBlockSize);
 }
 
 template <class TFileP, unsigned BufferSize>
-unsigned LZFBufferedInput<TFileP, BufferSize>::Read(void* pBuffer, unsigned nSize)
+LZFBufferedInput<TFileP, BufferSize>::~LZFBufferedInput()
 {
-	unsigned nRet = nSize;
-	while (nSize > 0)
+	StopReadAhead();
+}
+
+template <class TFileP, unsigned BufferSize>
+void LZFBufferedInput<TFileP, BufferSize>::EnableReadAhead(unsigned nMaxBlocks, int64_t nEndPos)
+{
+	if constexpr (!LZFFileHasGetAt<TFileP>::value)
+		throw Error(XMSG("Internal Error in LZFBufferedInput::EnableReadAhead: The file does not support GetAt"));
+
+	StopReadAhead();
+	m_pReadAhead.reset();
+	Reset();
+	if (nMaxBlocks == 0)
+		return;
+
+	m_pReadAhead = std::make_unique<ReadAhead>();
+	m_pReadAhead->m_nMaxBlocks = nMaxBlocks;
+	m_pReadAhead->m_nEndPos = nEndPos;
+}
+
+template <class TFileP, unsigned BufferSize>
+void LZFBufferedInput<TFileP, BufferSize>::SetBlockCache(BlockCache* pCache, const FileIdentity& fileIdentity)
+{
+	if constexpr (!LZFFileHasGetAt<TFileP>::value)
+		throw Error(XMSG("Internal Error in LZFBufferedInput::SetBlockCache: The file does not support GetAt"));
+
+	// the read ahead thread uses them, and restarts on the next Read
+	StopReadAhead();
+	m_pBlockCache = pCache;
+	m_fileIdentity = fileIdentity;
+}
+
+template <class TFileP, unsigned BufferSize>
+void LZFBufferedInput<TFileP, BufferSize>::StopReadAhead()
+{
+	if (!m_pReadAhead || !m_pReadAhead->m_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_pReadAhead->m_mutex);
+		m_pReadAhead->m_bStop = true;
+	}
+	m_pReadAhead->m_cvSpace.notify_all();
+	m_pReadAhead->m_thread.join();
+
+	while (!m_pReadAhead->m_qReady.empty())
+	{
+		m_pReadAhead->m_vFree.push_back(std::move(m_pReadAhead->m_qReady.front()));
+		m_pReadAhead->m_qReady.pop_front();
+	}
+	m_pReadAhead->m_bStop = false;
+	m_pReadAhead->m_nNextPos = -1;
+}
+
+template <class TFileP, unsigned BufferSize>
+void LZFBufferedInput<TFileP, BufferSize>::StartReadAhead(int64_t nPos)
+{
+	StopReadAhead();
+	m_pReadAhead->m_nPos = nPos;
+	m_pReadAhead->m_nNextPos = nPos;
+	m_pReadAhead->m_thread = std::thread(&LZFBufferedInput::ReadAheadThread, this);
+}
+
+template <class TFileP, unsigned BufferSize>
+void LZFBufferedInput<TFileP, BufferSize>::ReadAheadThread()
+{
+	if constexpr (LZFFileHasGetAt<TFileP>::value)
 	{
-		if (nInBufferSize <= nInBufferNext)
+		ReadAhead& readAhead = *m_pReadAhead;
+		std::vector<unsigned char> vScratch;
+		for (;;)
 		{
-			unsigned nResultBytes = 0;
-			bool bUncompressed = false;
-			if (BufferSize <= 0x7fff)
+			std::unique_ptr<typename ReadAhead::Block> pBlock;
+			int64_t nPos;
 			{
-				unsigned short snResultBytes = static_cast<unsigned short>(nResultBytes);
-				unsigned nBytesRead = m_pFile->Read(&snResultBytes, sizeof(snResultBytes));
-				if (nBytesRead == 0)
-					return nRet - nSize;  // EOF
-				if (sizeof(snResultBytes) != nBytesRead)
-					throw Error(XMSG("Internal Error in LZFBufferedInput::Read"));
-				if (snResultBytes & 0x8000)
+				std::unique_lock<std::mutex> lock(readAhead.m_mutex);
+				readAhead.m_cvSpace.wait(
+					lock, [&] { return readAhead.m_bStop || readAhead.m_qReady.size() < readAhead.m_nMaxBlocks; });
+				if (readAhead.m_bStop)
+					return;
+
+				if (readAhead.m_vFree.empty())
+					pBlock = std::make_unique<typename ReadAhead::Block>();
+				else
 				{
-					snResultBytes &= 0x7fff;
-					bUncompressed = true;
+					pBlock = std::move(readAhead.m_vFree.back());
+					readAhead.m_vFree.pop_back();
 				}
-				nResultBytes = snResultBytes;
+				nPos = readAhead.m_nPos;
 			}
-			else
+
+			pBlock->m_bEOF = false;
+			pBlock->m_pError = nullptr;
+			pBlock->m_nEndPos = nPos;
+			pBlock->m_pCached.reset();
+			const bool bUseCache = UsesBlockCache();
+			try
 			{
-				m_pFile->Read(&nResultBytes, sizeof(nResultBytes));
-				if (nResultBytes & 0x80000000)
+				// the same layout NextBlock reads
+				const unsigned nHeaderSize = LZFBlockHeaderSize(m_nBlockSize);
+				if (bUseCache && nPos + nHeaderSize <= readAhead.m_nEndPos)
+					pBlock->m_pCached = m_pBlockCache->Find(m_fileIdentity, nPos);
+
+				if (nPos + nHeaderSize > readAhead.m_nEndPos)
+					pBlock->m_bEOF = true;
+				else if (pBlock->m_pCached)
+				{
+					pBlock->m_nSize = unsigned(pBlock->m_pCached->m_vData.size());
+					pBlock->m_nEndPos = pBlock->m_pCached->m_nEndPos;
+				}
+				else
 				{
-					nResultBytes &= 0x7fffffff;
-					bUncompressed = true;
+					unsigned nResultBytes = 0;
+					memcpy(&nResultBytes, m_pFile->GetAt(nPos, nHeaderSize, vScratch), nHeaderSize);
+					const unsigned nUncompressedFlag = LZFShortBlockHeader(m_nBlockSize) ? 0x8000 : 0x80000000;
+					bool bUncompressed = (nResultBytes & nUncompressedFlag) != 0;
+					nResultBytes &= ~nUncompressedFlag;
+					if (nResultBytes > m_nBlockSize)
+						throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Corrupt file"));
+
+					const void* pIn = m_pFile->GetAt(nPos + nHeaderSize, nResultBytes, vScratch);
+					if (pBlock->m_vData.size() < m_nBlockSize)
+						pBlock->m_vData.resize(m_nBlockSize);
+					if (bUncompressed)
+					{
+						memcpy(pBlock->m_vData.data(), pIn, nResultBytes);
+						pBlock->m_nSize = nResultBytes;
+					}
+					else if (bUseCache)
+					{
+						// as in NextBlock, decompress it straight into a block the cache can keep
+						std::shared_ptr<BlockCache::Block> pCacheBlock = std::make_shared<BlockCache::Block>();
+						pCacheBlock->m_vData.resize(m_nBlockSize);
+						pBlock->m_nSize =
+							m_codec.Decompress(pIn, nResultBytes, pCacheBlock->m_vData.data(), m_nBlockSize);
+						if (pBlock->m_nSize == 0)
+							pBlock->m_bEOF = true;
+						else
+						{
+							pCacheBlock->m_vData.resize(pBlock->m_nSize);
+							pCacheBlock->m_nEndPos = nPos + nHeaderSize + nResultBytes;
+							pBlock->m_pCached = m_pBlockCache->Insert(m_fileIdentity, nPos, std::move(pCacheBlock));
+						}
+					}
+					else
+					{
+						pBlock->m_nSize =
+							m_codec.Decompress(pIn, nResultBytes, pBlock->m_vData.data(), m_nBlockSize);
+						if (pBlock->m_nSize == 0)
+							pBlock->m_bEOF = true;
+					}
+					pBlock->m_nEndPos = nPos + nHeaderSize + nResultBytes;
 				}
 			}
+			catch (...)
+			{
+				pBlock->m_pError = std::current_exception();
+			}
 
-			if (bUncompressed)
+			bool bDone = pBlock->m_bEOF || pBlock->m_pError;
 			{
-				nInBufferSize = nResultBytes;
-				if (nInBufferSize > sizeof(m_pOutBuffer))
-				{
-					assert(false);
-					throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Corrupt file"));
-				}
+				std::lock_guard<std::mutex> lock(readAhead.m_mutex);
+				readAhead.m_nPos = pBlock->m_nEndPos;
+				readAhead.m_qReady.push_back(std::move(pBlock));
+			}
+			readAhead.m_cvReady.notify_one();
 
-				if (nInBufferSize != m_pFile->Read(m_pOutBuffer, nInBufferSize))
-					throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Not enough bytes read"));
+			// there is nothing more to read, but wait around to be stopped so StopReadAhead is the same either way
+			if (bDone)
+			{
+				std::unique_lock<std::mutex> lock(readAhead.m_mutex);
+				readAhead.m_cvSpace.wait(lock, [&] { return readAhead.m_bStop; });
+				return;
 			}
-			else
+		}
+	}
+}
+
+template <class TFileP, unsigned BufferSize>
+bool LZFBufferedInput<TFileP, BufferSize>::NextReadAheadBlock()
+{
+	if constexpr (!LZFFileHasGetAt<TFileP>::value)
+		return false;
+	else
+	{
+		ReadAhead& readAhead = *m_pReadAhead;
+
+		// if the file has been moved since the last block, start over from wherever it is now
+		int64_t nPos = m_pFile->Tell();
+		if (nPos != readAhead.m_nNextPos)
+			StartReadAhead(nPos);
+
+		std::unique_ptr<typename ReadAhead::Block> pBlock;
+		{
+			std::unique_lock<std::mutex> lock(readAhead.m_mutex);
+			readAhead.m_cvReady.wait(lock, [&] { return !readAhead.m_qReady.empty(); });
+			if (readAhead.m_qReady.front()->m_bEOF || readAhead.m_qReady.front()->m_pError)
+			{
+				// leave it in the queue so we hit it again on the next call
+				if (readAhead.m_qReady.front()->m_pError)
+					std::rethrow_exception(readAhead.m_qReady.front()->m_pError);
+				return false;
+			}
+			pBlock = std::move(readAhead.m_qReady.front());
+			readAhead.m_qReady.pop_front();
+			if (readAhead.m_pCurrent)
+				readAhead.m_vFree.push_back(std::move(readAhead.m_pCurrent));
+		}
+		readAhead.m_cvSpace.notify_one();
+
+		// keep the file where it would have been without the read ahead
+		m_pFile->LSeek(pBlock->m_nEndPos);
+		readAhead.m_nNextPos = pBlock->m_nEndPos;
+
+		m_pOut = pBlock->m_pCached ? pBlock->m_pCached->m_vData.data() : pBlock->m_vData.data();
+		nInBufferSize = pBlock->m_nSize;
+		nInBufferNext = 0;
+		readAhead.m_pCurrent = std::move(pBlock);
+		return true;
+	}
+}
+
+template <class TFileP, unsigned BufferSize>
+bool LZFBufferedInput<TFileP, BufferSize>::NextBlock()
+{
+	if (m_pReadAhead)
+		return NextReadAheadBlock();
+
+	// decided once, so a block isn't looked up in one place and added under another
+	int64_t nBlockPos = 0;
+	bool bUseCache = false;
+	if constexpr (LZFFileHasGetAt<TFileP>::value)
+	{
+		bUseCache = UsesBlockCache();
+		if (bUseCache)
+		{
+			nBlockPos = m_pFile->Tell();
+			m_pCachedBlock = m_pBlockCache->Find(m_fileIdentity, nBlockPos);
+			if (m_pCachedBlock)
 			{
-				size_t nBytesRead = m_pFile->Read(m_pInBuffer, nResultBytes);
-				nInBufferSize = LzfWrapper::lzf_decompress(
-					m_pInBuffer, unsigned(nBytesRead), m_pOutBuffer, unsigned(sizeof(m_pOutBuffer)));
+				// skip the file over it as if it had been read
+				m_pFile->LSeek(m_pCachedBlock->m_nEndPos);
+				m_pOut = m_pCachedBlock->m_vData.data();
+				nInBufferSize = unsigned(m_pCachedBlock->m_vData.size());
+				nInBufferNext = 0;
+				return true;
+			}
+		}
+	}
+
+	unsigned nResultBytes = 0;
+	bool bUncompressed = false;
+	if (LZFShortBlockHeader(m_nBlockSize))
+	{
+		unsigned short snResultBytes = static_cast<unsigned short>(nResultBytes);
+		unsigned nBytesRead = m_pFile->Read(&snResultBytes, sizeof(snResultBytes));
+		if (nBytesRead == 0)
+			return false;  // EOF
+		if (sizeof(snResultBytes) != nBytesRead)
+			throw Error(XMSG("Internal Error in LZFBufferedInput::Read"));
+		if (snResultBytes & 0x8000)
+		{
+			snResultBytes &= 0x7fff;
+			bUncompressed = true;
+		}
+		nResultBytes = snResultBytes;
+	}
+	else
+	{
+		m_pFile->Read(&nResultBytes, sizeof(nResultBytes));
+		if (nResultBytes & 0x80000000)
+		{
+			nResultBytes &= 0x7fffffff;
+			bUncompressed = true;
+		}
+	}
+
+	if (bUncompressed)
+	{
+		nInBufferSize = nResultBytes;
+		if (nInBufferSize > m_nBlockSize)
+		{
+			assert(false);
+			throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Corrupt file"));
+		}
+
+		if constexpr (LZFFileHasGet<TFileP>::value)
+			m_pOut = static_cast<const unsigned char*>(m_pFile->Get(nInBufferSize));
+		else
+		{
+			if (nInBufferSize != m_pFile->Read(m_vOutBuffer.data(), nInBufferSize))
+				throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Not enough bytes read"));
+			m_pOut = m_vOutBuffer.data();
+		}
+	}
+	else
+	{
+		const void* pIn;
+		size_t nBytesRead;
+		if constexpr (LZFFileHasGet<TFileP>::value)
+		{
+			pIn = m_pFile->Get(nResultBytes);
+			nBytesRead = nResultBytes;
+		}
+		else
+		{
+			if (nResultBytes > m_nBlockSize)
+				throw Error(XMSG("Internal Error in LZFBufferedInput::Read: Corrupt file"));
+			nBytesRead = m_pFile->Read(m_vInBuffer.data(), nResultBytes);
+			pIn = m_vInBuffer.data();
+		}
+		if constexpr (LZFFileHasGetAt<TFileP>::value)
+		{
+			if (bUseCache)
+			{
+				// decompress it straight into a block the cache can keep.  Only the compressed blocks are cached,
+				// since the uncompressed ones aren't any work to read
+				std::shared_ptr<BlockCache::Block> pBlock = std::make_shared<BlockCache::Block>();
+				pBlock->m_vData.resize(m_nBlockSize);
+				nInBufferSize = m_codec.Decompress(pIn, unsigned(nBytesRead), pBlock->m_vData.data(), m_nBlockSize);
 				if (nInBufferSize == 0)
-					return 0;  // EOF - may get in infinite loop
+					return false;  // EOF
+				pBlock->m_vData.resize(nInBufferSize);
+				pBlock->m_nEndPos = m_pFile->Tell();
+				m_pCachedBlock = m_pBlockCache->Insert(m_fileIdentity, nBlockPos, std::move(pBlock));
+				m_pOut = m_pCachedBlock->m_vData.data();
+				nInBufferNext = 0;
+				return true;
 			}
-			nInBufferNext = 0;
 		}
+
+		nInBufferSize = m_codec.Decompress(pIn, unsigned(nBytesRead), m_vOutBuffer.data(), m_nBlockSize);
+		m_pOut = m_vOutBuffer.data();
+		if (nInBufferSize == 0)
+			return false;  // EOF - may get in infinite loop
+	}
+	nInBufferNext = 0;
+	return true;
+}
+
+template <class TFileP, unsigned BufferSize>
+unsigned LZFBufferedInput<TFileP, BufferSize>::Read(void* pBuffer, unsigned nSize)
+{
+	unsigned nRet = nSize;
+	while (nSize > 0)
+	{
+		if (nInBufferSize <= nInBufferNext && !NextBlock())
+			return nRet - nSize;
+
 		unsigned nCopySize = std::min(unsigned(nInBufferSize - nInBufferNext), nSize);
-		memcpy(pBuffer, m_pOutBuffer + nInBufferNext, nCopySize);
+		memcpy(pBuffer, m_pOut + nInBufferNext, nCopySize);
 		nInBufferNext += nCopySize;
 		nSize -= nCopySize;
 		pBuffer = ((char*)pBuffer) + nCopySize;
 	}
 	return nRet;
 }
+
+template <class TFileP, unsigned BufferSize>
+unsigned LZFBufferedInput<TFileP, BufferSize>::Skip(unsigned nSize)
+{
+	unsigned nRet = nSize;
+	while (nSize > 0)
+	{
+		if (nInBufferSize <= nInBufferNext && !NextBlock())
+			return nRet - nSize;
+
+		unsigned nSkipSize = std::min(unsigned(nInBufferSize - nInBufferNext), nSize);
+		nInBufferNext += nSkipSize;
+		nSize -= nSkipSize;
+	}
+	return nRet;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// LZFDecompressBlocks
+// Decompresses a run of whole blocks, as written by LZFBufferedOutput, in one go.
+// The output is appended to vOut starting at nOutSize, and nOutSize is moved to the new end.
+// vOut is grown as needed but never shrunk so it can be reused without reallocating.
+// If pCache is given, pIn is what is at nFilePos in the file fileIdentity identifies, and the compressed blocks are
+// looked up in and added to pCache the same way LZFBufferedInput::SetBlockCache does.
+template <unsigned BufferSize = 0x40000>
+void LZFDecompressBlocks(
+	const void* pIn,
+	size_t nInSize,
+	std::vector<unsigned char>& vOut,
+	size_t& nOutSize,
+	const Codec* pCodec = NULL,
+	unsigned nBlockSize = BufferSize,
+	BlockCache* pCache = NULL,
+	const FileIdentity& fileIdentity = FileIdentity(),
+	int64_t nFilePos = 0)
+{
+	const Codec& codec = GetLZFBufferedCodec(pCodec);
+	const bool bUseCache = pCache != NULL && pCache->GetMaxBytes() != 0;
+	const unsigned char* const pStart = static_cast<const unsigned char*>(pIn);
+	const unsigned char* p = pStart;
+	const unsigned char* pEnd = p + nInSize;
+	while (p < pEnd)
+	{
+		const int64_t nBlockPos = nFilePos + (p - pStart);
+		if (bUseCache)
+		{
+			if (BlockCache::T_Block pCached = pCache->Find(fileIdentity, nBlockPos))
+			{
+				const int64_t nNext = pCached->m_nEndPos - nFilePos;
+				if (nNext <= p - pStart || nNext > int64_t(nInSize))
+					throw Error(XMSG("Internal Error in LZFDecompressBlocks: Corrupt file"));
+				if (vOut.size() < nOutSize + pCached->m_vData.size())
+					vOut.resize(std::max(nOutSize + nBlockSize, vOut.size() * 2));
+				memcpy(vOut.data() + nOutSize, pCached->m_vData.data(), pCached->m_vData.size());
+				nOutSize += pCached->m_vData.size();
+				p = pStart + nNext;
+				continue;
+			}
+		}
+
+		unsigned nResultBytes = 0;
+		bool bUncompressed = false;
+		if (LZFShortBlockHeader(nBlockSize))
+		{
+			unsigned short snResultBytes;
+			if (size_t(pEnd - p) < sizeof(snResultBytes))
+				throw Error(XMSG("Internal Error in LZFDecompressBlocks: Corrupt file"));
+			memcpy(&snResultBytes, p, sizeof(snResultBytes));
+			p += sizeof(snResultBytes);
+			bUncompressed = (snResultBytes & 0x8000) != 0;
+			nResultBytes = snResultBytes & 0x7fff;
+		}
+		else
+		{
+			if (size_t(pEnd - p) < sizeof(nResultBytes))
+				throw Error(XMSG("Internal Error in LZFDecompressBlocks: Corrupt file"));
+			memcpy(&nResultBytes, p, sizeof(nResultBytes));
+			p += sizeof(nResultBytes);
+			bUncompressed = (nResultBytes & 0x80000000) != 0;
+			nResultBytes &= 0x7fffffff;
+		}
+		if (nResultBytes > nBlockSize || nResultBytes > size_t(pEnd - p))
+			throw Error(XMSG("Internal Error in LZFDecompressBlocks: Corrupt file"));
+
+		if (vOut.size() < nOutSize + nBlockSize)
+			vOut.resize(std::max(nOutSize + nBlockSize, vOut.size() * 2));
+
+		if (bUncompressed)
+		{
+			memcpy(vOut.data() + nOutSize, p, nResultBytes);
+			nOutSize += nResultBytes;
+		}
+		else
+		{
+			unsigned nDecompressed = codec.Decompress(p, nResultBytes, vOut.data() + nOutSize, nBlockSize);
+			if (nDecompressed == 0)
+				throw Error(XMSG("Internal Error in LZFDecompressBlocks: Corrupt file"));
+			if (bUseCache)
+			{
+				std::shared_ptr<BlockCache::Block> pBlock = std::make_shared<BlockCache::Block>();
+				pBlock->m_vData.assign(vOut.data() + nOutSize, vOut.data() + nOutSize + nDecompressed);
+				pBlock->m_nEndPos = nFilePos + (p + nResultBytes - pStart);
+				pCache->Insert(fileIdentity, nBlockPos, std::move(pBlock));
+			}
+			nOutSize += nDecompressed;
+		}
+		p += nResultBytes;
+	}
+}
 }  // namespace SRC
 
 #ifndef __GNUC__
@@ -10,11 +10,18 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <ctime>
+#include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "Base/lzf_src.h"
 #include "RecordLib/RecordInfo.h"
+#include "RecordLib/RecordPredicate.h"
 
 #if defined(__linux__) || defined(BUILDING_OPEN_ALTERYX)
 	#define OPEN_ALTERYX_EXPORT
@@ -32,9 +39,17 @@ using namespace SRC;
 //
 class OPEN_ALTERYX_EXPORT File_Large
 {
+	friend class File_Mapped;
+
 	WString m_strFile;
 	int m_iFileDescriptor;
 
+#ifndef __GNUG__
+	// there is no pread for CRT file descriptors, and ReadFile moves the file position of a handle that isn't
+	// overlapped even when it is given an offset, so ReadAt reads through a second, overlapped handle to the file
+	void* m_hReadAt;
+#endif
+
 public:
 	File_Large();
 	~File_Large();
@@ -58,11 +73,84 @@ public:
 
 	unsigned Read(void* _pBuffer, unsigned nNumBytesToRead);
 
+	// reads from nPos without moving the file position.  Safe to call from several threads at once.
+	void ReadAt(int64_t nPos, void* _pBuffer, size_t nNumBytesToRead) const;
+
+	// the device, inode, modification time and size of the open file.  See BlockCache
+	FileIdentity GetIdentity() const;
+
 	unsigned Write(const void* _pBuffer, unsigned nNumBytesToWrite);
 
 	static void GetAndThrowError(WString strErrorIntro);
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// class File_Mapped
+//
+// A read only alternative to File_Large that maps the whole file into memory.
+// Read is a memcpy out of the mapping and Get returns a pointer straight into it, which
+// lets LZFBufferedInput decompress a block without a syscall or an extra copy.
+// If the file can't be mapped (no address space on a 32 bit build, an empty file, etc...)
+// it falls back to reading through a File_Large, so callers don't need to care.
+//
+// Like any mapping, if another process truncates the file while it is open the reader can fault.
+class OPEN_ALTERYX_EXPORT File_Mapped
+{
+	File_Large m_file;
+
+	const unsigned char* m_pData;
+	int64_t m_nSize;
+	int64_t m_nPos;
+
+#ifndef __GNUG__
+	void* m_hMapping;
+#endif
+
+	// backs Get when the file isn't mapped
+	std::vector<unsigned char> m_vGetBuffer;
+
+	void Unmap();
+
+public:
+	File_Mapped();
+	~File_Mapped();
+	void Close();
+
+	// if bMemoryMap is false (or the mapping fails) this behaves just like File_Large
+	void OpenForRead(WString strFile, bool bMemoryMap = true);
+
+	inline WString GetFileName() const
+	{
+		return m_file.GetFileName();
+	}
+	inline bool IsOpen() const
+	{
+		return m_file.IsOpen();
+	}
+	inline bool IsMapped() const
+	{
+		return m_pData != nullptr;
+	}
+	inline FileIdentity GetIdentity() const
+	{
+		return m_file.GetIdentity();
+	}
+
+	int64_t Tell() const;
+
+	void LSeek(int64_t nPos);
+
+	unsigned Read(void* _pBuffer, unsigned nNumBytesToRead);
+
+	// returns a pointer to the next nNumBytes of the file and advances past them.
+	// The pointer is good until the next call to Get, or the file is closed.
+	const void* Get(unsigned nNumBytes);
+
+	// returns a pointer to nNumBytes of the file at nPos without moving the file position.
+	// If the file isn't mapped the bytes are read into vBuffer.  Safe to call from several threads at once.
+	const void* GetAt(int64_t nPos, size_t nNumBytes, std::vector<unsigned char>& vBuffer) const;
+};
+
 const int RecordsPerBlock = 0x10000;
 const int32_t ID_WRIGLEYDB = 0x00440205;
 const int32_t ID_WRIGLEYDB_NoSpatialIndex = 0x00440204;
@@ -87,11 +175,66 @@ struct OPEN_ALTERYX_EXPORT HeaderData
 	int nCompressionVersion;
 };
 
+const uint32_t HeaderExtensionMagic = 0x4558594f;  // "OYXE"
+const uint32_t HeaderExtensionVersion = 5;
+
+// the size of the uncompressed LZF blocks the records are written in.  Alteryx itself can only read files
+// that use the default.
+const unsigned DefaultLzfBlockSize = 0x40000;
+const unsigned MinLzfBlockSize = 0x10000;
+const unsigned MaxLzfBlockSize = 0x1000000;
+
+// Our own additions to the format live in what used to be the unused space at the end of the header.
+// Other readers ignore it, and it is all 0's in files that don't have it.
+struct OPEN_ALTERYX_EXPORT HeaderExtension
+{
+	uint32_t nMagic;
+	uint32_t nVersion;
+
+	// the # of records between the entries of the dense record index, or 0 if there isn't one.
+	// The dense index is laid out like the record block index: an unsigned count and then that many int64 file positions
+	uint32_t nDenseIndexInterval;
+	uint32_t nReserved;
+	int64_t nDenseIndexPos;
+
+	// version 2
+	// the # of records between the entries of the record offset index, or 0 if there isn't one.
+	// It is an unsigned count and then that many RecordOffsetIndexEntry's
+	uint32_t nRecordOffsetIndexInterval;
+	uint32_t nReserved2;
+	int64_t nRecordOffsetIndexPos;
+
+	// version 3
+	// the LZF block size the records were written with, or 0 for DefaultLzfBlockSize
+	uint32_t nLzfBlockSize;
+	uint32_t nReserved3;
+
+	// version 4
+	// the spatial index written by SetSpatialIndex, or a 0 nSpatialIndexPos if there isn't one.  This is our own
+	// index, not Alteryx's, so the file is still ID_WRIGLEYDB_NoSpatialIndex and userHdr.nSpatialIndexPos stays 0.
+	// It is an int64 count and then that many SpatialIndex::Box's, one for each record in order
+	uint32_t nSpatialIndexField;
+	uint32_t nReserved4;
+	int64_t nSpatialIndexPos;
+
+	// version 5
+	// the record block statistics written by SetZoneMaps, or 0 if there aren't any.  They are an unsigned field count,
+	// an unsigned record block count, that many unsigned field #'s and then a ZoneMapStats for each of those fields
+	// for each block, block by block
+	int64_t nZoneMapPos;
+
+	inline bool IsValid() const
+	{
+		return nMagic == HeaderExtensionMagic && nVersion >= 1;
+	}
+};
+
 struct OPEN_ALTERYX_EXPORT Header : public FileHeaderStruct
 {
 	HeaderData userHdr;
+	HeaderExtension extHdr;
 
-	char bitBucket[HeaderPageSize - sizeof(FileHeaderStruct) - sizeof(HeaderData)];
+	char bitBucket[HeaderPageSize - sizeof(FileHeaderStruct) - sizeof(HeaderData) - sizeof(HeaderExtension)];
 
 	inline Header()
 	{
@@ -147,11 +290,308 @@ protected:
 	}
 };
 
+static_assert(sizeof(Header) == HeaderPageSize, "The header must be exactly 1 page");
+
+// where a record starts in the compressed stream, without having to flush the compression there.
+// nLzfBlockPos is the file position of the LZF block it is in, and nOffset is how far into the decompressed block
+struct OPEN_ALTERYX_EXPORT RecordOffsetIndexEntry
+{
+	int64_t nLzfBlockPos;
+	uint32_t nOffset;
+	uint32_t nReserved;
+};
+static_assert(sizeof(RecordOffsetIndexEntry) == 16, "RecordOffsetIndexEntry is part of the file format");
+
+///////////////////////////////////////////////////////////////////////////////
+// struct RecordBlock
+//
+// One record block (up to RecordsPerBlock records) decompressed into memory.
+// The records sit back to back in m_vData exactly as RecordInfo::Write wrote them,
+// so m_vRecords points straight into it and nothing is copied.
+struct OPEN_ALTERYX_EXPORT RecordBlock
+{
+	unsigned m_nBlock = 0;
+	int64_t m_nFirstRecord = 0;
+	std::vector<const RecordData*> m_vRecords;
+
+	// m_vData is only ever grown so a RecordBlock can be reused, m_nDataSize is how much of it is in use
+	std::vector<unsigned char> m_vData;
+	size_t m_nDataSize = 0;
+
+	// the scans that take a RecordPredicate leave the indexes into m_vRecords of the records that match here
+	std::vector<uint32_t> m_vSelection;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct ProjectedColumn
+//
+// The values of one field for every record in a block.
+// Bool, Byte, Int16, Int32, Int64, Float and Double come back as a packed array of their native type
+// (bool as 1 byte 0 or 1) in m_vValues - use GetValues.  Null values are 0.
+// Everything else comes back as bytes: record x is m_vBytes[m_vOffsets[x]] to m_vBytes[m_vOffsets[x+1]].
+// That is the raw var data for V_String, V_WString, Blob and SpatialObj, and the value up to its terminator for
+// the fixed width String, WString, Date, Time, DateTime and FixedDecimal.  The wide strings are UTF-16.
+struct OPEN_ALTERYX_EXPORT ProjectedColumn
+{
+	unsigned m_nField = 0;
+	E_FieldType m_ft = E_FT_Unknown;
+	bool m_bIsBytes = false;
+
+	// 1 for each null value
+	std::vector<unsigned char> m_vNulls;
+
+	std::vector<unsigned char> m_vValues;
+
+	std::vector<size_t> m_vOffsets;
+	std::vector<unsigned char> m_vBytes;
+
+	template <class T>
+	inline const T* GetValues() const
+	{
+		return reinterpret_cast<const T*>(m_vValues.data());
+	}
+	inline bool GetNull(size_t nRecord) const
+	{
+		return m_vNulls[nRecord] != 0;
+	}
+	inline BlobVal GetBytes(size_t nRecord) const
+	{
+		return BlobVal(unsigned(m_vOffsets[nRecord + 1] - m_vOffsets[nRecord]), m_vBytes.data() + m_vOffsets[nRecord]);
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct ProjectedBlock
+//
+// The projected fields of one record block, in the order they were given to SetProjection.
+// A ProjectedBlock can be reused for the next block without reallocating.
+struct OPEN_ALTERYX_EXPORT ProjectedBlock
+{
+	unsigned m_nBlock = 0;
+	int64_t m_nFirstRecord = 0;
+	unsigned m_nNumRecords = 0;
+	std::vector<ProjectedColumn> m_vColumns;
+
+	// the decompressed block the columns are built from
+	RecordBlock m_recordBlock;
+	std::vector<unsigned char> m_vScratch;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct SpatialBoundingBox
+//
+// An axis aligned box in the coordinates of the spatial objects.  An empty box (such as a null
+// spatial object has) doesn't intersect anything.
+struct OPEN_ALTERYX_EXPORT SpatialBoundingBox
+{
+	double m_dMinX;
+	double m_dMinY;
+	double m_dMaxX;
+	double m_dMaxY;
+
+	SpatialBoundingBox();
+	SpatialBoundingBox(double dMinX, double dMinY, double dMaxX, double dMaxY);
+
+	inline bool IsEmpty() const
+	{
+		return !(m_dMinX <= m_dMaxX && m_dMinY <= m_dMaxY);
+	}
+	inline bool Intersects(const SpatialBoundingBox& o) const
+	{
+		return m_dMinX <= o.m_dMaxX && o.m_dMinX <= m_dMaxX && m_dMinY <= o.m_dMaxY && o.m_dMinY <= m_dMaxY;
+	}
+	void Extend(const SpatialBoundingBox& o);
+
+	// the bounding box of a spatial object as Alteryx stores it - an SHP shape record.
+	// Null shapes and anything that isn't recognised come back empty.
+	static SpatialBoundingBox FromShpBlob(const void* pBlob, size_t nLength);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class SpatialIndex
+//
+// The bounding box of one spatial field for every record, and of every GroupSize records, so a
+// bounding box query only has to look at the records in the groups that intersect it.
+// The boxes are kept as floats rounded outwards, so a query can return a few records that only
+// just miss it, but never misses one.
+class OPEN_ALTERYX_EXPORT SpatialIndex
+{
+public:
+	static const unsigned GroupSize = 256;
+
+	// this is also the file format - see HeaderExtension::nSpatialIndexPos
+	struct Box
+	{
+		float m_fMinX;
+		float m_fMinY;
+		float m_fMaxX;
+		float m_fMaxY;
+	};
+
+private:
+	std::vector<Box> m_vRecordBoxes;
+	std::vector<Box> m_vGroupBoxes;
+
+public:
+	void Clear();
+
+	// the number of records in the index, all of them empty
+	void Resize(int64_t nRecords);
+	void Set(int64_t nRecord, const SpatialBoundingBox& box);
+	void Append(const SpatialBoundingBox& box);
+	void Assign(std::vector<Box>&& vRecordBoxes);
+
+	inline const std::vector<Box>& GetRecordBoxes() const
+	{
+		return m_vRecordBoxes;
+	}
+
+	// works out the group boxes - call it once all the records are Set or Appended
+	void Finish();
+
+	inline int64_t GetNumRecords() const
+	{
+		return int64_t(m_vRecordBoxes.size());
+	}
+
+	// the record #'s whose box intersects box, in order
+	std::vector<int64_t> Query(const SpatialBoundingBox& box) const;
+
+	// the record blocks (see ReadRecordBlock) with at least 1 record whose box intersects box, in order
+	std::vector<unsigned> QueryBlocks(const SpatialBoundingBox& box) const;
+
+	// the union of all the records' boxes
+	SpatialBoundingBox GetExtent() const;
+};
+static_assert(sizeof(SpatialIndex::Box) == 16, "SpatialIndex::Box is part of the file format");
+
+///////////////////////////////////////////////////////////////////////////////
+// struct ZoneMapStats
+//
+// The statistics of one field in one record block.  See SetZoneMaps.
+// Only the fields with an ordered key have them: Bool, Byte, Int16, Int32 and Int64 are their own key,
+// Date, Time and DateTime are the number their digits make (so 2019-07-04 is 20190704 and
+// 2019-07-04 13:30:00 is 20190704133000), and Float, Double and FixedDecimal are doubles.
+// If none of the block's values are set (or they are all NaN), the min is more than the max.
+struct OPEN_ALTERYX_EXPORT ZoneMapStats
+{
+	// the doubles for Float, Double and FixedDecimal, the int64s for the rest
+	union
+	{
+		int64_t nMin;
+		double dMin;
+	};
+	union
+	{
+		int64_t nMax;
+		double dMax;
+	};
+	uint32_t nNullCount;
+
+	// an estimate, usually within 3 or 4%
+	uint32_t nDistinctCount;
+};
+static_assert(sizeof(ZoneMapStats) == 24, "ZoneMapStats is part of the file format");
+
+///////////////////////////////////////////////////////////////////////////////
+// class ScanPredicate
+//
+// Conditions on the fields of a record that all have to hold, for Open_AlteryxYXDB::Scan.
+// Ranges are on the keys described in ZoneMapStats and include both ends.  Null values are never
+// in a range.  It holds on to the fields of the RecordInfo, so that has to outlive it.
+//
+//		ScanPredicate predicate(file.m_recordInfo);
+//		predicate.AddDateTimeRange(nDateField, "2019-07-01", "2019-07-31").AddIntRange(nIdField, 1000, 1999);
+//		file.Scan(predicate, [&](unsigned nBlock, int64_t nRecord, const RecordData* pRec) { ... });
+class OPEN_ALTERYX_EXPORT ScanPredicate
+{
+public:
+	enum E_Op
+	{
+		E_Op_Range,
+		E_Op_IsNull,
+		E_Op_IsNotNull
+	};
+
+	struct Term
+	{
+		const FieldBase* m_pField;
+		unsigned m_nField;
+		E_Op m_eOp;
+		union
+		{
+			int64_t m_nMin;
+			double m_dMin;
+		};
+		union
+		{
+			int64_t m_nMax;
+			double m_dMax;
+		};
+	};
+
+private:
+	const RecordInfo* m_pRecordInfo;
+	std::vector<Term> m_vTerms;
+
+	Term& AddTerm(unsigned nField, E_Op eOp, bool bKeyed);
+
+public:
+	explicit ScanPredicate(const RecordInfo& recordInfo);
+
+	// throws if the field doesn't have a key.  An int range on a Float, Double or FixedDecimal field is
+	// turned into a double range and the other way around
+	ScanPredicate& AddIntRange(unsigned nField, int64_t nMin, int64_t nMax);
+	ScanPredicate& AddDoubleRange(unsigned nField, double dMin, double dMax);
+
+	// for Date, Time and DateTime fields.  Missing digits are filled in as the earliest time for pMin and the
+	// latest for pMax, so ("2019-07-01", "2019-07-31") on a DateTime field includes all of July 31st
+	ScanPredicate& AddDateTimeRange(unsigned nField, const char* pMin, const char* pMax);
+
+	// these work on any field
+	ScanPredicate& AddIsNull(unsigned nField);
+	ScanPredicate& AddIsNotNull(unsigned nField);
+
+	inline const std::vector<Term>& GetTerms() const
+	{
+		return m_vTerms;
+	}
+
+	bool Matches(const RecordData* pRec) const;
+
+	// false if the stats show that none of a block's nRecords records can match.  pStats has the stats
+	// of each term's field, or NULL for the ones that don't have any
+	bool MightMatch(const ZoneMapStats* const* ppStats, unsigned nRecords) const;
+
+	// whether a field type has a key, and whether it is a double
+	static bool HasKey(E_FieldType ft);
+	static bool HasDoubleKey(E_FieldType ft);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class RecordInfoCache
+//
+// The RecordInfo parsed from each distinct record info XML, so that opening many files with the same schema
+// (see Open_AlteryxYXDB::SetRecordInfoCache) only parses it once.  Thread safe.
+class OPEN_ALTERYX_EXPORT RecordInfoCache
+{
+	std::mutex m_mutex;
+	std::map<String, std::shared_ptr<const RecordInfo>> m_mapRecordInfos;
+
+public:
+	// parses strRecordInfoXml the first time it is seen
+	std::shared_ptr<const RecordInfo> Get(const String& strRecordInfoXml);
+
+	void Clear();
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Open_AlteryxYXDB
 class OPEN_ALTERYX_EXPORT Open_AlteryxYXDB
 {
+	// m_pFile is used when creating a file, m_pInFile when reading one
 	std::unique_ptr<File_Large> m_pFile;
+	std::unique_ptr<File_Mapped> m_pInFile;
 
 public:
 	RecordInfo m_recordInfo;
@@ -163,38 +603,513 @@ private:
 
 	void GoBlockRecord(int64_t nRecord);
 
-	std::unique_ptr<LZFBufferedInput<File_Large*>> m_pCompressInput;
+	std::unique_ptr<LZFBufferedInput<File_Mapped*>> m_pCompressInput;
 	std::unique_ptr<LZFBufferedOutput<File_Large*, GenericEngineBase>> m_pCompressOutput;
 
 	Header m_header;
 	bool m_bCreateMode;
+	bool m_bMemoryMap;
+	unsigned m_nCompressionThreads;
+	unsigned m_nCodecId;
+	E_CompressionLevel m_eCompressionLevel;
+	unsigned m_nLzfBlockSize;
+
+	// when reading, the codec from nCompressionVersion.  NULL if it isn't compressed
+	const Codec* m_pCodec;
+	unsigned m_nReadAheadBlocks;
 
 	// this is always the # of the next record to be read
 	int64_t m_nCurrentRecord;
 
 	// the record blocks are always 64K records, except for the last one
-	std::vector<int64_t> m_vRecordBlockIndexPos;
+	// when reading it is loaded on demand by LoadRecordBlockIndex
+	mutable std::vector<int64_t> m_vRecordBlockIndexPos;
+	mutable std::mutex m_recordBlockIndexMutex;
+
+	// the optional dense record index.  See HeaderExtension
+	unsigned m_nDenseIndexInterval;
+	mutable std::vector<int64_t> m_vDenseIndexPos;
+
+	// the optional record offset index.  While writing, the LZF block #'s aren't known yet, so they
+	// are kept in the entries nLzfBlockPos and turned into file positions on Close
+	unsigned m_nRecordOffsetIndexInterval;
+	std::vector<RecordOffsetIndexEntry> m_vRecordOffsetIndex;
+
+	void GoRecordOffsetIndex(int64_t nRecord);
+
+	// the block and index bookkeeping due before writing record m_nCurrentRecord
+	void StartAppendRecord();
+	// the smallest of the block and index intervals.  Only records that are a multiple of it need StartAppendRecord
+	unsigned GetAppendInterval() const;
+	void WriteRecordBytes(const char* pBytes, size_t nSize);
+
+	void ReadIndex(int64_t nPos, unsigned nMinEntries, std::vector<int64_t>& r_vIndex) const;
+	void WriteIndex(const std::vector<int64_t>& vIndex);
+	void LoadRecordBlockIndex() const;
+	void LoadDenseIndex() const;
+	int64_t GetRecordBlockStartPos(unsigned nBlock) const;
+	int64_t GetRecordBlockEndPos(unsigned nBlock) const;
+	int64_t GetRecordDataEndPos() const;
+	unsigned GetFileLzfBlockSize() const;
+
+	// ReadBatch decodes the records back to back into m_vBatchArena (which is only ever grown)
+	// and m_vBatchRecords points into it
+	std::vector<unsigned char> m_vBatchArena;
+	std::vector<const RecordData*> m_vBatchRecords;
+	std::vector<size_t> m_vBatchOffsets;
+
+	void ReadRecordBytes(void* pBuffer, unsigned nSize);
+
+	// the field numbers returned by ReadProjectedBlock
+	std::vector<unsigned> m_vProjection;
+
+	// see BuildSpatialIndex and SetSpatialIndex.  m_nSpatialIndexField is -1 if there isn't an index.
+	// When reading, an index stored in the file is only loaded by LoadSpatialIndex when it is first needed
+	bool m_bWriteSpatialIndex;
+	int m_nWriteSpatialIndexField;
+	int m_nSpatialIndexField;
+	mutable bool m_bSpatialIndexLoaded;
+	mutable SpatialIndex m_spatialIndex;
+
+	int FindSpatialField(int nField) const;
+	void IndexSpatialRecord(const RecordData* pRec);
+	void WriteSpatialIndex();
+	void LoadSpatialIndex() const;
+
+	// see SetZoneMaps.  m_vZoneMapFields are the fields with stats, and m_vZoneMaps has a ZoneMapStats for each of
+	// them for each record block.  While writing, m_vZoneMapRegisters is the sketch the distinct counts of the current
+	// block are estimated from.  When reading they are only loaded by LoadZoneMaps when they are first needed
+	bool m_bWriteZoneMaps;
+	mutable bool m_bZoneMapsLoaded;
+	mutable std::vector<unsigned> m_vZoneMapFields;
+	mutable std::vector<ZoneMapStats> m_vZoneMaps;
+	std::vector<unsigned char> m_vZoneMapRegisters;
+
+	void StartZoneMaps();
+	void AddZoneMapRecord(int64_t nRecord, const RecordData* pRec);
+	void FinishZoneMapBlock();
+	void WriteZoneMaps();
+	void LoadZoneMaps() const;
+	// where field nField is in a block's stats, or -1 if it doesn't have any
+	int FindZoneMapField(unsigned nField) const;
+
+	// the spatial index and zone maps of each appended record
+	inline bool IndexesRecords() const
+	{
+		return m_nSpatialIndexField >= 0 || !m_vZoneMapFields.empty();
+	}
+	void IndexRecord(int64_t nRecord, const RecordData* pRec);
+
+	// see SetRecordInfoCache
+	RecordInfoCache* m_pRecordInfoCache;
+
+	// see SetBlockCache.  m_inFileIdentity is what the blocks of the file being read are cached under
+	BlockCache* m_pBlockCache;
+	FileIdentity m_inFileIdentity;
 
 public:
 	Open_AlteryxYXDB()
 		: m_bIndexStartsBlock(false)
 		, m_bCreateMode(false)
+		, m_bMemoryMap(true)
+		, m_nCompressionThreads(0)
+		, m_nCodecId(E_Codec_LZF)
+		, m_eCompressionLevel(E_CompressionLevel_Default)
+		, m_nLzfBlockSize(DefaultLzfBlockSize)
+		, m_pCodec(NULL)
+		, m_nReadAheadBlocks(0)
 		, m_nCurrentRecord(0)
+		, m_nDenseIndexInterval(0)
+		, m_nRecordOffsetIndexInterval(0)
+		, m_bWriteSpatialIndex(false)
+		, m_nWriteSpatialIndexField(-1)
+		, m_nSpatialIndexField(-1)
+		, m_bSpatialIndexLoaded(false)
+		, m_bWriteZoneMaps(false)
+		, m_bZoneMapsLoaded(false)
+		, m_pRecordInfoCache(NULL)
+		, m_pBlockCache(&BlockCache::Global())
 	{
 	}
 	~Open_AlteryxYXDB();
 	void Close();
 
+	// by default files opened for read are memory mapped.  Call this before Open to turn that off.
+	void SetMemoryMapping(bool bMemoryMap);
+
+	// the number of threads used to compress the record blocks when creating a file.  0 (the default) compresses
+	// on the calling thread, or on 1 worker thread if the RecordInfo has a generic engine, as it always has.
+	// The file is identical either way.  Call this before Create.
+	void SetCompressionThreads(unsigned nThreads);
+
+	// the codec (see E_CodecId and CodecRegistry) used to compress the records when creating a file.  The default
+	// is LZF, which is the only one Alteryx itself can read.  Call this before Create.
+	void SetCompressionCodec(unsigned nCodecId);
+
+	// trade compression speed for file size when creating a file.  The file can be read the same way whatever the
+	// level, including by Alteryx if the codec is LZF.  Call this before Create.
+	void SetCompressionLevel(E_CompressionLevel eLevel);
+
+	// the size of the uncompressed blocks the records are compressed in when creating a file, from MinLzfBlockSize
+	// to MaxLzfBlockSize.  Bigger blocks compress better, smaller ones make GoRecord cheaper.  It is recorded in the
+	// header and used automatically when reading, but Alteryx itself can only read the default.
+	// Call this before Create.
+	void SetCompressionBlockSize(unsigned nBlockSize);
+
+	// when reading sequentially, read and decompress up to nBlocks LZF blocks ahead on a helper thread so the
+	// I/O and decompression overlap with processing the records.  0 (the default) turns it off.  Call this before Open.
+	void SetReadAhead(unsigned nBlocks);
+
+	// when creating a file, also write an index entry every nInterval records so GoRecord never has to skip
+	// more than that many records.  nInterval must be a power of 2 no bigger than RecordsPerBlock, or 0 (the default)
+	// for no dense index.  It costs a little compression, since the data is flushed at each entry.  Call this before Create.
+	void SetDenseIndexInterval(unsigned nInterval);
+
+	// when creating a file, also remember where every nInterval'th record starts inside its LZF block, so GoRecord
+	// only has to decompress 1 LZF block and skip fewer than nInterval records.  Unlike the dense index this doesn't
+	// cost any compression, just 16 bytes per entry.  nInterval must be a power of 2 no bigger than RecordsPerBlock,
+	// or 0 (the default) for none.  256 is a good choice.  Call this before Create.
+	void SetRecordOffsetIndexInterval(unsigned nInterval);
+
+	// when creating a file, also index the bounding boxes of the SpatialObj field nField (or the first SpatialObj
+	// field if nField is -1) as the records are appended, and store the index in the file so QuerySpatialIndex
+	// works as soon as it is opened, without BuildSpatialIndex.  It costs 16 bytes per record.  Alteryx ignores it.
+	// Call this before Create.
+	void SetSpatialIndex(bool bSpatialIndex, int nField = -1);
+
+	// when creating a file, also keep the min, max, null count and an estimate of the distinct count of every field
+	// that has a key (see ZoneMapStats) for each record block, so Scan can skip the blocks that can't match.
+	// It costs 24 bytes per field per block.  Alteryx ignores them.  Call this before Create.
+	void SetZoneMaps(bool bZoneMaps);
+
+	// when opening a file, copy its RecordInfo from pCache rather than parsing the XML again if another file with the
+	// same XML has already been opened with it.  pCache has to outlive the file.  Call this before Open.
+	void SetRecordInfoCache(RecordInfoCache* pCache);
+
+	// when reading, look up the decompressed LZF blocks in pCache (see BlockCache), and add the ones decompressed
+	// here, so readers of the same file share them - a block read again after GoRecord, or by another reader, isn't
+	// decompressed again.  ReadRecord, SetReadAhead, ReadRecordBlock and the scans all go through it.
+	// By default it is BlockCache::Global(), which is off until its SetMaxBytes is called, and can be turned on
+	// while files are open.  NULL turns it off.  Call this before Open.
+	void SetBlockCache(BlockCache* pCache);
+
 	void Open(WString strFile);
 	void Create(WString strFile, const U16unit* pRecordInfoXml);
 
 	const RecordData* ReadRecord();
+
+	// reads up to nMaxRecords records starting at the current record into one contiguous buffer.
+	// The records are good until the next call to ReadBatch, Open or Close - unlike ReadRecord,
+	// they do not need to be copied before reading the next one.  Returns an empty batch at the end of the file.
+	TBlobVal<const RecordData*> ReadBatch(unsigned nMaxRecords);
+
 	void AppendRecord(const RecordData* pRec);
 
+	// the same as calling AppendRecord on each record, but the block and index bookkeeping is only done where
+	// a block or index entry starts, and records that sit back to back in memory (such as the ones ReadBatch
+	// returns) are copied into the compression buffer in one go
+	void AppendRecords(const RecordData* const* ppRecords, size_t nRecords);
+
+	// appends nRecords records already laid out back to back in pRecords the way they are written to the file:
+	// the fixed part of each record and, if the RecordInfo ContainsVarData, its var data length and var data.
+	// That is how ReadBatch and RecordInfo::Copy lay them out.  Throws, without writing anything, if the records
+	// don't take up exactly nBytes.
+	void AppendRaw(const void* pRecords, size_t nBytes, size_t nRecords);
+
 	int64_t GetNumRecords();
 
 	void GoRecord(int64_t nRecord = 0);
 
 	WString GetRecordXmlMetaData();
+
+	unsigned GetNumRecordBlocks() const;
+
+	// decompresses and parses a whole record block.  This doesn't touch the current read position,
+	// and it is safe to call from several threads at once as long as each has its own block and vScratch.
+	// vScratch is only used if the file isn't memory mapped.
+	void ReadRecordBlock(unsigned nBlock, RecordBlock& block, std::vector<unsigned char>& vScratch) const;
+
+	// selects the fields returned by ReadProjectedBlock.  Call this after Open.
+	void SetProjection(const std::vector<unsigned>& vFields);
+	void SetProjection(const std::vector<StringNoCase>& vFieldNames);
+
+	// decompresses a record block and pulls just the projected fields out of it into columns.
+	// Like ReadRecordBlock, this doesn't touch the current read position and it is safe to
+	// call from several threads at once as long as each has its own ProjectedBlock.
+	void ReadProjectedBlock(unsigned nBlock, ProjectedBlock& r_block) const;
+
+	// called by ParallelScan for each record.  nBlock is the record block it came from
+	// and nRecord is its record number in the file
+	typedef std::function<void(unsigned nBlock, int64_t nRecord, const RecordData* pRec)> ScanCallback;
+
+	// Decompresses and parses the record blocks on nThreads worker threads (0 for 1 per core).
+	// If bOrdered, the callback is called on this thread with the records in file order and at most
+	// nMaxPendingBlocks (0 for 2 per thread) decoded blocks are held waiting their turn.
+	// Otherwise the callback is called on the worker threads as soon as each block is ready,
+	// so it needs to be thread safe.  FieldBase is only thread safe through the GetAsXxx overloads that take a
+	// FieldScratch, so give each thread its own FieldScratch (or its own RecordInfo).
+	// This doesn't change the current read position.
+	void ParallelScan(
+		const ScanCallback& callback,
+		unsigned nThreads = 0,
+		bool bOrdered = true,
+		unsigned nMaxPendingBlocks = 0);
+
+	// Alteryx's own spatial index (ID_WRIGLEYDB files) is in an undocumented format, so it is skipped.
+	// If the file wasn't written with SetSpatialIndex, this builds an index of the bounding boxes of the
+	// SpatialObj field nField (or the first SpatialObj field if nField is -1) by reading every record once,
+	// on nThreads threads (0 for 1 per core).
+	// It doesn't change the current read position.
+	void BuildSpatialIndex(int nField = -1, unsigned nThreads = 0);
+
+	// the field the spatial index is on, or -1 if there isn't one
+	int GetSpatialIndexField() const;
+
+	// the record #'s whose spatial object's bounding box intersects box, in order.  Use GoRecord to read them.
+	// Throws if there is no spatial index.
+	std::vector<int64_t> QuerySpatialIndex(const SpatialBoundingBox& box) const;
+
+	// the record blocks (see ReadRecordBlock and ReadProjectedBlock) holding those records, in order
+	std::vector<unsigned> QuerySpatialIndexBlocks(const SpatialBoundingBox& box) const;
+
+	// whether the file was written with SetZoneMaps
+	bool HasZoneMaps() const;
+
+	// the stats of field nField in record block nBlock, or NULL if it doesn't have any
+	const ZoneMapStats* GetZoneMapStats(unsigned nBlock, unsigned nField) const;
+
+	// the record blocks whose stats don't rule out a match, in order.  That is all of them if there aren't any zone maps
+	std::vector<unsigned> GetMatchingBlocks(const ScanPredicate& predicate) const;
+
+	// the same for a RecordPredicate, from the Bound of each of its tests.  Its fields can be from any RecordInfo
+	// with the same layout as this file's
+	std::vector<unsigned> GetMatchingBlocks(const RecordPredicate& predicate) const;
+
+	// like ParallelScan, but only the records that match predicate are passed to the callback, and
+	// the record blocks that the zone maps show can't have any aren't even decompressed
+	void Scan(
+		const ScanPredicate& predicate,
+		const ScanCallback& callback,
+		unsigned nThreads = 0,
+		bool bOrdered = true,
+		unsigned nMaxPendingBlocks = 0);
+
+	// like ParallelScan, but only the records that match predicate are passed to the callback.  The record blocks
+	// the zone maps show can't have any aren't decompressed, and each of the others is filtered in one go with
+	// RecordPredicate::Select as soon as it is decoded, so the records that don't match are never touched again
+	void Scan(
+		const RecordPredicate& predicate,
+		const ScanCallback& callback,
+		unsigned nThreads = 0,
+		bool bOrdered = true,
+		unsigned nMaxPendingBlocks = 0);
+
+private:
+	typedef std::function<void(const RecordBlock& block)> BlockCallback;
+
+	// ParallelScan over just the blocks in vBlocks, which have to be in order, a whole block at a time.
+	// If pPredicate isn't NULL each block's m_vSelection is filled in on the worker thread that decoded it
+	void ScanBlocks(
+		const std::vector<unsigned>& vBlocks,
+		const BlockCallback& callback,
+		const RecordPredicate* pPredicate,
+		unsigned nThreads,
+		bool bOrdered,
+		unsigned nMaxPendingBlocks);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class YXDBDataset
+//
+// Many YXDB files (shards) with the same schema read as one table.  The records are numbered across the shards
+// in the order the files were given, so record GetShardFirstRecord(n) is the first record of shard n.
+// The shards are opened as they are needed and at most SetMaxOpenFiles of them are open at once, the ones used
+// least recently being closed to make room.  The schema is only parsed once, however many shards share it.
+class OPEN_ALTERYX_EXPORT YXDBDataset
+{
+	struct Shard
+	{
+		WString m_strFile;
+		int64_t m_nFirstRecord = 0;
+		int64_t m_nNumRecords = 0;
+		unsigned m_nNumRecordBlocks = 0;
+
+		// NULL while it is closed.  m_nUsers are the threads using it, and it is only closed when there are none.
+		// m_bOpening is set while a thread is opening it outside the lock
+		std::unique_ptr<Open_AlteryxYXDB> m_pFile;
+		unsigned m_nUsers = 0;
+		bool m_bOpening = false;
+		uint64_t m_nLastUsed = 0;
+	};
+
+	std::vector<Shard> m_vShards;
+	RecordInfoCache m_recordInfoCache;
+	unsigned m_nMaxOpenFiles;
+	size_t m_nMemoryBudget;
+
+	std::mutex m_shardMutex;
+	std::condition_variable m_cvShards;  // signaled when a shard is released, opened or closed
+	unsigned m_nOpenFiles;
+	uint64_t m_nUseCount;
+
+	// the shard ReadRecord is reading from, or -1 if it hasn't acquired one yet.
+	// m_nCurrentRecord is always the # of the next record to be read
+	int m_nCurrentShard;
+	int64_t m_nCurrentRecord;
+
+	// opens shard nShard if it isn't already, and keeps it open until the matching ReleaseShard
+	Open_AlteryxYXDB& AcquireShard(unsigned nShard);
+	void ReleaseShard(unsigned nShard);
+	void ReleaseCurrentShard();
+
+public:
+	// the schema of the first shard, which all the others match
+	RecordInfo m_recordInfo;
+
+	YXDBDataset();
+	~YXDBDataset();
+
+	// the most shards that are open at once, 64 by default.  Call this before Open.
+	void SetMaxOpenFiles(unsigned nMaxOpenFiles);
+
+	// the most decoded record data ParallelScan and Scan hold waiting to be passed to the callback, on top of the
+	// block each thread is working on.  0 (the default) is no limit besides nMaxPendingBlocks.
+	void SetMemoryBudget(size_t nBytes);
+
+	// reads the header of every shard and throws if any of their schemas don't match the first one
+	// (see RecordInfo::CompareSchemas)
+	void Open(const std::vector<WString>& vFiles);
+	void Close();
+
+	unsigned GetNumShards() const;
+	const WString& GetShardFile(unsigned nShard) const;
+	int64_t GetShardFirstRecord(unsigned nShard) const;
+	int64_t GetShardNumRecords(unsigned nShard) const;
+
+	// the shard record nRecord is in
+	unsigned FindShard(int64_t nRecord) const;
+
+	// the total across all the shards
+	int64_t GetNumRecords() const;
+
+	void GoRecord(int64_t nRecord = 0);
+
+	// the record is good until the next call to ReadRecord, GoRecord, ParallelScan, Scan or Close
+	const RecordData* ReadRecord();
+
+	// called by ParallelScan for each record.  nRecord is its record number across all the shards
+	typedef std::function<void(unsigned nShard, int64_t nRecord, const RecordData* pRec)> ScanCallback;
+
+	// Open_AlteryxYXDB::ParallelScan across every shard.  The record blocks of all the shards are handed out to the
+	// threads in order, so if bOrdered the callback sees the records in order across the shards too.
+	void ParallelScan(
+		const ScanCallback& callback,
+		unsigned nThreads = 0,
+		bool bOrdered = true,
+		unsigned nMaxPendingBlocks = 0);
+
+	// the same, but only the records that match predicate are passed to the callback, and the record blocks that
+	// the zone maps of their shard show can't have any aren't decompressed.  The predicate can be built on
+	// m_recordInfo, since the records of every shard have the same layout
+	void Scan(
+		const RecordPredicate& predicate,
+		const ScanCallback& callback,
+		unsigned nThreads = 0,
+		bool bOrdered = true,
+		unsigned nMaxPendingBlocks = 0);
+
+private:
+	typedef std::function<void(unsigned nShard, const RecordBlock& block)> BlockCallback;
+
+	// the blocks of every shard, or if pPredicate isn't NULL just the ones Open_AlteryxYXDB::GetMatchingBlocks keeps,
+	// with their m_vSelection filled in
+	void ScanBlocks(
+		const BlockCallback& callback,
+		const RecordPredicate* pPredicate,
+		unsigned nThreads,
+		bool bOrdered,
+		unsigned nMaxPendingBlocks);
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class YXDBPartitionedWriter
+//
+// Writes records from any number of threads into nPartitions YXDB files at once.  Each record is routed to a
+// partition by the hash of a key field or round robin, and each partition has its own thread that compresses and
+// writes its records, so the writing keeps up with a parallel upstream.  With SetMaxFileSize a partition moves on
+// to a new file when its current one is full.  The files are named <prefix>-<partition>-<file>.yxdb
+// (e.g. out-00003-00000.yxdb) and Close lists them in <prefix>.manifest.xml.
+class OPEN_ALTERYX_EXPORT YXDBPartitionedWriter
+{
+public:
+	enum E_Partitioning
+	{
+		E_Partitioning_RoundRobin,
+		E_Partitioning_Hash
+	};
+
+	// what is in the manifest for each file written
+	struct OutputFile
+	{
+		WString m_strFile;
+		unsigned m_nPartition;
+		int64_t m_nNumRecords;
+	};
+
+	// called on each file before it is created, to set compression, zone maps etc
+	typedef std::function<void(Open_AlteryxYXDB& file)> FileOptionsCallback;
+
+private:
+	struct Partition;
+
+	E_Partitioning m_ePartitioning;
+	unsigned m_nPartitions;
+	int m_nKeyField;
+	uint64_t m_nMaxFileSize;
+	FileOptionsCallback m_fileOptions;
+
+	WString m_strPrefix;
+	String m_strRecordInfoXml;
+	std::vector<std::unique_ptr<Partition>> m_vPartitions;
+	std::atomic<uint64_t> m_nNextRoundRobin;
+	std::vector<OutputFile> m_vFiles;
+
+	unsigned Route(const RecordData* pRec);
+	void WriterThread(Partition& partition);
+	void StartFile(Partition& partition);
+	void FinishFile(Partition& partition);
+	void WriteManifest();
+
+public:
+	RecordInfo m_recordInfo;
+
+	YXDBPartitionedWriter();
+	~YXDBPartitionedWriter();
+
+	// how the records are spread across nPartitions partitions.  E_Partitioning_Hash needs nKeyField, and records with
+	// the same value in it always go to the same partition.  The default is 1 partition.  Call this before Create.
+	void SetPartitioning(E_Partitioning ePartitioning, unsigned nPartitions, int nKeyField = -1);
+
+	// start a new file for a partition once nBytes of records (before compression) have gone into its current one.
+	// 0 (the default) is no limit.  Call this before Create.
+	void SetMaxFileSize(uint64_t nBytes);
+
+	// Call this before Create
+	void SetFileOptions(const FileOptionsCallback& fileOptions);
+
+	// strPrefix is the path of the files without the -<partition>-<file>.yxdb
+	void Create(WString strPrefix, const U16unit* pRecordInfoXml);
+
+	// these are thread safe, and the records can be reused as soon as they return.  They block when the partition
+	// threads fall too far behind, and throw if one of them has failed
+	void AppendRecord(const RecordData* pRec);
+	void AppendRecords(const RecordData* const* ppRecords, size_t nRecords);
+
+	// waits for the partition threads to finish and writes the manifest
+	void Close();
+
+	// the files written, in order by partition.  Only complete after Close
+	const std::vector<OutputFile>& GetFiles() const;
+	WString GetManifestFile() const;
 };
 }}  // namespace Alteryx::OpenYXDB
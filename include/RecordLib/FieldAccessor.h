@@ -0,0 +1,376 @@
+// Copyright(C) 2005 - 2019 Alteryx, Inc. All rights reserved.
+// This file is distributed to Alteryx customers as part of the
+// Software Development Kit.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "Base/StringToDouble.h"
+#include "FieldBase.h"
+#include "Record.h"
+#include "RecordInfo.h"
+
+namespace SRC {
+namespace FieldAccessorDetail {
+// Byte, Int16, Int32, Int64, Float and Double - the value followed by a null flag.  See Field_Num.
+template <class T_Num>
+struct NumLayout
+{
+	typedef T_Num T_Value;
+
+	static inline bool GetNull(const char* pField)
+	{
+		return pField[sizeof(T_Num)] != 0;
+	}
+	static inline T_Num GetValue(const char* pField)
+	{
+		T_Num val;
+		memcpy(&val, pField, sizeof(T_Num));
+		return val;
+	}
+	static inline void SetValue(char* pField, T_Num val)
+	{
+		memcpy(pField, &val, sizeof(T_Num));
+		pField[sizeof(T_Num)] = 0;
+	}
+	static inline void SetNull(char* pField)
+	{
+		memset(pField, 0, sizeof(T_Num));
+		pField[sizeof(T_Num)] = 1;
+	}
+};
+
+// a single byte - bit 0 is the value, bit 1 the null flag.  See Field_Bool.
+struct BoolLayout
+{
+	typedef bool T_Value;
+
+	static inline bool GetNull(const char* pField)
+	{
+		return (*pField & 2) != 0;
+	}
+	static inline bool GetValue(const char* pField)
+	{
+		return (*pField & 1) != 0;
+	}
+	static inline void SetValue(char* pField, bool val)
+	{
+		*pField = val ? 1 : 0;
+	}
+	static inline void SetNull(char* pField)
+	{
+		*pField = 2;
+	}
+};
+
+template <E_FieldType ft>
+struct Layout;
+template <>
+struct Layout<E_FT_Bool> : BoolLayout
+{
+};
+template <>
+struct Layout<E_FT_Byte> : NumLayout<unsigned char>
+{
+};
+template <>
+struct Layout<E_FT_Int16> : NumLayout<int16_t>
+{
+};
+template <>
+struct Layout<E_FT_Int32> : NumLayout<int32_t>
+{
+};
+template <>
+struct Layout<E_FT_Int64> : NumLayout<int64_t>
+{
+};
+template <>
+struct Layout<E_FT_Float> : NumLayout<float>
+{
+};
+template <>
+struct Layout<E_FT_Double> : NumLayout<double>
+{
+};
+
+// String and WString - nFieldLen chars followed by a null flag.  The value is terminated if it is shorter
+// than the field.  See Field_String_GetSet.
+template <class TChar>
+struct FixedStringLayout
+{
+	typedef TChar T_Char;
+
+	static inline bool GetNull(const RecordData* pRecord, unsigned nOffset, unsigned nFieldLen)
+	{
+		return ToCharP(pRecord)[nOffset + nFieldLen * sizeof(TChar)] != 0;
+	}
+	static inline TFieldVal<TBlobVal<TChar>> Get(const RecordData* pRecord, unsigned nOffset, unsigned nFieldLen)
+	{
+		if (GetNull(pRecord, nOffset, nFieldLen))
+			return TFieldVal<TBlobVal<TChar>>(true, TBlobVal<TChar>(0, NULL));
+		const char* pField = ToCharP(pRecord) + nOffset;
+		return TFieldVal<TBlobVal<TChar>>(
+			false, TBlobVal<TChar>(Length(pField, nFieldLen), reinterpret_cast<const TChar*>(pField)));
+	}
+	static inline unsigned Length(const char* pField, unsigned nFieldLen)
+	{
+		unsigned nLen = 0;
+		for (TChar c; nLen < nFieldLen; ++nLen)
+		{
+			memcpy(&c, pField + nLen * sizeof(TChar), sizeof(TChar));
+			if (c == 0)
+				break;
+		}
+		return nLen;
+	}
+};
+
+template <>
+inline unsigned FixedStringLayout<char>::Length(const char* pField, unsigned nFieldLen)
+{
+	const void* pEnd = memchr(pField, 0, nFieldLen);
+	return pEnd ? unsigned(static_cast<const char*>(pEnd) - pField) : nFieldLen;
+}
+
+// V_String and V_WString - the value lives in the var data.  See Field_V_String_GetSet.
+template <class TChar>
+struct VarStringLayout
+{
+	typedef TChar T_Char;
+
+	static inline bool GetNull(const RecordData* pRecord, unsigned nOffset, unsigned /*nFieldLen*/)
+	{
+		return RecordInfo::GetVarDataValue(pRecord, int(nOffset)).pValue == NULL;
+	}
+	static inline TFieldVal<TBlobVal<TChar>> Get(const RecordData* pRecord, unsigned nOffset, unsigned /*nFieldLen*/)
+	{
+		BlobVal val = RecordInfo::GetVarDataValue(pRecord, int(nOffset));
+		if (val.pValue == NULL)
+			return TFieldVal<TBlobVal<TChar>>(true, TBlobVal<TChar>(0, NULL));
+		return TFieldVal<TBlobVal<TChar>>(
+			false, TBlobVal<TChar>(unsigned(val.nLength / sizeof(TChar)), static_cast<const TChar*>(val.pValue)));
+	}
+};
+
+template <E_FieldType ft>
+struct StringLayout;
+template <>
+struct StringLayout<E_FT_String> : FixedStringLayout<char>
+{
+};
+template <>
+struct StringLayout<E_FT_WString> : FixedStringLayout<U16unit>
+{
+};
+template <>
+struct StringLayout<E_FT_V_String> : VarStringLayout<char>
+{
+};
+template <>
+struct StringLayout<E_FT_V_WString> : VarStringLayout<U16unit>
+{
+};
+
+// FixedDecimal - the number as text, laid out like a String.  See FieldFixedDecimal.
+struct FixedDecimalLayout : FixedStringLayout<char>
+{
+	// the value as a double.  Null values read as 0
+	static inline double GetDouble(const char* pField, unsigned nFieldLen)
+	{
+		// ConvertToDouble wants it terminated
+		char buffer[512];
+		const unsigned nLen = Length(pField, std::min(nFieldLen, unsigned(sizeof(buffer) - 1)));
+		memcpy(buffer, pField, nLen);
+		buffer[nLen] = 0;
+		double dRet = 0;
+		ConvertToDouble(buffer, dRet);
+		return dRet;
+	}
+};
+}  // namespace FieldAccessorDetail
+
+////////////////////////////////////////////////////////////////////////////////////////
+// class FieldAccessor
+//
+// Reads and writes one fixed width field of a known type straight from the record bytes.
+// It only holds the field's offset, so everything is inline with no virtual calls and no
+// temporary buffers - unlike FieldBase it is safe to share between threads.
+// Bind it once when the schema is known and use it in the record loop:
+//
+//		FieldAccessor<E_FT_Int32> id(*recordInfo[0]);
+//		while (const RecordData* pRec = file.ReadRecord())
+//			if (!id.GetNull(pRec))
+//				total += id.GetValue(pRec);
+//
+// There is no conversion - the type has to be the field's own type (Bool, Byte, Int16, Int32, Int64,
+// Float or Double).  Null values read as 0 (or false).
+////////////////////////////////////////////////////////////////////////////////////////
+template <E_FieldType ft>
+class FieldAccessor
+{
+	typedef FieldAccessorDetail::Layout<ft> T_Layout;
+
+	unsigned m_nOffset;
+
+public:
+	typedef typename T_Layout::T_Value T_Value;
+
+	inline FieldAccessor()
+		: m_nOffset(0)
+	{
+	}
+
+	// throws if the field isn't of type ft
+	inline explicit FieldAccessor(const FieldBase& field)
+		: m_nOffset(unsigned(field.GetOffset()))
+	{
+		if (field.m_ft != ft)
+			throw Error(XMSG(
+				"FieldAccessor: Field @1 is @2, not @3.",
+				field.GetFieldName().c_str(),
+				GetNameFromFieldType(field.m_ft),
+				GetNameFromFieldType(ft)));
+	}
+
+	inline unsigned GetOffset() const
+	{
+		return m_nOffset;
+	}
+
+	inline bool GetNull(const RecordData* pRecord) const
+	{
+		return T_Layout::GetNull(ToCharP(pRecord) + m_nOffset);
+	}
+
+	inline T_Value GetValue(const RecordData* pRecord) const
+	{
+		const char* pField = ToCharP(pRecord) + m_nOffset;
+		return T_Layout::GetNull(pField) ? T_Value(0) : T_Layout::GetValue(pField);
+	}
+
+	inline TFieldVal<T_Value> Get(const RecordData* pRecord) const
+	{
+		const char* pField = ToCharP(pRecord) + m_nOffset;
+		if (T_Layout::GetNull(pField))
+			return TFieldVal<T_Value>(true, T_Value(0));
+		return TFieldVal<T_Value>(false, T_Layout::GetValue(pField));
+	}
+
+	// these write the fixed part of the record in place, so they also work on records that
+	// aren't in a Record, such as the ones ReadBatch returns
+	inline void SetValue(RecordData* pRecord, T_Value val) const
+	{
+		T_Layout::SetValue(ToCharP(pRecord) + m_nOffset, val);
+	}
+
+	inline void SetNull(RecordData* pRecord) const
+	{
+		T_Layout::SetNull(ToCharP(pRecord) + m_nOffset);
+	}
+
+	inline void Set(RecordData* pRecord, const TFieldVal<T_Value>& val) const
+	{
+		if (val.bIsNull)
+			SetNull(pRecord);
+		else
+			SetValue(pRecord, val.value);
+	}
+
+	inline void SetValue(Record* pRecord, T_Value val) const
+	{
+		SetValue(pRecord->GetRecord(), val);
+	}
+
+	inline void SetNull(Record* pRecord) const
+	{
+		SetNull(pRecord->GetRecord());
+	}
+
+	inline void Set(Record* pRecord, const TFieldVal<T_Value>& val) const
+	{
+		Set(pRecord->GetRecord(), val);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// class FieldStringAccessor
+//
+// Reads a String, WString, V_String or V_WString field as a view straight into the record:
+// a pointer and a length in chars, with no copy and no conversion.  Unlike GetAsAString and
+// GetAsWString the view is not terminated, so always use nLength.  A WString view may not be
+// 2 byte aligned.  The view is only good for as long as the record it came from.
+// Null values come back with a NULL pValue and a 0 nLength.
+//
+//		FieldStringAccessor<E_FT_V_String> name(*recordInfo[1]);
+//		while (const RecordData* pRec = file.ReadRecord())
+//		{
+//			TFieldVal<TBlobVal<char>> val = name.Get(pRec);
+//			if (!val.bIsNull)
+//				++counts[std::string(val.value.pValue, val.value.nLength)];
+//		}
+//
+// Like FieldAccessor it only holds the field's offset and size, so it is safe to share between threads.
+////////////////////////////////////////////////////////////////////////////////////////
+template <E_FieldType ft>
+class FieldStringAccessor
+{
+	typedef FieldAccessorDetail::StringLayout<ft> T_Layout;
+
+	unsigned m_nOffset;
+	unsigned m_nFieldLen;
+
+public:
+	typedef typename T_Layout::T_Char T_Char;
+
+	inline FieldStringAccessor()
+		: m_nOffset(0)
+		, m_nFieldLen(0)
+	{
+	}
+
+	// throws if the field isn't of type ft
+	inline explicit FieldStringAccessor(const FieldBase& field)
+		: m_nOffset(unsigned(field.GetOffset()))
+		, m_nFieldLen(unsigned(field.m_nSize))
+	{
+		if (field.m_ft != ft)
+			throw Error(XMSG(
+				"FieldStringAccessor: Field @1 is @2, not @3.",
+				field.GetFieldName().c_str(),
+				GetNameFromFieldType(field.m_ft),
+				GetNameFromFieldType(ft)));
+	}
+
+	inline unsigned GetOffset() const
+	{
+		return m_nOffset;
+	}
+
+	inline bool GetNull(const RecordData* pRecord) const
+	{
+		return T_Layout::GetNull(pRecord, m_nOffset, m_nFieldLen);
+	}
+
+	inline TFieldVal<TBlobVal<T_Char>> Get(const RecordData* pRecord) const
+	{
+		return T_Layout::Get(pRecord, m_nOffset, m_nFieldLen);
+	}
+};
+
+typedef FieldAccessor<E_FT_Bool> FieldAccessor_Bool;
+typedef FieldAccessor<E_FT_Byte> FieldAccessor_Byte;
+typedef FieldAccessor<E_FT_Int16> FieldAccessor_Int16;
+typedef FieldAccessor<E_FT_Int32> FieldAccessor_Int32;
+typedef FieldAccessor<E_FT_Int64> FieldAccessor_Int64;
+typedef FieldAccessor<E_FT_Float> FieldAccessor_Float;
+typedef FieldAccessor<E_FT_Double> FieldAccessor_Double;
+
+typedef FieldStringAccessor<E_FT_String> FieldStringAccessor_String;
+typedef FieldStringAccessor<E_FT_WString> FieldStringAccessor_WString;
+typedef FieldStringAccessor<E_FT_V_String> FieldStringAccessor_V_String;
+typedef FieldStringAccessor<E_FT_V_WString> FieldStringAccessor_V_WString;
+}  // namespace SRC
@@ -7,6 +7,8 @@
 #ifndef XSRCLIB_RECORDLIB_INCLUDE_RECORDLIB_FIELDBASE_H
 #define XSRCLIB_RECORDLIB_INCLUDE_RECORDLIB_FIELDBASE_H
 
+#include <vector>
+
 #include "Base/TBlobVal.h"
 #include "Base/TFieldVal.h"
 
@@ -19,12 +21,67 @@ struct RecordData;
 
 class Record;
 
+////////////////////////////////////////////////////////////////////////////////////////
+// class FieldScratch
+//
+// The temporary buffers used by the FieldBase::GetAsXxxReentrant functions in place
+// of the field's own.  Give each thread its own FieldScratch and they can all read through the same
+// RecordInfo at once.  A value that lives in the scratch (a converted string, a wide string copied so
+// it is null terminated...) is good until the next call with the same scratch.
+// Field conversion errors are counted here instead of being reported, since the GenericEngine isn't thread safe.
+////////////////////////////////////////////////////////////////////////////////////////
+class RECORDLIB_EXPORT_CPP FieldScratch
+{
+	friend class FieldBase;
+
+	std::vector<char> m_vBuffer;
+	unsigned m_nConversionErrorCount;
+
+	// makes a scratch current on this thread for as long as it is in scope
+	class Scope
+	{
+		FieldScratch* m_pPrevious;
+
+	public:
+		Scope(FieldScratch& scratch);
+		~Scope();
+	};
+
+public:
+	FieldScratch();
+	~FieldScratch();
+
+	FieldScratch(const FieldScratch&) = delete;
+	FieldScratch& operator=(const FieldScratch&) = delete;
+
+	AString m_astrTemp;
+	String m_wstrTemp;
+
+	// takes the place of the field's m_pSpatialObj - see FieldBase::TempSpatialObj
+	unsigned char* m_pSpatialObj;
+
+	// the scratch of the GetAsXxxReentrant call in progress on this thread, or NULL if there isn't one
+	static FieldScratch* GetCurrent();
+
+	// room for at least nSize TChars
+	template <class TChar>
+	inline TChar* GetBuffer(unsigned nSize)
+	{
+		if (m_vBuffer.size() < nSize * sizeof(TChar))
+			m_vBuffer.resize(nSize * sizeof(TChar));
+		return reinterpret_cast<TChar*>(m_vBuffer.data());
+	}
+
+	unsigned GetConversionErrorCount() const;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // class FieldBase
 //
 // This class is not thread safe - even when calling const functions.
 // It uses internal buffers for managing the translations and 2 threads can't be using it at
-// the same time
+// the same time.  The exception is the GetAsXxxReentrant functions, which take a FieldScratch, along with
+// GetNull - many threads can call those at once, each with its own scratch.
 ////////////////////////////////////////////////////////////////////////////////////////
 class RECORDLIB_EXPORT_CPP FieldBase : public FieldSchema
 {
@@ -48,6 +105,26 @@ protected:
 	mutable AString m_astrTemp;
 	mutable String m_wstrTemp;
 
+	// a temporary spot for holding a spatial object after converting from GeoJSON.  Freed with free()
+	mutable unsigned char* m_pSpatialObj;
+
+	// the buffers for the getters - m_astrTemp, m_wstrTemp and m_pSpatialObj, or the current FieldScratch's
+	inline AString& TempAString() const
+	{
+		FieldScratch* pScratch = FieldScratch::GetCurrent();
+		return pScratch ? pScratch->m_astrTemp : m_astrTemp;
+	}
+	inline String& TempWString() const
+	{
+		FieldScratch* pScratch = FieldScratch::GetCurrent();
+		return pScratch ? pScratch->m_wstrTemp : m_wstrTemp;
+	}
+	inline unsigned char*& TempSpatialObj() const
+	{
+		FieldScratch* pScratch = FieldScratch::GetCurrent();
+		return pScratch ? pScratch->m_pSpatialObj : m_pSpatialObj;
+	}
+
 	mutable const GenericEngineBase* m_pGenericEngine;
 	mutable unsigned m_nFieldConversionErrorCount;
 
@@ -102,6 +179,17 @@ public:
 	void SetFromBlob(Record* pRecord, const TFieldVal<BlobVal>& val) const;
 	void SetFromSpatialBlob(Record* pRecord, const TFieldVal<BlobVal>& val) const;
 
+	// reentrant versions of the getters - the same values, but any temporary buffers come from r_scratch.
+	// They have their own names so the virtual getters the field types override don't hide them
+	TFieldVal<bool> GetAsBoolReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<int> GetAsInt32Reentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<int64_t> GetAsInt64Reentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<double> GetAsDoubleReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<AStringVal> GetAsAStringReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<WStringVal> GetAsWStringReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<BlobVal> GetAsBlobReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+	TFieldVal<BlobVal> GetAsSpatialBlobReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const;
+
 	virtual bool GetNull(const RecordData* pRecord) const = 0;
 	/// any of the other Sets should reset the null status
 	virtual void SetNull(Record* pRecord) const = 0;
@@ -33,7 +33,7 @@ class RECORDLIB_EXPORT_CPP T_Field_Float : public Field_Num<ft, T_Num>
 			}
 			else
 			{
-				if (this->IsReportingFieldConversionErrors() && nNumCharsUsed != nLen && this->m_pGenericEngine)
+				if (this->IsReportingFieldConversionErrors() && nNumCharsUsed != nLen)
 				{
 					if (pVal[nNumCharsUsed] == ',')
 						this->ReportFieldConversionError(
@@ -88,7 +88,7 @@ protected:
 	template <class TNum>
 	inline void NumericConversionError(TNum n, const String::TChar* pDestType = NULL) const
 	{
-		if (m_pGenericEngine)
+		if (IsReportingFieldConversionErrors())
 		{
 			ReportFieldConversionError(XMSG(
 				"@1 does not fit in the type @2",
@@ -103,7 +103,7 @@ protected:
 		if (errno == ERANGE)
 		{
 			SetNull(pRecord);
-			if (m_pGenericEngine)  // this gets set to NULL when the limit has been hit, so no point in adding the strings in the error message
+			if (IsReportingFieldConversionErrors())  // this goes false when the limit has been hit, so no point in adding the strings in the error message
 			{
 				if (sizeof(T_Num) == 8)
 					ReportFieldConversionError(XMSG("@1 does not fit in an Int64.", ConvertToWString(pVal)));
@@ -117,18 +117,18 @@ protected:
 			if (pEnd == pVal || nLen == 0)
 			{
 				SetNull(pRecord);
-				if (nLen > 0 && m_pGenericEngine)
+				if (nLen > 0 && IsReportingFieldConversionErrors())
 					ReportFieldConversionError(XMSG("@1 is not a number.", ConvertToWString(pVal)));
 			}
 			else if (*pEnd == ',')
 			{
-				if (m_pGenericEngine)
+				if (IsReportingFieldConversionErrors())
 					ReportFieldConversionError(
 						XMSG("@1 stopped converting at a comma. It might be invalid.", ConvertToWString(pVal)));
 			}
 			else
 			{
-				if (m_pGenericEngine)
+				if (IsReportingFieldConversionErrors())
 					ReportFieldConversionError(XMSG("@1 was not fully converted", ConvertToWString(pVal)));
 			}
 		}
@@ -207,22 +207,24 @@ public:
 	virtual TFieldVal<AStringVal> GetAsAString(const RecordData* pRecord) const
 	{
 		TFieldVal<T_Num> val = GetVal(pRecord);
+		AString& strTemp = TempAString();
 		if (val.bIsNull)
-			m_astrTemp.Truncate(0);
+			strTemp.Truncate(0);
 		else
-			m_astrTemp.Assign(val.value);
-		TFieldVal<AStringVal> ret(val.bIsNull, AStringVal(m_astrTemp.Length(), m_astrTemp.c_str()));
+			strTemp.Assign(val.value);
+		TFieldVal<AStringVal> ret(val.bIsNull, AStringVal(strTemp.Length(), strTemp.c_str()));
 		return ret;
 	}
 
 	virtual TFieldVal<WStringVal> GetAsWString(const RecordData* pRecord) const
 	{
 		TFieldVal<T_Num> val = GetVal(pRecord);
+		String& strTemp = TempWString();
 		if (val.bIsNull)
-			m_wstrTemp.Truncate(0);
+			strTemp.Truncate(0);
 		else
-			m_wstrTemp.Assign(val.value);
-		TFieldVal<WStringVal> ret(val.bIsNull, WStringVal(m_wstrTemp.Length(), m_wstrTemp.c_str()));
+			strTemp.Assign(val.value);
+		TFieldVal<WStringVal> ret(val.bIsNull, WStringVal(strTemp.Length(), strTemp.c_str()));
 		return ret;
 	}
 
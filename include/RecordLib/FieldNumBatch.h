@@ -0,0 +1,112 @@
+// Copyright(C) 2005 - 2019 Alteryx, Inc. All rights reserved.
+// This file is distributed to Alteryx customers as part of the
+// Software Development Kit.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "RecordLibExport.h"
+
+namespace SRC {
+struct RecordData;
+class FieldBase;
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Batch extraction of the fixed width numeric fields
+//
+// These read one Byte, Int16, Int32, Int64, Float or Double field out of many records at once,
+// straight from the record bytes (see Field_Num::GetVal) rather than through a virtual GetAsXxx per value.
+// Each writes nRecords values to pValues and nRecords null flags to pNulls (1 for null, else 0).
+// Null values come back as 0.  The type of pValues has to match the field's type exactly - they throw if it doesn't.
+// Where the CPU supports it the 4 and 8 byte types use AVX2 gathers.
+//
+// GatherNum takes a pointer to each record.
+// GatherNumStrided takes records that sit back to back nStride bytes apart starting at pRecords, which is how a
+// decompressed block of records is laid out when the RecordInfo doesn't ContainsVarData
+// (nStride is then GetFixedRecordSize).
+//
+// Unlike the rest of FieldBase these only read the field's offset and type, so they are safe to call
+// from several threads at once on the same field.
+////////////////////////////////////////////////////////////////////////////////////////
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned char* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int16_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int32_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int64_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	float* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	double* pValues,
+	unsigned char* pNulls);
+
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	unsigned char* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int16_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int32_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int64_t* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	float* pValues,
+	unsigned char* pNulls);
+RECORDLIB_EXPORT_CPP void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	double* pValues,
+	unsigned char* pNulls);
+}  // namespace SRC
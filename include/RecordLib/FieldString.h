@@ -41,6 +41,17 @@ protected:
 		m_nBufferSize = nSize;
 	}
 
+	// room for at least nSize TChars - m_pBuffer, or the current FieldScratch's
+	inline TChar* GetBuffer(unsigned nSize) const
+	{
+		if (FieldScratch* pScratch = FieldScratch::GetCurrent())
+			return pScratch->GetBuffer<TChar>(nSize);
+
+		if (m_nBufferSize < nSize)
+			Allocate(nSize);
+		return m_pBuffer;
+	}
+
 protected:
 	inline Field_String_GetSet_Buffer()
 		: m_pBuffer(NULL)
@@ -77,11 +88,10 @@ public:
 		{
 			if (sizeof(TChar) == 2)
 			{
-				if (this->m_nBufferSize <= nFieldLen)
-					this->Allocate(nFieldLen + 1);
-				memcpy(this->m_pBuffer, ToCharP(pRecord) + nOffset, nFieldLen * sizeof(TChar));
-				this->m_pBuffer[nFieldLen] = 0;
-				ret.value.pValue = this->m_pBuffer;
+				TChar* pBuffer = this->GetBuffer(nFieldLen + 1);
+				memcpy(pBuffer, ToCharP(pRecord) + nOffset, nFieldLen * sizeof(TChar));
+				pBuffer[nFieldLen] = 0;
+				ret.value.pValue = pBuffer;
 			}
 			else
 			{
@@ -172,11 +182,10 @@ public:
 			nFieldLen;  // remove warning in release
 #endif
 
-			if (this->m_nBufferSize <= ret.value.nLength)
-				this->Allocate(ret.value.nLength + 1);
-			memcpy(this->m_pBuffer, static_cast<const char*>(val.pValue), val.nLength);
-			this->m_pBuffer[ret.value.nLength] = 0;
-			ret.value.pValue = this->m_pBuffer;
+			TChar* pBuffer = this->GetBuffer(ret.value.nLength + 1);
+			memcpy(pBuffer, static_cast<const char*>(val.pValue), val.nLength);
+			pBuffer[ret.value.nLength] = 0;
+			ret.value.pValue = pBuffer;
 		}
 
 		return ret;
@@ -269,9 +278,6 @@ TFieldVal<double> ConvertStringToDoubleWithConversionErrors(
 template <E_FieldType ft, class TChar, class TStorage, bool bIsVarData>
 class T_Field_String : public FieldBase
 {
-	// a temporary spot for holding a spatial object after converting from gjson
-	mutable unsigned char* m_pSpatialObj;
-
 protected:
 	mutable TStorage m_storage;
 	mutable Tstr<TChar> m_strBuffer;
@@ -293,19 +299,19 @@ protected:
 		{
 			if (pEnd == pVal || nLen == 0)
 			{
-				if (nLen > 0 && m_pGenericEngine)
+				if (nLen > 0 && IsReportingFieldConversionErrors())
 					ReportFieldConversionError(XMSG("@1 is not a number.", ConvertToWString(pVal)));
 				return true;
 			}
 			else if (*pEnd == ',')
 			{
-				if (m_pGenericEngine)
+				if (IsReportingFieldConversionErrors())
 					ReportFieldConversionError(
 						XMSG("@1 stopped converting at a comma. It might be invalid.", ConvertToWString(pVal)));
 			}
 			else
 			{
-				if (m_pGenericEngine)
+				if (IsReportingFieldConversionErrors())
 					ReportFieldConversionError(XMSG("@1 lost information in translation", ConvertToWString(pVal)));
 			}
 		}
@@ -362,7 +368,7 @@ protected:
 			pRet[nLen] = 0;
 			strBuffer.Unlock();
 #endif
-			if (m_pGenericEngine)
+			if (IsReportingFieldConversionErrors())
 				ReportFieldConversionError(
 					XMSG("\"@1\" could not be fully converted from a WString to a String.", pVal));
 		}
@@ -377,7 +383,6 @@ public:
 			bIsVarData,
 			nFieldSize,
 			nScale)
-		, m_pSpatialObj(NULL)
 	{
 	}
 
@@ -390,14 +395,7 @@ public:
 			{ fieldSchema, fieldSchema.GetFieldName(), nFieldType, nFieldSize, nScale },
 			bIsVarData ? 4 : nFieldSize * sizeof(TChar) + 1,
 			bIsVarData)
-		, m_pSpatialObj(NULL)
-	{
-	}
-
-	virtual ~T_Field_String()
 	{
-		if (m_pSpatialObj)
-			free(m_pSpatialObj);
 	}
 
 	virtual SmartPointerRefObj<FieldBase> Copy() const
@@ -497,8 +495,9 @@ public:
 		TFieldVal<AStringVal> ret;
 
 		ret.bIsNull = val.bIsNull;
-		DoConvertString(m_astrTemp, (const U16unit*)val.value.pValue, val.value.nLength);
-		ret.value = AStringVal(m_astrTemp.Length(), m_astrTemp.c_str());
+		AString& strTemp = TempAString();
+		DoConvertString(strTemp, (const U16unit*)val.value.pValue, val.value.nLength);
+		ret.value = AStringVal(strTemp.Length(), strTemp.c_str());
 		return ret;
 	}
 
@@ -508,8 +507,9 @@ public:
 		TFieldVal<AStringVal> ret;
 
 		ret.bIsNull = val.bIsNull;
-		DoConvertString(m_astrTemp, (const U16unit*)val.value.pValue, val.value.nLength);
-		ret.value = AStringVal(m_astrTemp.Length(), m_astrTemp.c_str());
+		AString& strTemp = TempAString();
+		DoConvertString(strTemp, (const U16unit*)val.value.pValue, val.value.nLength);
+		ret.value = AStringVal(strTemp.Length(), strTemp.c_str());
 		return ret;
 	}
 
@@ -524,8 +524,9 @@ public:
 		TFieldVal<WStringVal> ret;
 
 		ret.bIsNull = val.bIsNull;
-		ConvertString(m_wstrTemp, val.value.pValue, val.value.nLength);
-		ret.value = WStringVal(m_wstrTemp.Length(), m_wstrTemp.c_str());
+		String& strTemp = TempWString();
+		ConvertString(strTemp, val.value.pValue, val.value.nLength);
+		ret.value = WStringVal(strTemp.Length(), strTemp.c_str());
 		return ret;
 	}
 #else
@@ -539,8 +540,9 @@ public:
 		TFieldVal<WStringVal> ret;
 
 		ret.bIsNull = val.bIsNull;
-		ConvertString(m_wstrTemp, val.value.pValue, static_cast<int>(val.value.nLength));
-		ret.value = WStringVal(m_wstrTemp.Length(), m_wstrTemp.c_str());
+		String& strTemp = TempWString();
+		ConvertString(strTemp, val.value.pValue, static_cast<int>(val.value.nLength));
+		ret.value = WStringVal(strTemp.Length(), strTemp.c_str());
 		return ret;
 	}
 
@@ -567,16 +569,17 @@ public:
 		{
 			try
 			{
-				if (m_pSpatialObj)
+				unsigned char*& r_pSpatialObj = TempSpatialObj();
+				if (r_pSpatialObj)
 				{
-					free(m_pSpatialObj);
-					m_pSpatialObj = NULL;
+					free(r_pSpatialObj);
+					r_pSpatialObj = NULL;
 				}
 #if !defined(SRCLIB_REPLACEMENT) && !defined(EXCLUDE_GEOJSON)
-				ConvertFromGeoJSON(val.value.pValue, &m_pSpatialObj, &len);
+				ConvertFromGeoJSON(val.value.pValue, &r_pSpatialObj, &len);
 				if (len > 0)
 				{
-					ret.value.pValue = reinterpret_cast<unsigned char*>(m_pSpatialObj);
+					ret.value.pValue = reinterpret_cast<unsigned char*>(r_pSpatialObj);
 					ret.value.nLength = len;
 					return ret;
 				}
@@ -21,6 +21,7 @@
 
 namespace SRC {
 struct RecordData;
+class RecordAllocator;
 
 class Record : public SmartPointerRefObj_Base
 {
@@ -35,6 +36,9 @@ class Record : public SmartPointerRefObj_Base
 	//		varData
 	mutable void* m_pRecord = nullptr;
 
+	// where m_pRecord comes from - see RecordInfo::CreateRecord
+	RecordAllocator* m_pAllocator = nullptr;
+
 	unsigned m_nFixedRecordSize = 0;
 	bool m_bContainsVarData = false;
 
@@ -49,7 +53,7 @@ private:
 	// this can only be created by CreateRecord in the RecordInfo
 	Record() = default;
 
-	void Init(int nFixedRecordSize, bool bContainsVarData);
+	void Init(int nFixedRecordSize, bool bContainsVarData, RecordAllocator& allocator);
 
 public:
 	E1ONLY_RECORDLIB_EXPORT_CPP int GetVarDataSize();
@@ -0,0 +1,108 @@
+// Copyright(C) 2005 - 2019 Alteryx, Inc. All rights reserved.
+// This file is distributed to Alteryx customers as part of the
+// Software Development Kit.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "RecordLibExport.h"
+
+namespace SRC {
+////////////////////////////////////////////////////////////////////////////////////////
+// class RecordAllocator
+//
+// Where a Record gets its buffer from.  Pass one to RecordInfo::CreateRecord to keep records
+// off the heap - by default they use malloc and realloc.
+// The allocator has to outlive every record created with it.
+// None of the allocators are thread safe - give each thread its own.
+////////////////////////////////////////////////////////////////////////////////////////
+class RECORDLIB_EXPORT_CPP RecordAllocator
+{
+public:
+	virtual ~RecordAllocator();
+
+	// returns NULL if it can't.  nOldSize is 0 when pOld is NULL.
+	virtual void* Reallocate(void* pOld, size_t nOldSize, size_t nNewSize) = 0;
+	virtual void Free(void* p, size_t nSize) = 0;
+
+	// malloc, realloc and free
+	static RecordAllocator& GetDefault();
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// class RecordArenaAllocator
+//
+// Bump allocates out of large chunks and never frees anything on its own - Free is a no-op and
+// everything goes at once in Reset or the destructor.  For batches of short lived records:
+// create them, use them, destroy them all and Reset before the next batch.
+////////////////////////////////////////////////////////////////////////////////////////
+class RECORDLIB_EXPORT_CPP RecordArenaAllocator : public RecordAllocator
+{
+	struct Chunk
+	{
+		char* pData;
+		size_t nSize;
+	};
+
+	const size_t m_nChunkSize;
+	std::vector<Chunk> m_vChunks;
+	size_t m_nCurrentChunk;
+	size_t m_nUsed;  // in the current chunk
+
+	// the most recent allocation, which can grow in place
+	void* m_pLast;
+
+	void* AllocateNew(size_t nSize);
+
+public:
+	explicit RecordArenaAllocator(size_t nChunkSize = 1024 * 1024);
+	~RecordArenaAllocator();
+
+	RecordArenaAllocator(const RecordArenaAllocator&) = delete;
+	RecordArenaAllocator& operator=(const RecordArenaAllocator&) = delete;
+
+	void* Reallocate(void* pOld, size_t nOldSize, size_t nNewSize) override;
+	void Free(void* p, size_t nSize) override;
+
+	// makes all the memory available again, keeping the chunks.
+	// Every record created with it has to have been destroyed first.
+	void Reset();
+
+	size_t GetBytesReserved() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// class RecordPoolAllocator
+//
+// Keeps freed buffers on a free list per power of 2 size class so the next record of about the
+// same size reuses one instead of going to malloc.  For records that come and go one at a time,
+// such as in a sort or a copy.  Buffers bigger than nMaxPooledSize go straight to malloc.
+// The cached buffers are released by Trim or the destructor.
+////////////////////////////////////////////////////////////////////////////////////////
+class RECORDLIB_EXPORT_CPP RecordPoolAllocator : public RecordAllocator
+{
+	// each free buffer holds the pointer to the next one
+	std::vector<void*> m_vFreeLists;
+	const size_t m_nMaxPooledSize;
+
+	// the size class of a buffer of nSize bytes, or -1 if it isn't pooled
+	int SizeClass(size_t nSize) const;
+
+public:
+	static const size_t MinPooledSize = 64;
+
+	explicit RecordPoolAllocator(size_t nMaxPooledSize = 64 * 1024);
+	~RecordPoolAllocator();
+
+	RecordPoolAllocator(const RecordPoolAllocator&) = delete;
+	RecordPoolAllocator& operator=(const RecordPoolAllocator&) = delete;
+
+	void* Reallocate(void* pOld, size_t nOldSize, size_t nNewSize) override;
+	void Free(void* p, size_t nSize) override;
+
+	// releases the cached buffers
+	void Trim();
+};
+}  // namespace SRC
@@ -18,6 +18,7 @@
 #endif
 
 #include "Record.h"
+#include "RecordAllocator.h"
 #include "RecordData.h"
 
 namespace SRC {
@@ -128,6 +129,8 @@ public:
 		bool bIgnoreLockIn = false);
 
 	E1ONLY_RECORDLIB_EXPORT_CPP SmartPointerRefObj<Record> CreateRecord() const;
+	// the record's buffer comes from r_allocator, which has to outlive it
+	E1ONLY_RECORDLIB_EXPORT_CPP SmartPointerRefObj<Record> CreateRecord(RecordAllocator& r_allocator) const;
 
 	RECORDLIB_EXPORT_CPP int GetFieldNum(StringNoCase strField, bool bThrowError = true) const;
 	RECORDLIB_EXPORT_CPP const FieldBase* GetFieldByName(StringNoCase strField, bool bThrowError = true) const;
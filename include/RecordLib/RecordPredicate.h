@@ -0,0 +1,133 @@
+// Copyright(C) 2005 - 2019 Alteryx, Inc. All rights reserved.
+// This file is distributed to Alteryx customers as part of the
+// Software Development Kit.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "FieldBase.h"
+#include "RecordLibExport.h"
+
+namespace SRC {
+
+////////////////////////////////////////////////////////////////////////////////////////
+// class RecordPredicate
+//
+// A filter on records, evaluated straight on the record bytes with no GetAsXxx calls and no temporary values.
+// Each test is bound to a function for its field type and comparison when it is built, so evaluating a
+// batch of records is one tight loop per test.  Build it once when the schema is known:
+//
+//		typedef RecordPredicate RP;
+//		RP pred = RP::And(
+//			RP::Compare(*recordInfo[0], RP::E_Compare_Greater, 100),
+//			RP::Or(RP::In(*recordInfo[1], std::vector<WString>{ U16("CA"), U16("NY") }), RP::IsNull(*recordInfo[2])));
+//
+// then either test one record at a time with Matches, or a whole batch (such as a RecordBlock or what
+// ReadBatch returns) with Select, which leaves the indexes of the records that pass in a selection vector.
+//
+// Null values fail every test except IsNull - NotEqual included.
+// Numbers compare as int64s, or as doubles if either side is a Float, Double or FixedDecimal.  Strings compare by
+// UTF-16 code unit, and a String (which is Latin-1) compares as if it were widened.  Date, Time and DateTime compare
+// as the strings they are stored as, which sorts them by time.  FixedDecimal compares as a number against a number
+// and as a string against a string.  Blob and SpatialObj fields can only be tested for null.
+// The tests of an And are run in the order they are given, each on just the records that passed the one before,
+// so put the most selective first.
+//
+// It holds on to the fields, so the RecordInfo has to outlive it.  Evaluating it is thread safe.
+////////////////////////////////////////////////////////////////////////////////////////
+class RECORDLIB_EXPORT_CPP RecordPredicate
+{
+public:
+	enum E_Compare
+	{
+		E_Compare_Equal,
+		E_Compare_NotEqual,
+		E_Compare_Less,
+		E_Compare_LessOrEqual,
+		E_Compare_Greater,
+		E_Compare_GreaterOrEqual
+	};
+
+	// what one test says about the values of its field, for skipping over data that can't match - such as the
+	// record blocks that the zone maps of an Open_AlteryxYXDB rule out (see Open_AlteryxYXDB::GetMatchingBlocks).
+	// It is never narrower than the test, but can be wider.  Null values are never in a range
+	struct Bound
+	{
+		enum E_Kind
+		{
+			E_Kind_IsNull,
+			E_Kind_IsNotNull,
+			// the values are in [m_nMin, m_nMax]
+			E_Kind_IntRange,
+			// the values are in [m_dMin, m_dMax]
+			E_Kind_DoubleRange,
+			// the values are no less than m_strMin if m_bHasMin, and no more than m_strMax (or start with it) if
+			// m_bHasMax, in UTF-16 code unit order
+			E_Kind_StringRange
+		};
+
+		const FieldBase* m_pField = NULL;
+		E_Kind m_eKind = E_Kind_IsNotNull;
+		int64_t m_nMin = 0;
+		int64_t m_nMax = 0;
+		double m_dMin = 0;
+		double m_dMax = 0;
+		bool m_bHasMin = false;
+		bool m_bHasMax = false;
+		WString m_strMin;
+		WString m_strMax;
+	};
+
+	struct Node;
+
+private:
+	std::shared_ptr<const Node> m_pRoot;
+
+	explicit RecordPredicate(std::shared_ptr<const Node> pRoot);
+
+public:
+	// matches every record
+	RecordPredicate();
+
+	// these throw if the field's type can't be compared to the value
+	static RecordPredicate Compare(const FieldBase& field, E_Compare eCompare, int nValue);
+	static RecordPredicate Compare(const FieldBase& field, E_Compare eCompare, int64_t nValue);
+	static RecordPredicate Compare(const FieldBase& field, E_Compare eCompare, double dValue);
+	static RecordPredicate Compare(const FieldBase& field, E_Compare eCompare, const WString& strValue);
+
+	static RecordPredicate In(const FieldBase& field, const std::vector<int64_t>& vValues);
+	static RecordPredicate In(const FieldBase& field, const std::vector<double>& vValues);
+	static RecordPredicate In(const FieldBase& field, const std::vector<WString>& vValues);
+
+	// for String, WString, V_String, V_WString, Date, Time, DateTime and FixedDecimal fields
+	static RecordPredicate StartsWith(const FieldBase& field, const WString& strPrefix);
+
+	static RecordPredicate IsNull(const FieldBase& field);
+	static RecordPredicate IsNotNull(const FieldBase& field);
+
+	static RecordPredicate And(const RecordPredicate& a, const RecordPredicate& b);
+	static RecordPredicate Or(const RecordPredicate& a, const RecordPredicate& b);
+
+	bool Matches(const RecordData* pRecord) const;
+
+	// writes the indexes of the records in ppRecords that match to pSelection, which needs room for nRecords,
+	// in order, and returns how many there are
+	size_t Select(const RecordData* const* ppRecords, size_t nRecords, uint32_t* pSelection) const;
+
+	// the same, but only looks at the nSelection records whose indexes are already in pSelection (in order),
+	// and narrows it down in place
+	size_t Refine(const RecordData* const* ppRecords, uint32_t* pSelection, size_t nSelection) const;
+
+	// the Bound of every test in the predicate
+	std::vector<const Bound*> GetBounds() const;
+
+	// false only if no record can match, given whether any value might be in each Bound.
+	// The tests are combined with And and Or as they are in the predicate
+	bool MightMatch(const std::function<bool(const Bound& bound)>& boundMightMatch) const;
+};
+}  // namespace SRC
@@ -729,10 +729,8 @@ class SmartPointerRefObj
 		if (pData)
 		{
 #ifdef __GNUG__
-			//__sync_fetch_and_add(&pData->m_SmartPointerRefObj_refCount, -1);
-			//@todo: Check this!
-			(pData->m_SmartPointerRefObj_refCount)--;
-			if ((&pData->m_SmartPointerRefObj_refCount) == 0)
+			// unlike InterlockedDecrement this returns the count from before, so 1 means this was the last reference
+			if (__atomic_fetch_sub(&pData->m_SmartPointerRefObj_refCount, 1, __ATOMIC_ACQ_REL) == 1)
 #else
 			if (InterlockedDecrement(&pData->m_SmartPointerRefObj_refCount) == 0)
 #endif
@@ -746,9 +744,7 @@ class SmartPointerRefObj
 	{
 		if (pData)
 #ifdef __GNUG__
-			//__sync_fetch_and_add(&pData->m_SmartPointerRefObj_refCount, 1);
-			//@todo: Check this!
-			(pData->m_SmartPointerRefObj_refCount)++;
+			__atomic_fetch_add(&pData->m_SmartPointerRefObj_refCount, 1, __ATOMIC_RELAXED);
 #else
 			InterlockedIncrement(&pData->m_SmartPointerRefObj_refCount);
 #endif
@@ -0,0 +1,162 @@
+#include "stdafx.h"
+
+#include "Base/BlockCache.h"
+
+namespace SRC {
+
+size_t BlockCache::KeyHash::operator()(const Key& key) const
+{
+	// the splitmix64 finalizer, folded over each part
+	uint64_t nHash = 0;
+	for (uint64_t n : { key.file.nDevice,
+						key.file.nInode,
+						uint64_t(key.file.nModifiedTime),
+						uint64_t(key.file.nSize),
+						uint64_t(key.nPos) })
+	{
+		nHash = (nHash ^ n) + 0x9e3779b97f4a7c15ull;
+		nHash = (nHash ^ (nHash >> 30)) * 0xbf58476d1ce4e5b9ull;
+		nHash = (nHash ^ (nHash >> 27)) * 0x94d049bb133111ebull;
+		nHash ^= nHash >> 31;
+	}
+	return size_t(nHash);
+}
+
+BlockCache::BlockCache(size_t nMaxBytes /*= 0*/)
+	: m_nMaxBytes(nMaxBytes)
+	, m_nBytes(0)
+	, m_nNextEvictStripe(0)
+{
+}
+
+/*static*/ BlockCache& BlockCache::Global()
+{
+	static BlockCache cache;
+	return cache;
+}
+
+BlockCache::Stripe& BlockCache::GetStripe(const Key& key)
+{
+	// the low bits pick the bucket inside the stripe's map, so use the high ones here
+	return m_stripes[(KeyHash()(key) >> 24) % NumStripes];
+}
+
+void BlockCache::Evict(Stripe& stripe, size_t nMaxBytes)
+{
+	while (m_nBytes > nMaxBytes && !stripe.m_lru.empty())
+	{
+		const auto& entry = stripe.m_lru.back();
+		const size_t nBytes = entry.second->m_vData.capacity();
+		stripe.m_nBytes -= nBytes;
+		m_nBytes -= nBytes;
+		stripe.m_map.erase(entry.first);
+		stripe.m_lru.pop_back();
+	}
+}
+
+void BlockCache::EvictOverBudget(size_t nMaxBytes)
+{
+	const unsigned nFirst = m_nNextEvictStripe++;
+	for (unsigned x = 0; x < NumStripes && m_nBytes > nMaxBytes; ++x)
+	{
+		Stripe& stripe = m_stripes[(nFirst + x) % NumStripes];
+		std::lock_guard<std::mutex> lock(stripe.m_mutex);
+		Evict(stripe, nMaxBytes);
+	}
+}
+
+void BlockCache::SetMaxBytes(size_t nMaxBytes)
+{
+	m_nMaxBytes = nMaxBytes;
+	EvictOverBudget(nMaxBytes);
+}
+
+size_t BlockCache::GetMaxBytes() const
+{
+	return m_nMaxBytes;
+}
+
+BlockCache::T_Block BlockCache::Find(const FileIdentity& file, int64_t nPos)
+{
+	const Key key{ file, nPos };
+	Stripe& stripe = GetStripe(key);
+
+	std::lock_guard<std::mutex> lock(stripe.m_mutex);
+	auto it = stripe.m_map.find(key);
+	if (it == stripe.m_map.end())
+	{
+		stripe.m_nMisses++;
+		return T_Block();
+	}
+
+	stripe.m_nHits++;
+	stripe.m_lru.splice(stripe.m_lru.begin(), stripe.m_lru, it->second);
+	return it->second->second;
+}
+
+BlockCache::T_Block BlockCache::Insert(const FileIdentity& file, int64_t nPos, T_Block pBlock)
+{
+	const Key key{ file, nPos };
+	Stripe& stripe = GetStripe(key);
+	const size_t nMaxBytes = m_nMaxBytes;
+	const size_t nBytes = pBlock->m_vData.capacity();
+
+	{
+		std::lock_guard<std::mutex> lock(stripe.m_mutex);
+		auto it = stripe.m_map.find(key);
+		if (it != stripe.m_map.end())
+		{
+			stripe.m_lru.splice(stripe.m_lru.begin(), stripe.m_lru, it->second);
+			return it->second->second;
+		}
+		if (nBytes > nMaxBytes)
+			return pBlock;
+		Evict(stripe, nMaxBytes - nBytes);
+	}
+
+	// if this stripe didn't have enough to give up, take the rest from the others.  Its mutex has to be unlocked
+	// first, since another thread may be doing the same the other way around
+	if (m_nBytes + nBytes > nMaxBytes)
+		EvictOverBudget(nMaxBytes - nBytes);
+
+	std::lock_guard<std::mutex> lock(stripe.m_mutex);
+	auto it = stripe.m_map.find(key);
+	if (it != stripe.m_map.end())
+	{
+		stripe.m_lru.splice(stripe.m_lru.begin(), stripe.m_lru, it->second);
+		return it->second->second;
+	}
+	stripe.m_lru.emplace_front(key, pBlock);
+	stripe.m_map.emplace(key, stripe.m_lru.begin());
+	stripe.m_nBytes += nBytes;
+	m_nBytes += nBytes;
+	return pBlock;
+}
+
+void BlockCache::Clear()
+{
+	for (Stripe& stripe : m_stripes)
+	{
+		std::lock_guard<std::mutex> lock(stripe.m_mutex);
+		stripe.m_map.clear();
+		stripe.m_lru.clear();
+		m_nBytes -= stripe.m_nBytes;
+		stripe.m_nBytes = 0;
+	}
+}
+
+BlockCache::Stats BlockCache::GetStats()
+{
+	Stats stats;
+	for (Stripe& stripe : m_stripes)
+	{
+		std::lock_guard<std::mutex> lock(stripe.m_mutex);
+		stats.nHits += stripe.m_nHits;
+		stats.nMisses += stripe.m_nMisses;
+		stats.nBlocks += stripe.m_lru.size();
+		stats.nBytes += stripe.m_nBytes;
+	}
+	return stats;
+}
+
+}  // namespace SRC
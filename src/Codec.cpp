@@ -0,0 +1,165 @@
+#include "stdafx.h"
+
+#include "Base/Codec.h"
+
+#include <map>
+#include <mutex>
+
+#include "Base/Lz4Block.h"
+#include "Base/LzfWrapper.h"
+
+namespace SRC {
+
+Codec::~Codec()
+{
+}
+
+/*virtual*/ const Codec& Codec::WithLevel(E_CompressionLevel /*eLevel*/) const
+{
+	return *this;
+}
+
+namespace {
+class Codec_LZF : public Codec
+{
+public:
+	const Codec& WithLevel(E_CompressionLevel eLevel) const override;
+
+	unsigned GetId() const override
+	{
+		return E_Codec_LZF;
+	}
+	const char* GetName() const override
+	{
+		return "LZF";
+	}
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return LzfWrapper::lzf_compress(pIn, nInSize, pOut, nOutSize);
+	}
+	unsigned Decompress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return LzfWrapper::lzf_decompress(pIn, nInSize, pOut, nOutSize);
+	}
+};
+
+class Codec_LZF_Fast : public Codec_LZF
+{
+public:
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return LzfWrapper::lzf_compress_fast(pIn, nInSize, pOut, nOutSize);
+	}
+};
+
+class Codec_LZF_Dense : public Codec_LZF
+{
+public:
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return LzfWrapper::lzf_compress_dense(pIn, nInSize, pOut, nOutSize);
+	}
+};
+
+const Codec& Codec_LZF::WithLevel(E_CompressionLevel eLevel) const
+{
+	static const Codec_LZF lzf;
+	static const Codec_LZF_Fast lzfFast;
+	static const Codec_LZF_Dense lzfDense;
+	switch (eLevel)
+	{
+		case E_CompressionLevel_Fast:
+			return lzfFast;
+		case E_CompressionLevel_Dense:
+			return lzfDense;
+		default:
+			return lzf;
+	}
+}
+
+class Codec_LZ4 : public Codec
+{
+public:
+	unsigned GetId() const override
+	{
+		return E_Codec_LZ4;
+	}
+	const char* GetName() const override
+	{
+		return "LZ4";
+	}
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return Lz4Block::lz4_compress(pIn, nInSize, pOut, nOutSize);
+	}
+	unsigned Decompress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return Lz4Block::lz4_decompress(pIn, nInSize, pOut, nOutSize);
+	}
+};
+
+class Codec_LZ4HC : public Codec_LZ4
+{
+public:
+	unsigned GetId() const override
+	{
+		return E_Codec_LZ4HC;
+	}
+	const char* GetName() const override
+	{
+		return "LZ4HC";
+	}
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		return Lz4Block::lz4_compress_hc(pIn, nInSize, pOut, nOutSize);
+	}
+};
+
+struct Registry
+{
+	std::mutex m_mutex;
+	std::map<unsigned, const Codec*> m_mapCodecs;
+
+	Registry()
+	{
+		static const Codec_LZF lzf;
+		static const Codec_LZ4 lz4;
+		static const Codec_LZ4HC lz4hc;
+		const Codec* const pCodecs[] = { &lzf, &lz4, &lz4hc };
+		for (const Codec* pCodec : pCodecs)
+			m_mapCodecs[pCodec->GetId()] = pCodec;
+	}
+};
+
+Registry& GetRegistry()
+{
+	static Registry registry;
+	return registry;
+}
+}  // namespace
+
+namespace CodecRegistry {
+const Codec* FindCodec(unsigned nId)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.m_mutex);
+	auto it = registry.m_mapCodecs.find(nId);
+	return it == registry.m_mapCodecs.end() ? NULL : it->second;
+}
+
+const Codec& GetCodec(unsigned nId)
+{
+	const Codec* pCodec = FindCodec(nId);
+	if (pCodec == NULL)
+		throw Error(XMSG("Unknown compression codec: @1", String(int(nId))));
+	return *pCodec;
+}
+
+void RegisterCodec(const Codec* pCodec)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.m_mutex);
+	registry.m_mapCodecs[pCodec->GetId()] = pCodec;
+}
+}  // namespace CodecRegistry
+}  // namespace SRC
@@ -0,0 +1,43 @@
+#include "stdafx.h"
+
+#include "CpuFeatures.h"
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace SRC { namespace CpuFeatures {
+
+namespace {
+bool CheckAVX2()
+{
+#if !SRC_CPU_X86
+	return false;
+#elif defined(__GNUG__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+
+	// the OS also has to save the AVX registers
+	__cpuid(info, 1);
+	const int OSXSAVE = 1 << 27, AVX = 1 << 28;
+	if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX) || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#endif
+}
+}  // namespace
+
+bool HasAVX2()
+{
+	static const bool bHasAVX2 = CheckAVX2();
+	return bHasAVX2;
+}
+
+}}  // namespace SRC::CpuFeatures
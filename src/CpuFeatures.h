@@ -0,0 +1,16 @@
+#pragma once
+
+// What the CPU this is running on supports, for picking between builds of the same code.
+// The AVX2 builds live in their own translation units (see CMakeLists.txt) and are only called after checking this.
+namespace SRC { namespace CpuFeatures {
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define SRC_CPU_X86 1
+#else
+	#define SRC_CPU_X86 0
+#endif
+
+// true if the CPU and OS both support AVX2.  Always false when not on x86.
+bool HasAVX2();
+
+}}  // namespace SRC::CpuFeatures
@@ -5,6 +5,43 @@
 #include "RecordLib/FieldTypes.h"
 
 namespace SRC {
+namespace {
+thread_local FieldScratch* t_pCurrentScratch = nullptr;
+}  // namespace
+
+FieldScratch::FieldScratch()
+	: m_nConversionErrorCount(0)
+	, m_pSpatialObj(NULL)
+{
+}
+
+FieldScratch::~FieldScratch()
+{
+	if (m_pSpatialObj)
+		free(m_pSpatialObj);
+}
+
+/*static*/ FieldScratch* FieldScratch::GetCurrent()
+{
+	return t_pCurrentScratch;
+}
+
+unsigned FieldScratch::GetConversionErrorCount() const
+{
+	return m_nConversionErrorCount;
+}
+
+FieldScratch::Scope::Scope(FieldScratch& scratch)
+	: m_pPrevious(t_pCurrentScratch)
+{
+	t_pCurrentScratch = &scratch;
+}
+
+FieldScratch::Scope::~Scope()
+{
+	t_pCurrentScratch = m_pPrevious;
+}
+
 FieldBase::FieldBase(
 	const StringNoCase& strFieldName,
 	E_FieldType ft,
@@ -14,6 +51,7 @@ FieldBase::FieldBase(
 	int nScale)
 	: FieldSchema(strFieldName, ft, nSize, nScale)
 	, m_nOffset(0)
+	, m_pSpatialObj(NULL)
 	, m_pGenericEngine(nullptr)
 	, m_nFieldConversionErrorCount(0)
 	, m_nRawSize(nRawSize)
@@ -24,6 +62,7 @@ FieldBase::FieldBase(
 FieldBase::FieldBase(const FieldSchema& fieldSchema, const int nRawSize, bool bIsVarLength)
 	: FieldSchema(fieldSchema)
 	, m_nOffset(0)
+	, m_pSpatialObj(NULL)
 	, m_pGenericEngine(nullptr)
 	, m_nFieldConversionErrorCount(0)
 	, m_nRawSize(nRawSize)
@@ -33,6 +72,8 @@ FieldBase::FieldBase(const FieldSchema& fieldSchema, const int nRawSize, bool bI
 
 FieldBase::~FieldBase()
 {
+	if (m_pSpatialObj)
+		free(m_pSpatialObj);
 }
 
 FieldBase* FieldBase::CopyHelper(FieldBase* p) const
@@ -49,6 +90,15 @@ void FieldBase::ReportFieldConversionError(const String::TChar* pMessage) const
 	// we've printed too many conversion errors. You can tell by calling
 	// IsReportingFieldConversionErrors(), and spare the expense of constructing a
 	// nice message string.
+
+	// m_pGenericEngine and the count can't be touched by a reentrant getter, which counts its
+	// errors in its scratch whether or not there is an engine
+	if (FieldScratch* pScratch = FieldScratch::GetCurrent())
+	{
+		pScratch->m_nConversionErrorCount++;
+		return;
+	}
+
 	if (m_pGenericEngine)
 	{
 		m_pGenericEngine->OutputMessage(
@@ -247,7 +297,55 @@ const GenericEngineBase* FieldBase::GetGenericEngine() const
 
 bool FieldBase::IsReportingFieldConversionErrors() const
 {
-	return m_pGenericEngine != nullptr;
+	return m_pGenericEngine != nullptr || FieldScratch::GetCurrent() != nullptr;
+}
+
+TFieldVal<bool> FieldBase::GetAsBoolReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsBool(pRecord);
+}
+
+TFieldVal<int> FieldBase::GetAsInt32Reentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsInt32(pRecord);
+}
+
+TFieldVal<int64_t> FieldBase::GetAsInt64Reentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsInt64(pRecord);
+}
+
+TFieldVal<double> FieldBase::GetAsDoubleReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsDouble(pRecord);
+}
+
+TFieldVal<AStringVal> FieldBase::GetAsAStringReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsAString(pRecord);
+}
+
+TFieldVal<WStringVal> FieldBase::GetAsWStringReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsWString(pRecord);
+}
+
+TFieldVal<BlobVal> FieldBase::GetAsBlobReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsBlob(pRecord);
+}
+
+TFieldVal<BlobVal> FieldBase::GetAsSpatialBlobReentrant(const RecordData* pRecord, FieldScratch& r_scratch) const
+{
+	FieldScratch::Scope scope(r_scratch);
+	return GetAsSpatialBlob(pRecord);
 }
 
 // explicitly instantiate all the template types
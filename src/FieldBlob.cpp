@@ -23,34 +23,35 @@ namespace SRC {
 {
 	TFieldVal<BlobVal> blob = GetAsBlob(pRecord);
 	TFieldVal<AStringVal> ret(true, AStringVal(0u, ""));
+	AString& strTemp = TempAString();
 	if (!blob.bIsNull)
 	{
 		if (m_ft == E_FT_SpatialObj)
 		{
 #if defined(SRCLIB_REPLACEMENT) || defined(EXCLUDE_GEOJSON)
-			m_astrTemp = "SpatialObject";
+			strTemp = "SpatialObject";
 #else
 			char* achTemp = ConvertToGeoJSON(blob.value.pValue, blob.value.nLength);
 			if (achTemp)
 			{
-				m_astrTemp = achTemp;
+				strTemp = achTemp;
 				free(achTemp);
 			}
 			else
-				m_astrTemp = "[Null]";
+				strTemp = "[Null]";
 #endif
 		}
 		else
 		{
 			// the old SDK does not have an unsigned int string::assign function
-			m_astrTemp.Assign(static_cast<int64_t>(blob.value.nLength));
-			m_astrTemp += " Bytes";
+			strTemp.Assign(static_cast<int64_t>(blob.value.nLength));
+			strTemp += " Bytes";
 		}
 		ret.bIsNull = false;
 	}
 	else
-		m_astrTemp = "[Null]";
-	ret.value = AStringVal(m_astrTemp.Length(), m_astrTemp.c_str());
+		strTemp = "[Null]";
+	ret.value = AStringVal(strTemp.Length(), strTemp.c_str());
 	return ret;
 }
 
@@ -58,34 +59,35 @@ namespace SRC {
 {
 	TFieldVal<BlobVal> blob = GetAsBlob(pRecord);
 	TFieldVal<WStringVal> ret(true, WStringVal(0u, _U("")));
+	String& strTemp = TempWString();
 	if (!blob.bIsNull)
 	{
 		if (m_ft == E_FT_SpatialObj)
 		{
 #if defined(SRCLIB_REPLACEMENT) || defined(EXCLUDE_GEOJSON)
-			m_wstrTemp = _U("SpatialObject");
+			strTemp = _U("SpatialObject");
 #else
 			char* achTemp = ConvertToGeoJSON(blob.value.pValue, blob.value.nLength);
 			if (achTemp)
 			{
-				m_wstrTemp = ConvertToWString(achTemp);
+				strTemp = ConvertToWString(achTemp);
 				free(achTemp);
 			}
 			else
-				m_wstrTemp = U16("[Null]");
+				strTemp = U16("[Null]");
 #endif
 		}
 		else
 		{
 			// the old SDK does not have an unsigned int string::assign function
-			m_wstrTemp.Assign(static_cast<int64_t>(blob.value.nLength));
-			m_wstrTemp += U16(" Bytes");
+			strTemp.Assign(static_cast<int64_t>(blob.value.nLength));
+			strTemp += U16(" Bytes");
 		}
 		ret.bIsNull = false;
 	}
 	else
-		m_wstrTemp = _U("[Null]");
-	ret.value = WStringVal(m_wstrTemp.Length(), m_wstrTemp.c_str());
+		strTemp = _U("[Null]");
+	ret.value = WStringVal(strTemp.Length(), strTemp.c_str());
 	return ret;
 }
 
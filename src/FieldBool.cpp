@@ -31,8 +31,9 @@ TFieldVal<AStringVal> Field_Bool::GetAsAString(const RecordData* pRecord) const
 	TFieldVal<AStringVal> ret(true, AStringVal(0u, ""));
 	if (!val.bIsNull)
 	{
-		m_astrTemp = val.value ? "True" : "False";
-		ret.value = AStringVal(m_astrTemp.Length(), m_astrTemp.c_str());
+		AString& strTemp = TempAString();
+		strTemp = val.value ? "True" : "False";
+		ret.value = AStringVal(strTemp.Length(), strTemp.c_str());
 		ret.bIsNull = false;
 	}
 	return ret;
@@ -44,8 +45,9 @@ TFieldVal<WStringVal> Field_Bool::GetAsWString(const RecordData* pRecord) const
 	TFieldVal<WStringVal> ret(true, WStringVal(0u, _U("")));
 	if (!val.bIsNull)
 	{
-		m_wstrTemp = val.value ? _U("True") : _U("False");
-		ret.value = WStringVal(m_wstrTemp.Length(), m_wstrTemp.c_str());
+		String& strTemp = TempWString();
+		strTemp = val.value ? _U("True") : _U("False");
+		ret.value = WStringVal(strTemp.Length(), strTemp.c_str());
 		ret.bIsNull = false;
 	}
 	return ret;
@@ -0,0 +1,214 @@
+#include "stdafx.h"
+
+#include "RecordLib/FieldNumBatch.h"
+
+#include "RecordLib/FieldBase.h"
+#include "RecordLib/RecordData.h"
+
+#include "CpuFeatures.h"
+#include "FieldNumBatch_AVX2.h"
+
+namespace SRC {
+
+namespace {
+// the null flag follows the value - see Field_Num::GetVal
+template <class T_Num>
+inline void GatherOne(const char* pField, T_Num& r_value, unsigned char& r_null)
+{
+	r_null = pField[sizeof(T_Num)] != 0 ? 1 : 0;
+	if (r_null)
+		r_value = T_Num(0);
+	else
+		memcpy(&r_value, pField, sizeof(T_Num));
+}
+
+void CheckType(const FieldBase& field, E_FieldType ft, const char* pFunction)
+{
+	if (field.m_ft != ft)
+		throw Error(XMSG(
+			"@1: Field type @2 is not @3.",
+			ConvertToWString(pFunction),
+			GetNameFromFieldType(field.m_ft),
+			GetNameFromFieldType(ft)));
+}
+
+template <E_FieldType ft, class T_Num>
+void Gather(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	T_Num* pValues,
+	unsigned char* pNulls)
+{
+	CheckType(field, ft, "GatherNum");
+	const unsigned nOffset = unsigned(field.GetOffset());
+
+	size_t x = 0;
+#if FIELDNUMBATCH_AVX2
+	if (CpuFeatures::HasAVX2())
+	{
+		if (sizeof(T_Num) == 4)
+			x = FieldNumBatch::Gather4_AVX2(ppRecords, nRecords, nOffset, pValues, pNulls);
+		else if (sizeof(T_Num) == 8)
+			x = FieldNumBatch::Gather8_AVX2(ppRecords, nRecords, nOffset, pValues, pNulls);
+	}
+#endif
+	for (; x < nRecords; ++x)
+		GatherOne(ToCharP(ppRecords[x]) + nOffset, pValues[x], pNulls[x]);
+}
+
+template <E_FieldType ft, class T_Num>
+void GatherStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	T_Num* pValues,
+	unsigned char* pNulls)
+{
+	CheckType(field, ft, "GatherNumStrided");
+	const char* const pFirst = static_cast<const char*>(pRecords) + field.GetOffset();
+
+	size_t x = 0;
+#if FIELDNUMBATCH_AVX2
+	// the gathers take 32 bit indexes
+	if (CpuFeatures::HasAVX2() && nStride <= 0x0fffffff)
+	{
+		if (sizeof(T_Num) == 4)
+			x = FieldNumBatch::GatherStrided4_AVX2(pFirst, nStride, nRecords, pValues, pNulls);
+		else if (sizeof(T_Num) == 8)
+			x = FieldNumBatch::GatherStrided8_AVX2(pFirst, nStride, nRecords, pValues, pNulls);
+	}
+#endif
+	for (; x < nRecords; ++x)
+		GatherOne(pFirst + x * nStride, pValues[x], pNulls[x]);
+}
+}  // namespace
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned char* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Byte>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int16_t* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Int16>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int32_t* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Int32>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	int64_t* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Int64>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	float* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Float>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNum(
+	const FieldBase& field,
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	double* pValues,
+	unsigned char* pNulls)
+{
+	Gather<E_FT_Double>(field, ppRecords, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	unsigned char* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Byte>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int16_t* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Int16>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int32_t* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Int32>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	int64_t* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Int64>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	float* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Float>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+void GatherNumStrided(
+	const FieldBase& field,
+	const void* pRecords,
+	size_t nStride,
+	size_t nRecords,
+	double* pValues,
+	unsigned char* pNulls)
+{
+	GatherStrided<E_FT_Double>(field, pRecords, nStride, nRecords, pValues, pNulls);
+}
+
+}  // namespace SRC
@@ -0,0 +1,155 @@
+// The AVX2 build of the GatherNum kernels.  This file is compiled with AVX2 enabled (see CMakeLists.txt),
+// so like LzfDecompress_AVX2.cpp it deliberately doesn't use stdafx.h - nothing with external linkage other than
+// the functions in FieldNumBatch_AVX2.h may come out of it.
+//
+// The null flag is the byte after the value (see Field_Num::GetVal).  It is gathered as the top byte of the 4 bytes
+// ending with it, which for 4 and 8 byte values are all inside the field, so nothing outside a record is read.
+
+#include "FieldNumBatch_AVX2.h"
+
+#if FIELDNUMBATCH_AVX2
+
+	#include <immintrin.h>
+
+	#include <cstring>
+
+namespace {
+// 4 null flags from the top bytes of vRaw, as all ones for null and 0 otherwise
+inline __m128i NullMask4(__m128i vRaw)
+{
+	return _mm_xor_si128(_mm_cmpeq_epi32(_mm_srli_epi32(vRaw, 24), _mm_setzero_si128()), _mm_set1_epi32(-1));
+}
+
+inline __m256i NullMask8(__m256i vRaw)
+{
+	return _mm256_xor_si256(
+		_mm256_cmpeq_epi32(_mm256_srli_epi32(vRaw, 24), _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+}
+
+// stores the low byte of each 32 bit null mask as 0 or 1
+inline void StoreNulls4(unsigned char* pNulls, __m128i vMask)
+{
+	__m128i vFlags = _mm_and_si128(vMask, _mm_set1_epi32(1));
+	vFlags = _mm_packs_epi32(vFlags, vFlags);
+	vFlags = _mm_packus_epi16(vFlags, vFlags);
+	int nFlags = _mm_cvtsi128_si32(vFlags);
+	memcpy(pNulls, &nFlags, 4);
+}
+
+inline void StoreNulls8(unsigned char* pNulls, __m256i vMask)
+{
+	__m256i vFlags = _mm256_and_si256(vMask, _mm256_set1_epi32(1));
+	__m128i v16 = _mm_packs_epi32(_mm256_castsi256_si128(vFlags), _mm256_extracti128_si256(vFlags, 1));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(pNulls), _mm_packus_epi16(v16, v16));
+}
+
+// the addresses of the fields in 4 records, which are used as the gather indexes with no base
+inline __m256i FieldAddresses(const void* const* ppRecords, unsigned nOffset)
+{
+	return _mm256_add_epi64(
+		_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ppRecords)), _mm256_set1_epi64x(nOffset));
+}
+}  // namespace
+
+namespace SRC { namespace FieldNumBatch {
+
+size_t Gather4_AVX2(
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned nOffset,
+	void* pValues,
+	unsigned char* pNulls)
+{
+	const int* const pBase = NULL;
+	size_t x = 0;
+	for (; x + 4 <= nRecords; x += 4)
+	{
+		const __m256i vAddresses = FieldAddresses(reinterpret_cast<const void* const*>(ppRecords + x), nOffset);
+		const __m128i vValues = _mm256_i64gather_epi32(pBase, vAddresses, 1);
+		const __m128i vNulls =
+			NullMask4(_mm256_i64gather_epi32(pBase, _mm256_add_epi64(vAddresses, _mm256_set1_epi64x(1)), 1));
+
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(static_cast<int*>(pValues) + x), _mm_andnot_si128(vNulls, vValues));
+		StoreNulls4(pNulls + x, vNulls);
+	}
+	return x;
+}
+
+size_t Gather8_AVX2(
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned nOffset,
+	void* pValues,
+	unsigned char* pNulls)
+{
+	const long long* const pBase = NULL;
+	size_t x = 0;
+	for (; x + 4 <= nRecords; x += 4)
+	{
+		const __m256i vAddresses = FieldAddresses(reinterpret_cast<const void* const*>(ppRecords + x), nOffset);
+		const __m256i vValues = _mm256_i64gather_epi64(pBase, vAddresses, 1);
+		const __m128i vNulls = NullMask4(_mm256_i64gather_epi32(
+			reinterpret_cast<const int*>(pBase), _mm256_add_epi64(vAddresses, _mm256_set1_epi64x(5)), 1));
+
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(static_cast<long long*>(pValues) + x),
+			_mm256_andnot_si256(_mm256_cvtepi32_epi64(vNulls), vValues));
+		StoreNulls4(pNulls + x, vNulls);
+	}
+	return x;
+}
+
+size_t GatherStrided4_AVX2(
+	const char* pFirst,
+	size_t nStride,
+	size_t nRecords,
+	void* pValues,
+	unsigned char* pNulls)
+{
+	const int nStride32 = int(nStride);
+	const __m256i vIndexes =
+		_mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(nStride32));
+	size_t x = 0;
+	for (; x + 8 <= nRecords; x += 8)
+	{
+		const char* pField = pFirst + x * nStride;
+		const __m256i vValues = _mm256_i32gather_epi32(reinterpret_cast<const int*>(pField), vIndexes, 1);
+		const __m256i vNulls =
+			NullMask8(_mm256_i32gather_epi32(reinterpret_cast<const int*>(pField + 1), vIndexes, 1));
+
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(static_cast<int*>(pValues) + x), _mm256_andnot_si256(vNulls, vValues));
+		StoreNulls8(pNulls + x, vNulls);
+	}
+	return x;
+}
+
+size_t GatherStrided8_AVX2(
+	const char* pFirst,
+	size_t nStride,
+	size_t nRecords,
+	void* pValues,
+	unsigned char* pNulls)
+{
+	const int nStride32 = int(nStride);
+	const __m128i vIndexes = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(nStride32));
+	size_t x = 0;
+	for (; x + 4 <= nRecords; x += 4)
+	{
+		const char* pField = pFirst + x * nStride;
+		const __m256i vValues = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(pField), vIndexes, 1);
+		const __m128i vNulls =
+			NullMask4(_mm_i32gather_epi32(reinterpret_cast<const int*>(pField + 5), vIndexes, 1));
+
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(static_cast<long long*>(pValues) + x),
+			_mm256_andnot_si256(_mm256_cvtepi32_epi64(vNulls), vValues));
+		StoreNulls4(pNulls + x, vNulls);
+	}
+	return x;
+}
+
+}}  // namespace SRC::FieldNumBatch
+
+#endif
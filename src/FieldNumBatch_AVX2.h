@@ -0,0 +1,48 @@
+#pragma once
+
+// The AVX2 kernels behind GatherNum and GatherNumStrided, in FieldNumBatch_AVX2.cpp.
+// FieldNumBatch.cpp only calls them after checking the CPU supports AVX2.
+// Each does as many whole vectors as fit in nRecords and returns how many records that was, leaving the rest
+// to the caller.  The 4 byte ones are for Int32 and Float, the 8 byte ones for Int64 and Double.
+
+#include <cstddef>
+
+// the pointer gathers need 64 bit pointers
+#if defined(__x86_64__) || defined(_M_X64)
+	#define FIELDNUMBATCH_AVX2 1
+#else
+	#define FIELDNUMBATCH_AVX2 0
+#endif
+
+namespace SRC {
+struct RecordData;
+
+namespace FieldNumBatch {
+size_t Gather4_AVX2(
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned nOffset,
+	void* pValues,
+	unsigned char* pNulls);
+size_t Gather8_AVX2(
+	const RecordData* const* ppRecords,
+	size_t nRecords,
+	unsigned nOffset,
+	void* pValues,
+	unsigned char* pNulls);
+
+// pFirst is the field in the first record
+size_t GatherStrided4_AVX2(
+	const char* pFirst,
+	size_t nStride,
+	size_t nRecords,
+	void* pValues,
+	unsigned char* pNulls);
+size_t GatherStrided8_AVX2(
+	const char* pFirst,
+	size_t nStride,
+	size_t nRecords,
+	void* pValues,
+	unsigned char* pNulls);
+}  // namespace FieldNumBatch
+}  // namespace SRC
@@ -0,0 +1,336 @@
+#include "stdafx.h"
+
+#include "Base/Lz4Block.h"
+
+#include <cstring>
+#include <vector>
+
+namespace SRC { namespace Lz4Block {
+
+namespace {
+const unsigned MinMatch = 4;
+
+// the format requires the last 5 bytes to be literals, and the last match to start at least 12 bytes from the end
+const unsigned LastLiterals = 5;
+const unsigned MatchFindLimit = 12;
+
+const unsigned MaxOffset = 0xffff;
+
+inline uint32_t Read32(const unsigned char* p)
+{
+	uint32_t n;
+	memcpy(&n, p, sizeof(n));
+	return n;
+}
+
+template <unsigned HashLog>
+inline unsigned Hash(uint32_t n)
+{
+	return (n * 2654435761u) >> (32 - HashLog);
+}
+
+// writes the compressed output, refusing to go past the end of the output buffer
+class Writer
+{
+	unsigned char* m_pOut;
+	unsigned char* m_pOutEnd;
+
+public:
+	unsigned char* const m_pStart;
+
+	Writer(void* pOut, unsigned nOutSize)
+		: m_pOut(static_cast<unsigned char*>(pOut))
+		, m_pOutEnd(static_cast<unsigned char*>(pOut) + nOutSize)
+		, m_pStart(static_cast<unsigned char*>(pOut))
+	{
+	}
+
+	unsigned Size() const
+	{
+		return unsigned(m_pOut - m_pStart);
+	}
+
+	// returns false if it doesn't fit
+	bool Sequence(const unsigned char* pLiterals, unsigned nLiterals, unsigned nOffset, unsigned nMatchLen)
+	{
+		// worst case: token + literal length + literals + offset + match length
+		size_t nMaxSize = 1 + nLiterals / 255 + 1 + nLiterals + 2 + (nMatchLen / 255 + 1);
+		if (size_t(m_pOutEnd - m_pOut) < nMaxSize)
+			return false;
+
+		unsigned char* pToken = m_pOut++;
+		unsigned nLen = nLiterals;
+		if (nLen >= 15)
+		{
+			*pToken = 15 << 4;
+			for (nLen -= 15; nLen >= 255; nLen -= 255)
+				*m_pOut++ = 255;
+			*m_pOut++ = static_cast<unsigned char>(nLen);
+		}
+		else
+			*pToken = static_cast<unsigned char>(nLen << 4);
+		if (nLiterals != 0)
+			memcpy(m_pOut, pLiterals, nLiterals);
+		m_pOut += nLiterals;
+
+		// the last sequence is just literals
+		if (nMatchLen == 0)
+			return true;
+
+		*m_pOut++ = static_cast<unsigned char>(nOffset);
+		*m_pOut++ = static_cast<unsigned char>(nOffset >> 8);
+		nLen = nMatchLen - MinMatch;
+		if (nLen >= 15)
+		{
+			*pToken |= 15;
+			for (nLen -= 15; nLen >= 255; nLen -= 255)
+				*m_pOut++ = 255;
+			*m_pOut++ = static_cast<unsigned char>(nLen);
+		}
+		else
+			*pToken |= static_cast<unsigned char>(nLen);
+		return true;
+	}
+};
+
+inline unsigned MatchLength(const unsigned char* p, const unsigned char* pMatch, const unsigned char* pLimit)
+{
+	const unsigned char* pStart = p;
+	while (p < pLimit && *p == *pMatch)
+	{
+		++p;
+		++pMatch;
+	}
+	return unsigned(p - pStart);
+}
+}  // namespace
+
+unsigned int lz4_compress(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	const unsigned HashLog = 14;
+
+	const unsigned char* const pIn = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pInEnd = pIn + in_len;
+	Writer out(out_data, out_len);
+
+	const unsigned char* pAnchor = pIn;
+	if (in_len > MatchFindLimit)
+	{
+		const unsigned char* const pMatchLimit = pInEnd - LastLiterals;
+		const unsigned char* const pFindLimit = pInEnd - MatchFindLimit;
+
+		std::vector<uint32_t> vHashTable(size_t(1) << HashLog, 0);
+		const unsigned char* p = pIn + 1;
+		vHashTable[Hash<HashLog>(Read32(pIn))] = 0;
+
+		// the longer we go without finding a match, the faster we skip through the data
+		unsigned nSearches = 1 << 6;
+		while (p < pFindLimit)
+		{
+			uint32_t n = Read32(p);
+			uint32_t& nEntry = vHashTable[Hash<HashLog>(n)];
+			const unsigned char* pMatch = pIn + nEntry;
+			nEntry = uint32_t(p - pIn);
+			if (pMatch >= p || unsigned(p - pMatch) > MaxOffset || Read32(pMatch) != n)
+			{
+				p += nSearches++ >> 6;
+				continue;
+			}
+			nSearches = 1 << 6;
+
+			// extend the match backwards over the pending literals
+			while (p > pAnchor && pMatch > pIn && p[-1] == pMatch[-1])
+			{
+				--p;
+				--pMatch;
+			}
+
+			unsigned nMatchLen = MinMatch + MatchLength(p + MinMatch, pMatch + MinMatch, pMatchLimit);
+			if (!out.Sequence(pAnchor, unsigned(p - pAnchor), unsigned(p - pMatch), nMatchLen))
+				return 0;
+
+			p += nMatchLen;
+			pAnchor = p;
+			if (p < pFindLimit)
+				vHashTable[Hash<HashLog>(Read32(p - 2))] = uint32_t(p - 2 - pIn);
+		}
+	}
+
+	if (!out.Sequence(pAnchor, unsigned(pInEnd - pAnchor), 0, 0))
+		return 0;
+	return out.Size();
+}
+
+unsigned int lz4_compress_hc(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len,
+	unsigned nMaxAttempts /*= 256*/)
+{
+	const unsigned HashLog = 15;
+	const unsigned ChainSize = MaxOffset + 1;
+
+	const unsigned char* const pIn = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pInEnd = pIn + in_len;
+	Writer out(out_data, out_len);
+
+	const unsigned char* pAnchor = pIn;
+	if (in_len > MatchFindLimit)
+	{
+		const unsigned char* const pMatchLimit = pInEnd - LastLiterals;
+		const unsigned char* const pFindLimit = pInEnd - MatchFindLimit;
+
+		// vHead is the last position with each hash, and vChain the distance from each position
+		// back to the previous one with the same hash
+		std::vector<int32_t> vHead(size_t(1) << HashLog, -1);
+		std::vector<uint16_t> vChain(ChainSize, 0);
+		unsigned nNextToInsert = 0;
+
+		auto Insert = [&](unsigned nUpTo) {
+			for (; nNextToInsert < nUpTo; ++nNextToInsert)
+			{
+				int32_t& nHead = vHead[Hash<HashLog>(Read32(pIn + nNextToInsert))];
+				unsigned nDelta = nHead < 0 ? 0 : nNextToInsert - unsigned(nHead);
+				vChain[nNextToInsert & (ChainSize - 1)] = uint16_t(nDelta > MaxOffset ? 0 : nDelta);
+				nHead = int32_t(nNextToInsert);
+			}
+		};
+
+		// finds the longest match for p, returns its length (0 for none) and sets r_pMatch
+		auto FindLongest = [&](const unsigned char* p, const unsigned char*& r_pMatch) -> unsigned {
+			unsigned nPos = unsigned(p - pIn);
+			Insert(nPos);
+			unsigned nBest = 0;
+			int32_t nCandidate = vHead[Hash<HashLog>(Read32(p))];
+			for (unsigned nAttempts = 0; nCandidate >= 0 && nAttempts < nMaxAttempts; ++nAttempts)
+			{
+				if (nPos - unsigned(nCandidate) > MaxOffset)
+					break;
+
+				const unsigned char* pCandidate = pIn + nCandidate;
+				if (pCandidate[nBest] == p[nBest] && Read32(pCandidate) == Read32(p))
+				{
+					unsigned nLen = MinMatch + MatchLength(p + MinMatch, pCandidate + MinMatch, pMatchLimit);
+					if (nLen > nBest)
+					{
+						nBest = nLen;
+						r_pMatch = pCandidate;
+						if (p + nLen >= pMatchLimit)
+							break;
+					}
+				}
+
+				uint16_t nDelta = vChain[unsigned(nCandidate) & (ChainSize - 1)];
+				if (nDelta == 0)
+					break;
+				nCandidate -= nDelta;
+			}
+			return nBest;
+		};
+
+		const unsigned char* p = pIn;
+		while (p < pFindLimit)
+		{
+			const unsigned char* pMatch = nullptr;
+			unsigned nMatchLen = FindLongest(p, pMatch);
+			if (nMatchLen < MinMatch)
+			{
+				++p;
+				continue;
+			}
+
+			// lazy matching - if the next position has a longer match, emit this byte as a literal instead
+			while (p + 1 < pFindLimit)
+			{
+				const unsigned char* pNextMatch = nullptr;
+				unsigned nNextLen = FindLongest(p + 1, pNextMatch);
+				if (nNextLen <= nMatchLen)
+					break;
+				++p;
+				nMatchLen = nNextLen;
+				pMatch = pNextMatch;
+			}
+
+			if (!out.Sequence(pAnchor, unsigned(p - pAnchor), unsigned(p - pMatch), nMatchLen))
+				return 0;
+
+			p += nMatchLen;
+			pAnchor = p;
+		}
+	}
+
+	if (!out.Sequence(pAnchor, unsigned(pInEnd - pAnchor), 0, 0))
+		return 0;
+	return out.Size();
+}
+
+unsigned int lz4_decompress(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pEnd = p + in_len;
+	unsigned char* const pOutStart = static_cast<unsigned char*>(out_data);
+	unsigned char* pOut = pOutStart;
+	unsigned char* const pOutEnd = pOutStart + out_len;
+
+	// reads an extended length.  Returns false on running off the end of the input
+	auto ReadLength = [&](size_t& r_nLen) -> bool {
+		unsigned char c;
+		do
+		{
+			if (p >= pEnd)
+				return false;
+			c = *p++;
+			r_nLen += c;
+		} while (c == 255);
+		return true;
+	};
+
+	while (p < pEnd)
+	{
+		const unsigned char nToken = *p++;
+
+		size_t nLiterals = nToken >> 4;
+		if (nLiterals == 15 && !ReadLength(nLiterals))
+			return 0;
+		if (size_t(pEnd - p) < nLiterals || size_t(pOutEnd - pOut) < nLiterals)
+			return 0;
+		memcpy(pOut, p, nLiterals);
+		p += nLiterals;
+		pOut += nLiterals;
+
+		// the last sequence has no match
+		if (p == pEnd)
+			break;
+
+		if (pEnd - p < 2)
+			return 0;
+		unsigned nOffset = p[0] | (unsigned(p[1]) << 8);
+		p += 2;
+		if (nOffset == 0 || nOffset > size_t(pOut - pOutStart))
+			return 0;
+
+		size_t nMatchLen = nToken & 15;
+		if (nMatchLen == 15 && !ReadLength(nMatchLen))
+			return 0;
+		nMatchLen += MinMatch;
+		if (size_t(pOutEnd - pOut) < nMatchLen)
+			return 0;
+
+		const unsigned char* pMatch = pOut - nOffset;
+		if (nOffset >= nMatchLen)
+		{
+			memcpy(pOut, pMatch, nMatchLen);
+			pOut += nMatchLen;
+		}
+		else
+		{
+			// the match overlaps what it is writing, so it has to go a byte at a time
+			for (size_t x = 0; x < nMatchLen; ++x)
+				*pOut++ = *pMatch++;
+		}
+	}
+	return unsigned(pOut - pOutStart);
+}
+
+}}  // namespace SRC::Lz4Block
@@ -0,0 +1,276 @@
+#include "stdafx.h"
+
+#include "Base/LzfWrapper.h"
+
+#include <cstring>
+#include <vector>
+
+// The faster and denser LZF compressors.  Both write standard LZF, so anything that can read lzf_c.c's
+// output can read theirs.
+namespace SRC { namespace LzfWrapper {
+
+namespace {
+const unsigned MinMatch = 3;
+const unsigned MaxMatch = (1 << 8) + (1 << 3);  // 264
+const unsigned MaxDistance = 1 << 13;           // 8192
+const unsigned MaxLiterals = 1 << 5;            // 32
+
+// the 3 bytes at p, in the low bits.  There has to be a 4th byte after them, which every caller
+// guarantees by only looking for matches up to MinMatch bytes before the end.  Like the file format, this
+// assumes little endian.
+inline uint32_t Read24(const unsigned char* p)
+{
+	uint32_t n;
+	memcpy(&n, p, sizeof(n));
+	return n & 0xffffff;
+}
+
+template <unsigned HashLog>
+inline unsigned Hash(uint32_t n)
+{
+	return (n * 2654435761u) >> (32 - HashLog);
+}
+
+// writes the compressed output, refusing to go past the end of the output buffer
+class Writer
+{
+	unsigned char* m_pOut;
+	unsigned char* m_pOutEnd;
+	unsigned char* const m_pStart;
+
+public:
+	Writer(void* pOut, unsigned nOutSize)
+		: m_pOut(static_cast<unsigned char*>(pOut))
+		, m_pOutEnd(static_cast<unsigned char*>(pOut) + nOutSize)
+		, m_pStart(static_cast<unsigned char*>(pOut))
+	{
+	}
+
+	unsigned Size() const
+	{
+		return unsigned(m_pOut - m_pStart);
+	}
+
+	// returns false if it doesn't fit
+	bool Literals(const unsigned char* p, unsigned nLen)
+	{
+		while (nLen != 0)
+		{
+			unsigned nRun = nLen < MaxLiterals ? nLen : MaxLiterals;
+			if (size_t(m_pOutEnd - m_pOut) < 1 + nRun)
+				return false;
+			*m_pOut++ = static_cast<unsigned char>(nRun - 1);
+			memcpy(m_pOut, p, nRun);
+			m_pOut += nRun;
+			p += nRun;
+			nLen -= nRun;
+		}
+		return true;
+	}
+
+	// nLen is MinMatch to MaxMatch, nDistance 1 to MaxDistance
+	bool Match(unsigned nDistance, unsigned nLen)
+	{
+		if (size_t(m_pOutEnd - m_pOut) < 3)
+			return false;
+
+		const unsigned nOff = nDistance - 1;
+		nLen -= 2;
+		if (nLen < 7)
+			*m_pOut++ = static_cast<unsigned char>((nOff >> 8) + (nLen << 5));
+		else
+		{
+			*m_pOut++ = static_cast<unsigned char>((nOff >> 8) + (7 << 5));
+			*m_pOut++ = static_cast<unsigned char>(nLen - 7);
+		}
+		*m_pOut++ = static_cast<unsigned char>(nOff);
+		return true;
+	}
+};
+
+inline unsigned MatchLength(const unsigned char* p, const unsigned char* pMatch, const unsigned char* pLimit)
+{
+	const unsigned char* pStart = p;
+	while (size_t(pLimit - p) >= sizeof(uint64_t))
+	{
+		uint64_t a, b;
+		memcpy(&a, p, sizeof(a));
+		memcpy(&b, pMatch, sizeof(b));
+		if (a != b)
+			break;
+		p += sizeof(uint64_t);
+		pMatch += sizeof(uint64_t);
+	}
+	while (p < pLimit && *p == *pMatch)
+	{
+		++p;
+		++pMatch;
+	}
+	return unsigned(p - pStart);
+}
+
+inline const unsigned char* MatchLimit(const unsigned char* p, const unsigned char* pInEnd)
+{
+	return size_t(pInEnd - p) > MaxMatch ? p + MaxMatch : pInEnd;
+}
+}  // namespace
+
+unsigned int lzf_compress_fast(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	const unsigned HashLog = 13;
+
+	if (in_len == 0 || out_len == 0)
+		return 0;
+
+	const unsigned char* const pIn = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pInEnd = pIn + in_len;
+	Writer out(out_data, out_len);
+
+	const unsigned char* pAnchor = pIn;
+	if (in_len > MinMatch)
+	{
+		const unsigned char* const pFindLimit = pInEnd - MinMatch;
+
+		// empty entries point at the start, which is checked like any other candidate
+		std::vector<uint32_t> vHashTable(size_t(1) << HashLog, 0);
+
+		// the longer we go without finding a match, the faster we skip through the data
+		unsigned nSearches = 1 << 5;
+		const unsigned char* p = pIn;
+		while (p < pFindLimit)
+		{
+			uint32_t n = Read24(p);
+			uint32_t& nEntry = vHashTable[Hash<HashLog>(n)];
+			const unsigned char* pMatch = pIn + nEntry;
+			nEntry = uint32_t(p - pIn);
+			if (unsigned(p - pMatch) - 1 >= MaxDistance || Read24(pMatch) != n)
+			{
+				p += nSearches++ >> 5;
+				continue;
+			}
+			nSearches = 1 << 5;
+
+			unsigned nMatchLen = MinMatch + MatchLength(p + MinMatch, pMatch + MinMatch, MatchLimit(p, pInEnd));
+			if (!out.Literals(pAnchor, unsigned(p - pAnchor)) || !out.Match(unsigned(p - pMatch), nMatchLen))
+				return 0;
+
+			p += nMatchLen;
+			pAnchor = p;
+			if (p < pFindLimit)
+				vHashTable[Hash<HashLog>(Read24(p - 1))] = uint32_t(p - 1 - pIn);
+		}
+	}
+
+	if (!out.Literals(pAnchor, unsigned(pInEnd - pAnchor)))
+		return 0;
+	return out.Size();
+}
+
+unsigned int lzf_compress_dense(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len,
+	unsigned nMaxAttempts /*= 64*/)
+{
+	const unsigned HashLog = 17;
+
+	if (in_len == 0 || out_len == 0)
+		return 0;
+
+	const unsigned char* const pIn = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pInEnd = pIn + in_len;
+	Writer out(out_data, out_len);
+
+	const unsigned char* pAnchor = pIn;
+	if (in_len > MinMatch)
+	{
+		const unsigned char* const pFindLimit = pInEnd - MinMatch;
+
+		// vHead is the last position with each hash, and vChain the distance from each position
+		// back to the previous one with the same hash
+		std::vector<int32_t> vHead(size_t(1) << HashLog, -1);
+		std::vector<uint16_t> vChain(MaxDistance, 0);
+		unsigned nNextToInsert = 0;
+
+		auto Insert = [&](unsigned nUpTo) {
+			for (; nNextToInsert < nUpTo; ++nNextToInsert)
+			{
+				int32_t& nHead = vHead[Hash<HashLog>(Read24(pIn + nNextToInsert))];
+				unsigned nDelta = nHead < 0 ? 0 : nNextToInsert - unsigned(nHead);
+				vChain[nNextToInsert & (MaxDistance - 1)] = uint16_t(nDelta >= MaxDistance ? 0 : nDelta);
+				nHead = int32_t(nNextToInsert);
+			}
+		};
+
+		// finds the longest match for p, returns its length (0 for none) and sets r_pMatch
+		auto FindLongest = [&](const unsigned char* p, const unsigned char*& r_pMatch) -> unsigned {
+			const unsigned nPos = unsigned(p - pIn);
+			const unsigned char* const pLimit = MatchLimit(p, pInEnd);
+			const unsigned nMaxLen = unsigned(pLimit - p);
+			Insert(nPos);
+			unsigned nBest = 0;
+			int32_t nCandidate = vHead[Hash<HashLog>(Read24(p))];
+			for (unsigned nAttempts = 0; nCandidate >= 0 && nAttempts < nMaxAttempts; ++nAttempts)
+			{
+				if (nPos - unsigned(nCandidate) > MaxDistance)
+					break;
+
+				const unsigned char* pCandidate = pIn + nCandidate;
+				if ((nBest == 0 || pCandidate[nBest] == p[nBest]) && Read24(pCandidate) == Read24(p))
+				{
+					unsigned nLen = MinMatch + MatchLength(p + MinMatch, pCandidate + MinMatch, pLimit);
+					if (nLen > nBest)
+					{
+						nBest = nLen;
+						r_pMatch = pCandidate;
+						if (nLen == nMaxLen)
+							break;
+					}
+				}
+
+				uint16_t nDelta = vChain[unsigned(nCandidate) & (MaxDistance - 1)];
+				if (nDelta == 0)
+					break;
+				nCandidate -= nDelta;
+			}
+			return nBest;
+		};
+
+		const unsigned char* p = pIn;
+		while (p < pFindLimit)
+		{
+			const unsigned char* pMatch = NULL;
+			unsigned nMatchLen = FindLongest(p, pMatch);
+			if (nMatchLen < MinMatch)
+			{
+				++p;
+				continue;
+			}
+
+			// lazy matching - if the next position has a longer match, emit this byte as a literal instead
+			while (p + 1 < pFindLimit)
+			{
+				const unsigned char* pNextMatch = NULL;
+				unsigned nNextLen = FindLongest(p + 1, pNextMatch);
+				if (nNextLen <= nMatchLen)
+					break;
+				++p;
+				nMatchLen = nNextLen;
+				pMatch = pNextMatch;
+			}
+
+			if (!out.Literals(pAnchor, unsigned(p - pAnchor)) || !out.Match(unsigned(p - pMatch), nMatchLen))
+				return 0;
+
+			p += nMatchLen;
+			pAnchor = p;
+		}
+	}
+
+	if (!out.Literals(pAnchor, unsigned(pInEnd - pAnchor)))
+		return 0;
+	return out.Size();
+}
+
+}}  // namespace SRC::LzfWrapper
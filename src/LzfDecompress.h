@@ -0,0 +1,176 @@
+#pragma once
+
+// The wide copy LZF decompressor shared by LzfWrapper.cpp and LzfDecompress_AVX2.cpp.
+// This is only included by those, and everything here has internal linkage so the AVX2 build of it
+// can never be picked by the linker in place of the plain one.
+//
+// The output is identical to lzf_d.c, including which streams are rejected, but it copies literal
+// runs and matches in TChunk::Size byte chunks.  Chunks may write past the end of the current run
+// as long as they stay inside the output buffer - those bytes are overwritten by what comes next.
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define LZF_DECOMPRESS_X86 1
+	#include <immintrin.h>
+#else
+	#define LZF_DECOMPRESS_X86 0
+#endif
+
+namespace {
+namespace LzfDecompress {
+
+// 16 byte copies.  SSE2 is always there on x64, elsewhere memcpy turns into whatever the platform has
+struct Chunk16
+{
+	static const unsigned Size = 16;
+	static inline void Copy(unsigned char* pDest, const unsigned char* pSrc)
+	{
+#if LZF_DECOMPRESS_X86
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDest), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc)));
+#else
+		memcpy(pDest, pSrc, Size);
+#endif
+	}
+};
+
+// copies nLen bytes rounded up to 16, or to TChunk::Size if it is more than 16.
+// pSrc has to be at least that far behind pOut.
+template <class TChunk>
+inline void CopyChunks(unsigned char* pOut, const unsigned char* pSrc, unsigned nLen)
+{
+	if (nLen <= Chunk16::Size)
+		Chunk16::Copy(pOut, pSrc);
+	else
+	{
+		for (unsigned x = 0; x < nLen; x += TChunk::Size)
+			TChunk::Copy(pOut + x, pSrc + x);
+	}
+}
+
+// copies a match that may overlap what it is writing
+template <class TChunk>
+inline void CopyMatch(unsigned char* pOut, const unsigned char* pRef, unsigned nLen, const unsigned char* pOutEnd)
+{
+	unsigned char* const pEnd = pOut + nLen;
+	const size_t nDistance = size_t(pOut - pRef);
+
+	// the common case of a short match that isn't near the end of the output
+	if (nLen <= Chunk16::Size && nDistance >= Chunk16::Size && size_t(pOutEnd - pOut) >= Chunk16::Size)
+	{
+		Chunk16::Copy(pOut, pRef);
+		return;
+	}
+
+	if (nDistance == 1)
+	{
+		memset(pOut, *pRef, nLen);
+		return;
+	}
+
+	// the output repeats every (pOut - pRef) bytes, so copying from pRef once that many bytes are written
+	// doubles the distance each time without changing the result.  Stop once it is at least a chunk.
+	while (size_t(pOut - pRef) < TChunk::Size && pOut < pEnd)
+	{
+		size_t nCopy = size_t(pOut - pRef);
+		if (nCopy > size_t(pEnd - pOut))
+			nCopy = size_t(pEnd - pOut);
+		memcpy(pOut, pRef, nCopy);
+		pOut += nCopy;
+	}
+	if (pOut >= pEnd)
+		return;
+
+	nLen = unsigned(pEnd - pOut);
+	if (size_t(pOutEnd - pOut) >= ((size_t(nLen) + TChunk::Size - 1) & ~size_t(TChunk::Size - 1)))
+	{
+		// the distance is at least a chunk, so every chunk only reads bytes that are already written
+		CopyChunks<TChunk>(pOut, pRef, nLen);
+	}
+	else if (size_t(pOut - pRef) >= nLen)
+		memcpy(pOut, pRef, nLen);
+	else
+	{
+		// too close to the end of the output for whole chunks
+		for (const unsigned char* pSrc = pRef; pOut < pEnd;)
+			*pOut++ = *pSrc++;
+	}
+}
+
+template <class TChunk>
+inline unsigned Decompress(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	const unsigned char* ip = static_cast<const unsigned char*>(in_data);
+	const unsigned char* const pInEnd = ip + in_len;
+	unsigned char* const pOutStart = static_cast<unsigned char*>(out_data);
+	unsigned char* op = pOutStart;
+	unsigned char* const pOutEnd = pOutStart + out_len;
+
+	while (ip < pInEnd)
+	{
+		unsigned ctrl = *ip++;
+		if (ctrl < (1 << 5))
+		{
+			// literal run of 1 to 32 bytes
+			unsigned nLen = ctrl + 1;
+			if (size_t(pOutEnd - op) < nLen)
+			{
+				errno = E2BIG;
+				return 0;
+			}
+			if (size_t(pInEnd - ip) < nLen)
+			{
+				errno = EINVAL;
+				return 0;
+			}
+
+			if (size_t(pInEnd - ip) >= 32 && size_t(pOutEnd - op) >= 32)
+				CopyChunks<TChunk>(op, ip, nLen);
+			else
+				memcpy(op, ip, nLen);
+			op += nLen;
+			ip += nLen;
+		}
+		else
+		{
+			// back reference of 3 to 264 bytes up to 8K back
+			unsigned nLen = ctrl >> 5;
+			if (ip >= pInEnd)
+			{
+				errno = EINVAL;
+				return 0;
+			}
+			if (nLen == 7)
+			{
+				nLen += *ip++;
+				if (ip >= pInEnd)
+				{
+					errno = EINVAL;
+					return 0;
+				}
+			}
+			nLen += 2;
+			size_t nOffset = ((size_t(ctrl) & 0x1f) << 8) + *ip++ + 1;
+
+			if (size_t(pOutEnd - op) < nLen)
+			{
+				errno = E2BIG;
+				return 0;
+			}
+			if (size_t(op - pOutStart) < nOffset)
+			{
+				errno = EINVAL;
+				return 0;
+			}
+
+			CopyMatch<TChunk>(op, op - nOffset, nLen, pOutEnd);
+			op += nLen;
+		}
+	}
+	return unsigned(op - pOutStart);
+}
+
+}  // namespace LzfDecompress
+}  // namespace
@@ -0,0 +1,29 @@
+// The AVX2 build of the wide copy LZF decompressor.  This file is compiled with AVX2 enabled (see CMakeLists.txt),
+// so it deliberately doesn't use stdafx.h - nothing with external linkage other than lzf_decompress_avx2
+// may come out of it, since it would crash on a machine without AVX2.
+// LzfWrapper only calls it after checking the CPU supports it.
+
+#include "LzfDecompress.h"
+
+#if LZF_DECOMPRESS_X86
+
+namespace {
+struct Chunk32
+{
+	static const unsigned Size = 32;
+	static inline void Copy(unsigned char* pDest, const unsigned char* pSrc)
+	{
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(pDest), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc)));
+	}
+};
+}  // namespace
+
+namespace SRC { namespace LzfWrapper {
+unsigned int lzf_decompress_avx2(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	return LzfDecompress::Decompress<Chunk32>(in_data, in_len, out_data, out_len);
+}
+}}  // namespace SRC::LzfWrapper
+
+#endif
@@ -7,16 +7,107 @@ extern "C"
 #include "lzf.h"
 }
 
+#include <atomic>
+
+#include "CpuFeatures.h"
+#include "LzfDecompress.h"
+
 namespace SRC { namespace LzfWrapper {
 
+#if LZF_DECOMPRESS_X86
+// in LzfDecompress_AVX2.cpp
+unsigned int lzf_decompress_avx2(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len);
+#endif
+
+namespace {
+typedef unsigned int (*DecompressFn)(const void* const, unsigned int, void*, unsigned int);
+
+unsigned int lzf_decompress_sse2(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	return LzfDecompress::Decompress<LzfDecompress::Chunk16>(in_data, in_len, out_data, out_len);
+}
+
+DecompressFn GetDecompressFn(E_LzfDecompressor eDecompressor)
+{
+	switch (eDecompressor)
+	{
+		case E_LzfDecompressor_Reference:
+			return &::lzf_decompress;
+		case E_LzfDecompressor_SSE2:
+			return &lzf_decompress_sse2;
+		case E_LzfDecompressor_AVX2:
+#if LZF_DECOMPRESS_X86
+			return &lzf_decompress_avx2;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+struct Selected
+{
+	std::atomic<E_LzfDecompressor> m_eDecompressor;
+	std::atomic<DecompressFn> m_pDecompress;
+
+	Selected()
+		: m_eDecompressor(GetBestDecompressor())
+		, m_pDecompress(GetDecompressFn(m_eDecompressor))
+	{
+	}
+};
+
+Selected& GetSelected()
+{
+	static Selected selected;
+	return selected;
+}
+}  // namespace
+
 unsigned int lzf_compress(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
 {
 	return ::lzf_compress(in_data, in_len, out_data, out_len);
 }
 
 unsigned int lzf_decompress(const void* const in_data, unsigned int in_len, void* out_data, unsigned int out_len)
+{
+	return GetSelected().m_pDecompress.load(std::memory_order_relaxed)(in_data, in_len, out_data, out_len);
+}
+
+unsigned int lzf_decompress_reference(
+	const void* const in_data,
+	unsigned int in_len,
+	void* out_data,
+	unsigned int out_len)
 {
 	return ::lzf_decompress(in_data, in_len, out_data, out_len);
 }
 
+E_LzfDecompressor GetBestDecompressor()
+{
+	static const E_LzfDecompressor eBest = CpuFeatures::HasAVX2() ? E_LzfDecompressor_AVX2 : E_LzfDecompressor_SSE2;
+	return eBest;
+}
+
+E_LzfDecompressor SetDecompressor(E_LzfDecompressor eDecompressor)
+{
+	if (eDecompressor == E_LzfDecompressor_AVX2 && GetBestDecompressor() != E_LzfDecompressor_AVX2)
+		eDecompressor = GetBestDecompressor();
+	DecompressFn pDecompress = GetDecompressFn(eDecompressor);
+	if (pDecompress == NULL)
+	{
+		eDecompressor = GetBestDecompressor();
+		pDecompress = GetDecompressFn(eDecompressor);
+	}
+
+	Selected& selected = GetSelected();
+	selected.m_pDecompress = pDecompress;
+	selected.m_eDecompressor = eDecompressor;
+	return eDecompressor;
+}
+
+E_LzfDecompressor GetDecompressor()
+{
+	return GetSelected().m_eDecompressor;
+}
+
 }}  // namespace SRC::LzfWrapper
@@ -9,11 +9,13 @@
 #include <sys/stat.h>
 
 #ifdef __GNUG__
+	#include <sys/mman.h>  // for mmap
 	#include <unistd.h>  // for close
 	#ifndef O_BINARY
 		#define O_BINARY 0
 	#endif
 #else
+	#include <Windows.h>
 	#include <io.h>
 	#define _LARGEFILE_SOURCE
 	#define _LARGEFILE64_SOURCE
@@ -23,6 +25,9 @@ namespace Alteryx { namespace OpenYXDB {
 
 File_Large::File_Large()
 	: m_iFileDescriptor(-1)
+#ifndef __GNUG__
+	, m_hReadAt(NULL)
+#endif
 {
 }
 
@@ -33,6 +38,13 @@ File_Large::~File_Large()
 
 void File_Large::Close()
 {
+#ifndef __GNUG__
+	if (m_hReadAt != NULL)
+	{
+		CloseHandle(reinterpret_cast<HANDLE>(m_hReadAt));
+		m_hReadAt = NULL;
+	}
+#endif
 	if (m_iFileDescriptor != -1)
 	{
 #ifdef __GNUG__
@@ -61,6 +73,19 @@ void File_Large::OpenForRead(WString strFile)
 	{
 		File_Large::GetAndThrowError(U16("Error in OpenForRead: "));
 	}
+
+#ifndef __GNUG__
+	HANDLE hReadAt = ReOpenFile(reinterpret_cast<HANDLE>(_get_osfhandle(m_iFileDescriptor)),
+								GENERIC_READ,
+								FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+								FILE_FLAG_OVERLAPPED);
+	if (hReadAt == INVALID_HANDLE_VALUE)
+	{
+		Close();
+		throw Error(U16("Error in OpenForRead: The file can't be opened for ReadAt"));
+	}
+	m_hReadAt = hReadAt;
+#endif
 }
 
 void File_Large::OpenForWrite(WString strFile)
@@ -81,6 +106,36 @@ void File_Large::OpenForWrite(WString strFile)
 		File_Large::GetAndThrowError(U16("Error in OpenForWrite: "));
 }
 
+FileIdentity File_Large::GetIdentity() const
+{
+	FileIdentity identity;
+#ifdef __GNUG__
+	struct stat fileStat;
+	if (fstat(m_iFileDescriptor, &fileStat) != 0)
+		File_Large::GetAndThrowError(U16("Error in GetIdentity: "));
+	identity.nDevice = uint64_t(fileStat.st_dev);
+	identity.nInode = uint64_t(fileStat.st_ino);
+	#ifdef __APPLE__
+	identity.nModifiedTime = int64_t(fileStat.st_mtimespec.tv_sec) * 1000000000 + fileStat.st_mtimespec.tv_nsec;
+	#else
+	identity.nModifiedTime = int64_t(fileStat.st_mtim.tv_sec) * 1000000000 + fileStat.st_mtim.tv_nsec;
+	#endif
+	identity.nSize = int64_t(fileStat.st_size);
+#else
+	// the CRT's st_ino is always 0, so ask Windows for the file index instead
+	BY_HANDLE_FILE_INFORMATION info;
+	HANDLE hFile = reinterpret_cast<HANDLE>(_get_osfhandle(m_iFileDescriptor));
+	if (hFile == INVALID_HANDLE_VALUE || !GetFileInformationByHandle(hFile, &info))
+		throw Error(U16("Error in GetIdentity: The file information isn't available"));
+	identity.nDevice = info.dwVolumeSerialNumber;
+	identity.nInode = (uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+	identity.nModifiedTime =
+		int64_t((uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) | info.ftLastWriteTime.dwLowDateTime);
+	identity.nSize = int64_t((uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow);
+#endif
+	return identity;
+}
+
 int64_t File_Large::Tell() const
 {
 	int64_t seekPos = 0;
@@ -125,6 +180,58 @@ unsigned File_Large::Read(void* _pBuffer, unsigned nNumBytesToRead)
 	return ret;
 }
 
+void File_Large::ReadAt(int64_t nPos, void* _pBuffer, size_t nNumBytesToRead) const
+{
+	char* pBuffer = static_cast<char*>(_pBuffer);
+
+#ifdef __GNUG__
+	while (nNumBytesToRead > 0)
+	{
+		ssize_t ret = pread(m_iFileDescriptor, pBuffer, nNumBytesToRead, nPos);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			File_Large::GetAndThrowError(U16("Error in ReadAt: Unexpected number of bytes to read"));
+
+		pBuffer += ret;
+		nPos += ret;
+		nNumBytesToRead -= size_t(ret);
+	}
+#else
+	if (m_hReadAt == NULL)
+		throw Error(U16("Error in ReadAt: The file isn't open for reading"));
+
+	// each read gets its own event, since several threads can be waiting on the handle at once
+	HANDLE hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+	if (hEvent == NULL)
+		throw Error(U16("Error in ReadAt: Unable to create an event"));
+
+	while (nNumBytesToRead > 0)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = DWORD(uint64_t(nPos));
+		overlapped.OffsetHigh = DWORD(uint64_t(nPos) >> 32);
+		overlapped.hEvent = hEvent;
+
+		DWORD nChunk = DWORD(std::min<size_t>(nNumBytesToRead, 0x40000000));
+		DWORD nRead = 0;
+		bool bOk = ReadFile(reinterpret_cast<HANDLE>(m_hReadAt), pBuffer, nChunk, NULL, &overlapped) ||
+				   GetLastError() == ERROR_IO_PENDING;
+		bOk = bOk && GetOverlappedResult(reinterpret_cast<HANDLE>(m_hReadAt), &overlapped, &nRead, TRUE) && nRead != 0;
+		if (!bOk)
+		{
+			CloseHandle(hEvent);
+			throw Error(U16("Error in ReadAt: Unexpected number of bytes to read"));
+		}
+
+		pBuffer += nRead;
+		nPos += nRead;
+		nNumBytesToRead -= size_t(nRead);
+	}
+	CloseHandle(hEvent);
+#endif
+}
+
 unsigned File_Large::Write(const void* _pBuffer, unsigned nNumBytesToWrite)
 {
 	unsigned ret = 0;
@@ -149,6 +256,153 @@ unsigned File_Large::Write(const void* _pBuffer, unsigned nNumBytesToWrite)
 	throw Error(strErrorIntro + errorMsg);
 }
 
+File_Mapped::File_Mapped()
+	: m_pData(nullptr)
+	, m_nSize(0)
+	, m_nPos(0)
+#ifndef __GNUG__
+	, m_hMapping(nullptr)
+#endif
+{
+}
+
+File_Mapped::~File_Mapped()
+{
+	Close();
+}
+
+void File_Mapped::Unmap()
+{
+	if (m_pData)
+	{
+#ifdef __GNUG__
+		munmap(const_cast<unsigned char*>(m_pData), size_t(m_nSize));
+#else
+		UnmapViewOfFile(m_pData);
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+#endif
+		m_pData = nullptr;
+	}
+}
+
+void File_Mapped::Close()
+{
+	Unmap();
+	m_file.Close();
+	m_nSize = 0;
+	m_nPos = 0;
+	m_vGetBuffer.clear();
+	m_vGetBuffer.shrink_to_fit();
+}
+
+void File_Mapped::OpenForRead(WString strFile, bool bMemoryMap /*= true*/)
+{
+	Close();
+	m_file.OpenForRead(strFile);
+	if (!bMemoryMap)
+		return;
+
+	// any failure from here on just leaves us reading through m_file
+#ifdef __GNUG__
+	struct stat fileStat;
+	if (fstat(m_file.m_iFileDescriptor, &fileStat) != 0 || fileStat.st_size <= 0
+		|| uint64_t(fileStat.st_size) > std::numeric_limits<size_t>::max())
+		return;
+
+	void* pData = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_SHARED, m_file.m_iFileDescriptor, 0);
+	if (pData == MAP_FAILED)
+		return;
+
+	// we mostly scan front to back, so let the kernel read ahead aggressively
+	madvise(pData, size_t(fileStat.st_size), MADV_SEQUENTIAL);
+
+	m_nSize = fileStat.st_size;
+	m_pData = static_cast<const unsigned char*>(pData);
+#else
+	HANDLE hFile = reinterpret_cast<HANDLE>(_get_osfhandle(m_file.m_iFileDescriptor));
+	LARGE_INTEGER nFileSize;
+	if (hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(hFile, &nFileSize) || nFileSize.QuadPart <= 0
+		|| uint64_t(nFileSize.QuadPart) > std::numeric_limits<size_t>::max())
+		return;
+
+	m_hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_hMapping == nullptr)
+		return;
+
+	m_pData = static_cast<const unsigned char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData == nullptr)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+		return;
+	}
+	m_nSize = nFileSize.QuadPart;
+#endif
+	m_nPos = 0;
+}
+
+int64_t File_Mapped::Tell() const
+{
+	if (!m_pData)
+		return m_file.Tell();
+
+	return m_nPos;
+}
+
+void File_Mapped::LSeek(int64_t nPos)
+{
+	if (!m_pData)
+		return m_file.LSeek(nPos);
+
+	if (nPos < 0)
+		throw Error(U16("Error in LSeek: Invalid argument"));
+	m_nPos = nPos;
+}
+
+unsigned File_Mapped::Read(void* _pBuffer, unsigned nNumBytesToRead)
+{
+	if (!m_pData)
+		return m_file.Read(_pBuffer, nNumBytesToRead);
+
+	memcpy(_pBuffer, Get(nNumBytesToRead), nNumBytesToRead);
+	return nNumBytesToRead;
+}
+
+const void* File_Mapped::Get(unsigned nNumBytes)
+{
+	if (!m_pData)
+	{
+		if (m_vGetBuffer.size() < nNumBytes)
+			m_vGetBuffer.resize(nNumBytes);
+		m_file.Read(m_vGetBuffer.data(), nNumBytes);
+		return m_vGetBuffer.data();
+	}
+
+	if (m_nPos > m_nSize || nNumBytes > m_nSize - m_nPos)
+		throw Error(U16("Error in Read: Unexpected number of bytes to read"));
+
+	const void* pRet = m_pData + m_nPos;
+	m_nPos += nNumBytes;
+	return pRet;
+}
+
+const void* File_Mapped::GetAt(int64_t nPos, size_t nNumBytes, std::vector<unsigned char>& vBuffer) const
+{
+	if (!m_pData)
+	{
+		if (vBuffer.size() < nNumBytes)
+			vBuffer.resize(nNumBytes);
+		m_file.ReadAt(nPos, vBuffer.data(), nNumBytes);
+		return vBuffer.data();
+	}
+
+	if (nPos < 0 || nPos > m_nSize || int64_t(nNumBytes) > m_nSize - nPos)
+		throw Error(U16("Error in ReadAt: Unexpected number of bytes to read"));
+
+	return m_pData + nPos;
+}
+
 Open_AlteryxYXDB::~Open_AlteryxYXDB()
 {
 	try
@@ -167,12 +421,40 @@ Open_AlteryxYXDB::~Open_AlteryxYXDB()
 		if (m_bCreateMode)
 		{
 			m_pCompressOutput->FlushBuffer();
+			for (RecordOffsetIndexEntry& entry : m_vRecordOffsetIndex)
+				entry.nLzfBlockPos = m_pCompressOutput->GetBlockPositions()[size_t(entry.nLzfBlockPos)];
+			m_pCompressOutput.reset();
 			m_header.userHdr.nNumRecords = m_nCurrentRecord;
 
 			// even if there is only 1 record this should be created
 			//assert(m_vRecordBlockIndexPos.size()>0);
 			m_header.userHdr.nRecordBlockIndexPos = m_pFile->Tell();
-			m_header.userHdr.nCompressionVersion = 1;
+			m_header.userHdr.nCompressionVersion = int(m_nCodecId);
+			WriteIndex(m_vRecordBlockIndexPos);
+
+			m_header.extHdr.nMagic = HeaderExtensionMagic;
+			m_header.extHdr.nVersion = HeaderExtensionVersion;
+			if (m_nLzfBlockSize != DefaultLzfBlockSize)
+				m_header.extHdr.nLzfBlockSize = m_nLzfBlockSize;
+			if (m_nDenseIndexInterval != 0)
+			{
+				m_header.extHdr.nDenseIndexInterval = m_nDenseIndexInterval;
+				m_header.extHdr.nDenseIndexPos = m_pFile->Tell();
+				WriteIndex(m_vDenseIndexPos);
+			}
+			if (m_nRecordOffsetIndexInterval != 0)
+			{
+				m_header.extHdr.nRecordOffsetIndexInterval = m_nRecordOffsetIndexInterval;
+				m_header.extHdr.nRecordOffsetIndexPos = m_pFile->Tell();
+				unsigned nSize = unsigned(m_vRecordOffsetIndex.size());
+				m_pFile->Write(&nSize, sizeof(nSize));
+				if (nSize != 0)
+					m_pFile->Write(m_vRecordOffsetIndex.data(), unsigned(nSize * sizeof(RecordOffsetIndexEntry)));
+			}
+			if (m_nSpatialIndexField >= 0)
+				WriteSpatialIndex();
+			if (!m_vZoneMapFields.empty())
+				WriteZoneMaps();
 
 			m_pFile->LSeek(0);
 			m_pFile->Write(&m_header, sizeof(m_header));
@@ -183,6 +465,33 @@ Open_AlteryxYXDB::~Open_AlteryxYXDB()
 
 		m_pFile.reset();
 	}
+	if (m_pInFile)
+	{
+		m_pCompressInput.reset();
+		m_pInFile->Close();
+		m_pInFile.reset();
+	}
+
+	m_bCreateMode = false;
+	m_nCurrentRecord = 0;
+	m_vRecordBlockIndexPos.clear();
+	m_vDenseIndexPos.clear();
+	m_vRecordOffsetIndex.clear();
+	m_nSpatialIndexField = -1;
+	m_bSpatialIndexLoaded = false;
+	m_spatialIndex.Clear();
+	m_bZoneMapsLoaded = false;
+	m_vZoneMapFields.clear();
+	m_vZoneMaps.clear();
+	m_vZoneMapRegisters.clear();
+}
+
+void Open_AlteryxYXDB::WriteIndex(const std::vector<int64_t>& vIndex)
+{
+	unsigned nSize = unsigned(vIndex.size());
+	m_pFile->Write(&nSize, sizeof(nSize));
+	if (nSize != 0)
+		m_pFile->Write(vIndex.data(), unsigned(nSize * sizeof(int64_t)));
 }
 
 /*virtual*/ void Open_AlteryxYXDB::Create(WString strFile, const U16unit* pRecordInfoXml)
@@ -190,6 +499,8 @@ Open_AlteryxYXDB::~Open_AlteryxYXDB()
 	m_pFile.reset(new File_Large());
 	m_pFile->OpenForWrite(strFile);
 
+	m_header = Header();
+
 	m_bCreateMode = true;
 
 	m_header.userHdr.nMetaInfoLen = TStrLen(pRecordInfoXml) + 1;  // +1 to write the NULL terminator for convenience
@@ -197,45 +508,350 @@ Open_AlteryxYXDB::~Open_AlteryxYXDB()
 	m_pFile->Write(pRecordInfoXml, (m_header.userHdr.nMetaInfoLen) * sizeof(U16unit));
 
 	m_pCompressOutput = std::make_unique<LZFBufferedOutput<File_Large*, GenericEngineBase>>(
-		this->m_recordInfo.GetGenericEngine(), m_pFile.get());
+		this->m_recordInfo.GetGenericEngine(),
+		m_pFile.get(),
+		m_nCompressionThreads,
+		&CodecRegistry::GetCodec(m_nCodecId).WithLevel(m_eCompressionLevel),
+		m_nLzfBlockSize);
+	if (m_nRecordOffsetIndexInterval != 0)
+		m_pCompressOutput->TrackBlockPositions(m_pFile->Tell());
 
+	// InitFromXml adds to whatever fields are already there, so start fresh in case this object is being reused
+	m_recordInfo = RecordInfo();
 	m_recordInfo.InitFromXml(pRecordInfoXml);
 	m_pRecord = m_recordInfo.CreateRecord();
+
+	m_nSpatialIndexField = m_bWriteSpatialIndex ? FindSpatialField(m_nWriteSpatialIndexField) : -1;
+	m_spatialIndex.Clear();
+	StartZoneMaps();
 }
 
-/*virtual*/ void Open_AlteryxYXDB::AppendRecord(const RecordData* pRec)
+void Open_AlteryxYXDB::StartAppendRecord()
 {
 	if ((m_nCurrentRecord % RecordsPerBlock) == 0)
 	{
 		m_pCompressOutput->FlushBuffer();
 		m_vRecordBlockIndexPos.push_back(m_pFile->Tell());
 	}
+	if (m_nDenseIndexInterval != 0 && (m_nCurrentRecord % m_nDenseIndexInterval) == 0)
+	{
+		m_pCompressOutput->FlushBuffer();
+		m_vDenseIndexPos.push_back(m_pFile->Tell());
+	}
+	if (m_nRecordOffsetIndexInterval != 0 && (m_nCurrentRecord % m_nRecordOffsetIndexInterval) == 0)
+	{
+		RecordOffsetIndexEntry entry;
+		entry.nLzfBlockPos = int64_t(m_pCompressOutput->GetBlockNum());
+		entry.nOffset = m_pCompressOutput->GetBlockOffset();
+		entry.nReserved = 0;
+		m_vRecordOffsetIndex.push_back(entry);
+	}
+}
+
+void Open_AlteryxYXDB::IndexRecord(int64_t nRecord, const RecordData* pRec)
+{
+	if (m_nSpatialIndexField >= 0)
+		IndexSpatialRecord(pRec);
+	if (!m_vZoneMapFields.empty())
+		AddZoneMapRecord(nRecord, pRec);
+}
+
+unsigned Open_AlteryxYXDB::GetAppendInterval() const
+{
+	// they are all powers of 2, so every multiple of the smallest is where any of them might start
+	unsigned nInterval = RecordsPerBlock;
+	if (m_nDenseIndexInterval != 0)
+		nInterval = std::min(nInterval, m_nDenseIndexInterval);
+	if (m_nRecordOffsetIndexInterval != 0)
+		nInterval = std::min(nInterval, m_nRecordOffsetIndexInterval);
+	return nInterval;
+}
+
+void Open_AlteryxYXDB::WriteRecordBytes(const char* pBytes, size_t nSize)
+{
+	while (nSize > 0)
+	{
+		unsigned nWrite = unsigned(std::min<size_t>(nSize, 0x40000000));
+		m_pCompressOutput->Write(pBytes, nWrite);
+		pBytes += nWrite;
+		nSize -= nWrite;
+	}
+}
 
+/*virtual*/ void Open_AlteryxYXDB::AppendRecord(const RecordData* pRec)
+{
+	StartAppendRecord();
 	m_recordInfo.Write(*m_pCompressOutput, pRec);
+	if (IndexesRecords())
+		IndexRecord(m_nCurrentRecord, pRec);
 	m_nCurrentRecord++;
 }
 
+void Open_AlteryxYXDB::AppendRecords(const RecordData* const* ppRecords, size_t nRecords)
+{
+	if (!m_pCompressOutput)
+		throw Error(U16("Open_AlteryxYXDB::AppendRecords: The file is not open for writing"));
+
+	const unsigned nFixedRecordSize = unsigned(m_recordInfo.GetFixedRecordSize());
+	const bool bContainsVarData = m_recordInfo.ContainsVarData();
+	const unsigned nInterval = GetAppendInterval();
+
+	// see RecordInfo::Write - the var data follows its length, so a whole record is one run of bytes
+	auto RecordSize = [nFixedRecordSize, bContainsVarData](const RecordData* pRec) {
+		if (!bContainsVarData)
+			return size_t(nFixedRecordSize);
+		int nVarDataSize;
+		memcpy(&nVarDataSize, ToCharP(pRec) + nFixedRecordSize, sizeof(int));
+		if (nVarDataSize < 0)
+			throw Error(U16("Open_AlteryxYXDB::AppendRecords: A record has a negative var data size"));
+		return size_t(nFixedRecordSize) + sizeof(int) + unsigned(nVarDataSize);
+	};
+
+	// check them all before writing any, as AppendRaw does, so a bad record doesn't leave half a batch written
+	if (bContainsVarData)
+	{
+		for (size_t x = 0; x < nRecords; ++x)
+			RecordSize(ppRecords[x]);
+	}
+
+	size_t x = 0;
+	while (x < nRecords)
+	{
+		const unsigned nPos = unsigned(m_nCurrentRecord & (nInterval - 1));
+		if (nPos == 0)
+			StartAppendRecord();
+		const size_t nEnd = x + std::min<size_t>(nRecords - x, nInterval - nPos);
+
+		const char* pRun = ToCharP(ppRecords[x]);
+		size_t nRunSize = RecordSize(ppRecords[x]);
+		for (size_t y = x + 1; y < nEnd; ++y)
+		{
+			const char* pRec = ToCharP(ppRecords[y]);
+			const size_t nSize = RecordSize(ppRecords[y]);
+			if (pRec == pRun + nRunSize)
+				nRunSize += nSize;
+			else
+			{
+				WriteRecordBytes(pRun, nRunSize);
+				pRun = pRec;
+				nRunSize = nSize;
+			}
+		}
+		WriteRecordBytes(pRun, nRunSize);
+
+		if (IndexesRecords())
+		{
+			for (size_t y = x; y < nEnd; ++y)
+				IndexRecord(m_nCurrentRecord + int64_t(y - x), ppRecords[y]);
+		}
+
+		m_nCurrentRecord += nEnd - x;
+		x = nEnd;
+	}
+}
+
+void Open_AlteryxYXDB::AppendRaw(const void* pRecords, size_t nBytes, size_t nRecords)
+{
+	if (!m_pCompressOutput)
+		throw Error(U16("Open_AlteryxYXDB::AppendRaw: The file is not open for writing"));
+
+	const unsigned nFixedRecordSize = unsigned(m_recordInfo.GetFixedRecordSize());
+	const bool bContainsVarData = m_recordInfo.ContainsVarData();
+	const unsigned nHeaderSize = nFixedRecordSize + (bContainsVarData ? sizeof(int) : 0);
+	const unsigned nInterval = GetAppendInterval();
+	const char* const pBytes = static_cast<const char*>(pRecords);
+
+	// walk the records first to make sure they fit, remembering where each interval ends
+	std::vector<size_t> vIntervalEnds;
+	size_t nPos = 0;
+	unsigned nIntervalPos = unsigned(m_nCurrentRecord & (nInterval - 1));
+	for (size_t x = 0; x < nRecords; ++x)
+	{
+		if (nBytes - nPos < nHeaderSize)
+			throw Error(U16("Open_AlteryxYXDB::AppendRaw: The records are bigger than the buffer"));
+		size_t nRecordSize = nHeaderSize;
+		if (bContainsVarData)
+		{
+			int nVarDataSize;
+			memcpy(&nVarDataSize, pBytes + nPos + nFixedRecordSize, sizeof(int));
+			if (nVarDataSize < 0 || nBytes - nPos - nHeaderSize < size_t(nVarDataSize))
+				throw Error(U16("Open_AlteryxYXDB::AppendRaw: The records are bigger than the buffer"));
+			nRecordSize += unsigned(nVarDataSize);
+		}
+		nPos += nRecordSize;
+
+		if (++nIntervalPos == nInterval || x + 1 == nRecords)
+		{
+			vIntervalEnds.push_back(nPos);
+			nIntervalPos = 0;
+		}
+	}
+	if (nPos != nBytes)
+		throw Error(U16("Open_AlteryxYXDB::AppendRaw: The records are smaller than the buffer"));
+
+	size_t nStart = 0;
+	size_t nRecordsLeft = nRecords;
+	for (size_t nEnd : vIntervalEnds)
+	{
+		const unsigned nIntervalStart = unsigned(m_nCurrentRecord & (nInterval - 1));
+		if (nIntervalStart == 0)
+			StartAppendRecord();
+		WriteRecordBytes(pBytes + nStart, nEnd - nStart);
+
+		const size_t nIntervalRecords = std::min<size_t>(nRecordsLeft, nInterval - nIntervalStart);
+		m_nCurrentRecord += nIntervalRecords;
+		nRecordsLeft -= nIntervalRecords;
+		nStart = nEnd;
+	}
+
+	if (IndexesRecords())
+	{
+		int64_t nRecord = m_nCurrentRecord - int64_t(nRecords);
+		for (size_t nRecordPos = 0; nRecordPos < nBytes;)
+		{
+			const RecordData* pRec = reinterpret_cast<const RecordData*>(pBytes + nRecordPos);
+			IndexRecord(nRecord++, pRec);
+			nRecordPos += nHeaderSize;
+			if (bContainsVarData)
+			{
+				int nVarDataSize;
+				memcpy(&nVarDataSize, pBytes + nRecordPos - sizeof(int), sizeof(int));
+				nRecordPos += unsigned(nVarDataSize);
+			}
+		}
+	}
+}
+
+void Open_AlteryxYXDB::SetSpatialIndex(bool bSpatialIndex, int nField /*= -1*/)
+{
+	m_bWriteSpatialIndex = bSpatialIndex;
+	m_nWriteSpatialIndexField = nField;
+}
+
+void Open_AlteryxYXDB::SetZoneMaps(bool bZoneMaps)
+{
+	m_bWriteZoneMaps = bZoneMaps;
+}
+
+void Open_AlteryxYXDB::SetMemoryMapping(bool bMemoryMap)
+{
+	m_bMemoryMap = bMemoryMap;
+}
+
+void Open_AlteryxYXDB::SetCompressionThreads(unsigned nThreads)
+{
+	m_nCompressionThreads = nThreads;
+}
+
+void Open_AlteryxYXDB::SetCompressionCodec(unsigned nCodecId)
+{
+	// make sure it exists now rather than when Create is called
+	CodecRegistry::GetCodec(nCodecId);
+	m_nCodecId = nCodecId;
+}
+
+void Open_AlteryxYXDB::SetCompressionLevel(E_CompressionLevel eLevel)
+{
+	m_eCompressionLevel = eLevel;
+}
+
+void Open_AlteryxYXDB::SetCompressionBlockSize(unsigned nBlockSize)
+{
+	if (nBlockSize < MinLzfBlockSize || nBlockSize > MaxLzfBlockSize)
+		throw Error(U16("Open_AlteryxYXDB::SetCompressionBlockSize: The block size must be from 64KB to 16MB"));
+	m_nLzfBlockSize = nBlockSize;
+}
+
+void Open_AlteryxYXDB::SetReadAhead(unsigned nBlocks)
+{
+	m_nReadAheadBlocks = nBlocks;
+}
+
+void Open_AlteryxYXDB::SetDenseIndexInterval(unsigned nInterval)
+{
+	if (nInterval > RecordsPerBlock || (nInterval & (nInterval - 1)) != 0)
+		throw Error(U16("Open_AlteryxYXDB::SetDenseIndexInterval: The interval must be a power of 2 up to 65536"));
+	m_nDenseIndexInterval = nInterval;
+}
+
+void Open_AlteryxYXDB::SetRecordOffsetIndexInterval(unsigned nInterval)
+{
+	if (nInterval > RecordsPerBlock || (nInterval & (nInterval - 1)) != 0)
+		throw Error(
+			U16("Open_AlteryxYXDB::SetRecordOffsetIndexInterval: The interval must be a power of 2 up to 65536"));
+	m_nRecordOffsetIndexInterval = nInterval;
+}
+
+void Open_AlteryxYXDB::SetBlockCache(BlockCache* pCache)
+{
+	m_pBlockCache = pCache;
+}
+
+void Open_AlteryxYXDB::SetRecordInfoCache(RecordInfoCache* pCache)
+{
+	m_pRecordInfoCache = pCache;
+}
+
 /*virtual*/ void Open_AlteryxYXDB::Open(WString strFile)
 {
-	m_pFile.reset(new File_Large());
-	m_pFile->OpenForRead(strFile);
+	m_pInFile.reset(new File_Mapped());
+	m_pInFile->OpenForRead(strFile, m_bMemoryMap);
 
-	m_header.Read(*m_pFile);
+	m_header.Read(*m_pInFile);
 
 	m_bIndexStartsBlock = (m_header.fileID & 0xff) == 3;
-	if (m_header.userHdr.nCompressionVersion == 1)
-		m_pCompressInput = std::make_unique<LZFBufferedInput<File_Large*>>(m_pFile.get());
+	m_pCodec = NULL;
+	if (m_header.userHdr.nCompressionVersion != 0)
+	{
+		m_pCodec = CodecRegistry::FindCodec(unsigned(m_header.userHdr.nCompressionVersion));
+		if (m_pCodec == NULL)
+			throw Error(m_pInFile->GetFileName() + U16(" \nThe file uses an unknown compression codec."));
+		m_pCompressInput =
+			std::make_unique<LZFBufferedInput<File_Mapped*>>(m_pInFile.get(), m_pCodec, GetFileLzfBlockSize());
+		// attached even while it is off, so turning it on later takes effect on the files already open
+		m_inFileIdentity = m_pInFile->GetIdentity();
+		if (m_pBlockCache)
+			m_pCompressInput->SetBlockCache(m_pBlockCache, m_inFileIdentity);
+	}
 
 	String strRecordInfoXml;
 	U16unit* pRecordInfoXml = strRecordInfoXml.Lock(m_header.userHdr.nMetaInfoLen);
-	m_pFile->Read(pRecordInfoXml, m_header.userHdr.nMetaInfoLen * sizeof(U16unit));
+	m_pInFile->Read(pRecordInfoXml, m_header.userHdr.nMetaInfoLen * sizeof(U16unit));
 	strRecordInfoXml.Unlock();
 
-	m_recordInfo.InitFromXml(strRecordInfoXml);
+	if (m_pRecordInfoCache)
+		m_recordInfo = *m_pRecordInfoCache->Get(strRecordInfoXml);
+	else
+	{
+		// InitFromXml adds to whatever fields are already there, so start fresh in case this object is being reused
+		m_recordInfo = RecordInfo();
+		m_recordInfo.InitFromXml(strRecordInfoXml);
+	}
 	m_pRecord = m_recordInfo.CreateRecord();
 
+	// a spatial index written by SetSpatialIndex is loaded when it is first queried
+	m_nSpatialIndexField = -1;
+	m_bSpatialIndexLoaded = false;
+	m_spatialIndex.Clear();
+	const HeaderExtension& ext = m_header.extHdr;
+	if (ext.IsValid() && ext.nVersion >= 4 && ext.nSpatialIndexPos != 0)
+	{
+		if (ext.nSpatialIndexField >= m_recordInfo.NumFields()
+			|| m_recordInfo[ext.nSpatialIndexField]->m_ft != E_FT_SpatialObj)
+			throw Error(m_pInFile->GetFileName() + U16(" \nThe spatial index is corrupt."));
+		m_nSpatialIndexField = int(ext.nSpatialIndexField);
+	}
+
+	// so are the zone maps
+	m_bZoneMapsLoaded = false;
+	m_vZoneMapFields.clear();
+	m_vZoneMaps.clear();
+
 	// make sure we are at the first record in the file
-	assert(m_pFile->Tell() == int(sizeof(m_header) + m_header.userHdr.nMetaInfoLen * sizeof(U16unit)));
+	assert(m_pInFile->Tell() == int(sizeof(m_header) + m_header.userHdr.nMetaInfoLen * sizeof(U16unit)));
+
+	if (m_pCompressInput && m_nReadAheadBlocks != 0)
+		m_pCompressInput->EnableReadAhead(m_nReadAheadBlocks, GetRecordDataEndPos());
 }
 
 /*virtual*/ WString Open_AlteryxYXDB::GetRecordXmlMetaData()
@@ -255,46 +871,195 @@ Open_AlteryxYXDB::~Open_AlteryxYXDB()
 	Record* pRec = m_pRecord.Get();
 	pRec->Reset();
 
-	if (m_header.userHdr.nCompressionVersion == 1)
+	if (m_header.userHdr.nCompressionVersion != 0)
 		m_recordInfo.Read(*m_pCompressInput, pRec);
 	else
-		m_recordInfo.Read(*m_pFile, pRec);
+		m_recordInfo.Read(*m_pInFile, pRec);
 
 	return pRec->GetRecord();
 }
 
+void Open_AlteryxYXDB::ReadRecordBytes(void* pBuffer, unsigned nSize)
+{
+	if (m_header.userHdr.nCompressionVersion != 0)
+		m_pCompressInput->Read(pBuffer, nSize);
+	else
+		m_pInFile->Read(pBuffer, nSize);
+}
+
+TBlobVal<const RecordData*> Open_AlteryxYXDB::ReadBatch(unsigned nMaxRecords)
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::ReadBatch: The file is not open for reading"));
+
+	const unsigned nFixedRecordSize = unsigned(m_recordInfo.GetFixedRecordSize());
+	const bool bContainsVarData = m_recordInfo.ContainsVarData();
+	const unsigned nHeaderSize = nFixedRecordSize + (bContainsVarData ? sizeof(int) : 0);
+
+	// the arena may be reallocated as it grows, so only keep offsets until all the records are in
+	m_vBatchOffsets.clear();
+	size_t nUsed = 0;
+	while (m_vBatchOffsets.size() < nMaxRecords && m_nCurrentRecord < m_header.userHdr.nNumRecords)
+	{
+		if ((m_nCurrentRecord % RecordsPerBlock) == 0)
+			GoBlockRecord(m_nCurrentRecord);
+		m_nCurrentRecord++;
+
+		if (m_vBatchArena.size() < nUsed + nHeaderSize)
+			m_vBatchArena.resize(std::max(nUsed + nHeaderSize, m_vBatchArena.size() * 2));
+		ReadRecordBytes(m_vBatchArena.data() + nUsed, nHeaderSize);
+
+		size_t nRecordSize = nHeaderSize;
+		if (bContainsVarData)
+		{
+			int nVarDataSize;
+			memcpy(&nVarDataSize, m_vBatchArena.data() + nUsed + nFixedRecordSize, sizeof(int));
+			if (nVarDataSize < 0)
+				throw Error(m_pInFile->GetFileName() + U16(" \nA record block is corrupt."));
+
+			nRecordSize += unsigned(nVarDataSize);
+			if (m_vBatchArena.size() < nUsed + nRecordSize)
+				m_vBatchArena.resize(std::max(nUsed + nRecordSize, m_vBatchArena.size() * 2));
+			if (nVarDataSize > 0)
+				ReadRecordBytes(m_vBatchArena.data() + nUsed + nHeaderSize, unsigned(nVarDataSize));
+		}
+
+		m_vBatchOffsets.push_back(nUsed);
+		nUsed += nRecordSize;
+	}
+
+	m_vBatchRecords.resize(m_vBatchOffsets.size());
+	for (size_t x = 0; x < m_vBatchOffsets.size(); ++x)
+		m_vBatchRecords[x] = reinterpret_cast<const RecordData*>(m_vBatchArena.data() + m_vBatchOffsets[x]);
+
+	return TBlobVal<const RecordData*>(unsigned(m_vBatchRecords.size()), m_vBatchRecords.data());
+}
+
 /*virtual*/ int64_t Open_AlteryxYXDB::GetNumRecords()
 {
 	return m_header.userHdr.nNumRecords;
 }
 
+// reads an index written by WriteIndex.  The caller needs to hold m_recordBlockIndexMutex
+void Open_AlteryxYXDB::ReadIndex(int64_t nPos, unsigned nMinEntries, std::vector<int64_t>& r_vIndex) const
+{
+	std::vector<unsigned char> vBuffer;
+	unsigned nNewArraySize = 0;
+	memcpy(&nNewArraySize, m_pInFile->GetAt(nPos, sizeof(nNewArraySize), vBuffer), sizeof(nNewArraySize));
+	if (nNewArraySize < nMinEntries)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe record block index is corrupt."));
+
+	std::vector<int64_t> vIndex(nNewArraySize);
+	memcpy(
+		vIndex.data(),
+		m_pInFile->GetAt(nPos + sizeof(nNewArraySize), nNewArraySize * sizeof(int64_t), vBuffer),
+		nNewArraySize * sizeof(int64_t));
+	r_vIndex.swap(vIndex);
+}
+
+void Open_AlteryxYXDB::LoadRecordBlockIndex() const
+{
+	std::lock_guard<std::mutex> lock(m_recordBlockIndexMutex);
+	if (m_vRecordBlockIndexPos.size() != 0)
+		return;
+
+	ReadIndex(m_header.userHdr.nRecordBlockIndexPos, GetNumRecordBlocks(), m_vRecordBlockIndexPos);
+}
+
+void Open_AlteryxYXDB::LoadDenseIndex() const
+{
+	std::lock_guard<std::mutex> lock(m_recordBlockIndexMutex);
+	if (m_vDenseIndexPos.size() != 0)
+		return;
+
+	const unsigned nInterval = m_header.extHdr.nDenseIndexInterval;
+	ReadIndex(
+		m_header.extHdr.nDenseIndexPos,
+		unsigned((m_header.userHdr.nNumRecords + nInterval - 1) / nInterval),
+		m_vDenseIndexPos);
+}
+
+// the 1st block always starts right after the header, so a file with only 1 block never needs the index
+int64_t Open_AlteryxYXDB::GetRecordBlockStartPos(unsigned nBlock) const
+{
+	if (nBlock == 0)
+		return sizeof(m_header) + m_header.userHdr.nMetaInfoLen * sizeof(U16unit);
+
+	LoadRecordBlockIndex();
+	return m_vRecordBlockIndexPos[nBlock];
+}
+
+int64_t Open_AlteryxYXDB::GetRecordBlockEndPos(unsigned nBlock) const
+{
+	if (nBlock + 1 < GetNumRecordBlocks())
+		return GetRecordBlockStartPos(nBlock + 1);
+
+	return GetRecordDataEndPos();
+}
+
+// the records run up to whatever was written after them
+int64_t Open_AlteryxYXDB::GetRecordDataEndPos() const
+{
+	int64_t nEnd = m_header.userHdr.nRecordBlockIndexPos;
+	if (m_header.userHdr.nSpatialIndexPos > GetRecordBlockStartPos(0) && m_header.userHdr.nSpatialIndexPos < nEnd)
+		nEnd = m_header.userHdr.nSpatialIndexPos;
+	return nEnd;
+}
+
+unsigned Open_AlteryxYXDB::GetFileLzfBlockSize() const
+{
+	const HeaderExtension& ext = m_header.extHdr;
+	if (!ext.IsValid() || ext.nVersion < 3 || ext.nLzfBlockSize == 0)
+		return DefaultLzfBlockSize;
+	if (ext.nLzfBlockSize < MinLzfBlockSize || ext.nLzfBlockSize > MaxLzfBlockSize)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe file has an invalid compression block size."));
+	return ext.nLzfBlockSize;
+}
+
 void Open_AlteryxYXDB::GoBlockRecord(int64_t nRecord)
 {
 	if (nRecord == 0)
 	{
-		m_pFile->LSeek(sizeof(m_header) + m_header.userHdr.nMetaInfoLen * sizeof(U16unit));
+		m_pInFile->LSeek(sizeof(m_header) + m_header.userHdr.nMetaInfoLen * sizeof(U16unit));
 		if (m_pCompressInput.get())
 			m_pCompressInput->Reset();
 		m_nCurrentRecord = 0;
 	}
 	else
 	{
-		if (m_vRecordBlockIndexPos.size() == 0)
-		{
-			m_pFile->LSeek(m_header.userHdr.nRecordBlockIndexPos);
-			unsigned nNewArraySize = 0;
-			m_pFile->Read(&nNewArraySize, sizeof(nNewArraySize));
-			m_vRecordBlockIndexPos.resize(nNewArraySize);
-
-			m_pFile->Read(&*m_vRecordBlockIndexPos.begin(), nNewArraySize * sizeof(int64_t));
-		}
+		LoadRecordBlockIndex();
 		int64_t nNewPos = m_vRecordBlockIndexPos[unsigned(nRecord / RecordsPerBlock)];
-		m_pFile->LSeek(nNewPos);
+		m_pInFile->LSeek(nNewPos);
 		if (m_pCompressInput.get())
 			m_pCompressInput->Reset();
 	}
 }
 
+// positions the file at the start of nRecord, which must be on a record offset index entry
+void Open_AlteryxYXDB::GoRecordOffsetIndex(int64_t nRecord)
+{
+	const int64_t nIndexPos = m_header.extHdr.nRecordOffsetIndexPos;
+	const size_t nEntry = size_t(nRecord / m_header.extHdr.nRecordOffsetIndexInterval);
+
+	std::vector<unsigned char> vBuffer;
+	unsigned nNumEntries;
+	memcpy(&nNumEntries, m_pInFile->GetAt(nIndexPos, sizeof(nNumEntries), vBuffer), sizeof(nNumEntries));
+	if (nEntry >= nNumEntries)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe record offset index is corrupt."));
+
+	RecordOffsetIndexEntry entry;
+	memcpy(
+		&entry,
+		m_pInFile->GetAt(nIndexPos + sizeof(nNumEntries) + nEntry * sizeof(entry), sizeof(entry), vBuffer),
+		sizeof(entry));
+
+	m_pInFile->LSeek(entry.nLzfBlockPos);
+	m_pCompressInput->Reset();
+	if (m_pCompressInput->Skip(entry.nOffset) != entry.nOffset)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe record offset index is corrupt."));
+	m_nCurrentRecord = nRecord;
+}
+
 /*virtual*/ void Open_AlteryxYXDB::GoRecord(int64_t nRecord /*= 0*/)
 {
 	if (nRecord >= m_header.userHdr.nNumRecords || nRecord < 0)
@@ -304,10 +1069,40 @@ void Open_AlteryxYXDB::GoBlockRecord(int64_t nRecord)
 		;  // do nothing
 	else
 	{
+		// files we wrote may have finer grained indexes than the record blocks.  They are all powers of 2,
+		// so use whichever has the smallest interval
+		unsigned nOffsetInterval = 0;
+		unsigned nDenseInterval = 0;
+		if (m_header.extHdr.IsValid())
+		{
+			if (m_header.userHdr.nCompressionVersion != 0)
+				nOffsetInterval = m_header.extHdr.nRecordOffsetIndexInterval;
+			nDenseInterval = m_header.extHdr.nDenseIndexInterval;
+		}
+		unsigned nInterval = RecordsPerBlock;
+		if (nDenseInterval != 0)
+			nInterval = std::min(nInterval, nDenseInterval);
+		if (nOffsetInterval != 0)
+			nInterval = std::min(nInterval, nOffsetInterval);
+		const int64_t nIntervalStart = nRecord - (nRecord % nInterval);
+
 		unsigned numSkipRecs = 0;
-		if (nRecord > m_nCurrentRecord
-			&& nRecord < (m_nCurrentRecord + RecordsPerBlock - (m_nCurrentRecord % RecordsPerBlock)))
+		if (nRecord > m_nCurrentRecord && m_nCurrentRecord >= nIntervalStart)
 			numSkipRecs = unsigned(nRecord - m_nCurrentRecord);
+		else if (nInterval == nOffsetInterval)
+		{
+			GoRecordOffsetIndex(nIntervalStart);
+			numSkipRecs = unsigned(nRecord - nIntervalStart);
+		}
+		else if (nInterval == nDenseInterval)
+		{
+			LoadDenseIndex();
+			m_pInFile->LSeek(m_vDenseIndexPos[size_t(nRecord / nInterval)]);
+			if (m_pCompressInput.get())
+				m_pCompressInput->Reset();
+			m_nCurrentRecord = nIntervalStart;
+			numSkipRecs = unsigned(nRecord - nIntervalStart);
+		}
 		else
 		{
 			// read record will reset to the correct spot when it tries to read the next record
@@ -320,4 +1115,75 @@ void Open_AlteryxYXDB::GoBlockRecord(int64_t nRecord)
 	}
 }
 
+unsigned Open_AlteryxYXDB::GetNumRecordBlocks() const
+{
+	return unsigned((m_header.userHdr.nNumRecords + RecordsPerBlock - 1) / RecordsPerBlock);
+}
+
+void Open_AlteryxYXDB::ReadRecordBlock(unsigned nBlock, RecordBlock& block, std::vector<unsigned char>& vScratch) const
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::ReadRecordBlock: The file is not open for reading"));
+	if (nBlock >= GetNumRecordBlocks())
+		throw Error(U16("Open_AlteryxYXDB::ReadRecordBlock: Attempt to read past the end of the file"));
+
+	int64_t nStart = GetRecordBlockStartPos(nBlock);
+	int64_t nEnd = GetRecordBlockEndPos(nBlock);
+	if (nEnd < nStart)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe record block index is corrupt."));
+
+	size_t nInSize = size_t(nEnd - nStart);
+	const void* pIn = m_pInFile->GetAt(nStart, nInSize, vScratch);
+
+	block.m_nBlock = nBlock;
+	block.m_nFirstRecord = int64_t(nBlock) * RecordsPerBlock;
+	block.m_nDataSize = 0;
+	if (m_header.userHdr.nCompressionVersion != 0)
+		LZFDecompressBlocks(
+			pIn,
+			nInSize,
+			block.m_vData,
+			block.m_nDataSize,
+			m_pCodec,
+			GetFileLzfBlockSize(),
+			m_pBlockCache,
+			m_inFileIdentity,
+			nStart);
+	else
+	{
+		if (block.m_vData.size() < nInSize)
+			block.m_vData.resize(nInSize);
+		memcpy(block.m_vData.data(), pIn, nInSize);
+		block.m_nDataSize = nInSize;
+	}
+
+	// now find where each record starts.  See RecordInfo::Read for the layout
+	unsigned nNumRecords =
+		unsigned(std::min<int64_t>(RecordsPerBlock, m_header.userHdr.nNumRecords - block.m_nFirstRecord));
+	block.m_vRecords.resize(nNumRecords);
+
+	const size_t nFixedRecordSize = m_recordInfo.GetFixedRecordSize();
+	const bool bContainsVarData = m_recordInfo.ContainsVarData();
+	const unsigned char* pData = block.m_vData.data();
+	size_t nPos = 0;
+	for (unsigned x = 0; x < nNumRecords; ++x)
+	{
+		size_t nRecordSize = nFixedRecordSize;
+		if (bContainsVarData)
+		{
+			if (nPos + nFixedRecordSize + sizeof(int) > block.m_nDataSize)
+				throw Error(m_pInFile->GetFileName() + U16(" \nA record block is corrupt."));
+
+			int nVarDataSize;
+			memcpy(&nVarDataSize, pData + nPos + nFixedRecordSize, sizeof(nVarDataSize));
+			nRecordSize += sizeof(int) + unsigned(nVarDataSize);
+		}
+		if (nPos + nRecordSize > block.m_nDataSize)
+			throw Error(m_pInFile->GetFileName() + U16(" \nA record block is corrupt."));
+
+		block.m_vRecords[x] = reinterpret_cast<const RecordData*>(pData + nPos);
+		nPos += nRecordSize;
+	}
+}
+
 }}  // namespace Alteryx::OpenYXDB
@@ -0,0 +1,397 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+#include "ParallelBlockScan.h"
+
+#include <algorithm>
+
+namespace Alteryx { namespace OpenYXDB {
+
+///////////////////////////////////////////////////////////////////////////////
+// RecordInfoCache
+
+std::shared_ptr<const RecordInfo> RecordInfoCache::Get(const String& strRecordInfoXml)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_mapRecordInfos.find(strRecordInfoXml);
+		if (it != m_mapRecordInfos.end())
+			return it->second;
+	}
+
+	// parse it outside the lock.  If 2 threads race to parse the same XML, the first one in wins
+	std::shared_ptr<RecordInfo> pRecordInfo = std::make_shared<RecordInfo>();
+	pRecordInfo->InitFromXml(strRecordInfoXml);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_mapRecordInfos.emplace(strRecordInfoXml, std::move(pRecordInfo)).first->second;
+}
+
+void RecordInfoCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_mapRecordInfos.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// YXDBDataset
+
+YXDBDataset::YXDBDataset()
+	: m_nMaxOpenFiles(64)
+	, m_nMemoryBudget(0)
+	, m_nOpenFiles(0)
+	, m_nUseCount(0)
+	, m_nCurrentShard(-1)
+	, m_nCurrentRecord(0)
+{
+}
+
+YXDBDataset::~YXDBDataset()
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+}
+
+void YXDBDataset::SetMaxOpenFiles(unsigned nMaxOpenFiles)
+{
+	if (nMaxOpenFiles == 0)
+		throw Error(U16("YXDBDataset::SetMaxOpenFiles: At least 1 file has to be allowed open"));
+	m_nMaxOpenFiles = nMaxOpenFiles;
+}
+
+void YXDBDataset::SetMemoryBudget(size_t nBytes)
+{
+	m_nMemoryBudget = nBytes;
+}
+
+void YXDBDataset::Open(const std::vector<WString>& vFiles)
+{
+	Close();
+
+	m_vShards.resize(vFiles.size());
+	for (size_t x = 0; x < vFiles.size(); ++x)
+		m_vShards[x].m_strFile = vFiles[x];
+
+	try
+	{
+		int64_t nFirstRecord = 0;
+		for (unsigned x = 0; x < m_vShards.size(); ++x)
+		{
+			Shard& shard = m_vShards[x];
+			Open_AlteryxYXDB& file = AcquireShard(x);
+			try
+			{
+				if (x == 0)
+					m_recordInfo = file.m_recordInfo;
+				else if (!m_recordInfo.CompareSchemas(file.m_recordInfo))
+					throw Error(XMSG(
+						"YXDBDataset::Open: The fields of @1 don't match the fields of @2",
+						shard.m_strFile,
+						m_vShards[0].m_strFile));
+
+				shard.m_nFirstRecord = nFirstRecord;
+				shard.m_nNumRecords = file.GetNumRecords();
+				shard.m_nNumRecordBlocks = file.GetNumRecordBlocks();
+				nFirstRecord += shard.m_nNumRecords;
+			}
+			catch (...)
+			{
+				ReleaseShard(x);
+				throw;
+			}
+			ReleaseShard(x);
+		}
+	}
+	catch (...)
+	{
+		Close();
+		throw;
+	}
+}
+
+void YXDBDataset::Close()
+{
+	// nothing else can be using the shards, since the dataset isn't thread safe outside of a scan
+	m_vShards.clear();
+	m_recordInfoCache.Clear();
+	m_recordInfo = RecordInfo();
+	m_nOpenFiles = 0;
+	m_nCurrentShard = -1;
+	m_nCurrentRecord = 0;
+}
+
+unsigned YXDBDataset::GetNumShards() const
+{
+	return unsigned(m_vShards.size());
+}
+
+const WString& YXDBDataset::GetShardFile(unsigned nShard) const
+{
+	return m_vShards.at(nShard).m_strFile;
+}
+
+int64_t YXDBDataset::GetShardFirstRecord(unsigned nShard) const
+{
+	return m_vShards.at(nShard).m_nFirstRecord;
+}
+
+int64_t YXDBDataset::GetShardNumRecords(unsigned nShard) const
+{
+	return m_vShards.at(nShard).m_nNumRecords;
+}
+
+int64_t YXDBDataset::GetNumRecords() const
+{
+	if (m_vShards.empty())
+		return 0;
+	return m_vShards.back().m_nFirstRecord + m_vShards.back().m_nNumRecords;
+}
+
+unsigned YXDBDataset::FindShard(int64_t nRecord) const
+{
+	if (nRecord < 0 || nRecord >= GetNumRecords())
+		throw Error(U16("YXDBDataset::FindShard: The record is past the end of the dataset"));
+
+	// the last shard starting at or before nRecord.  Empty shards start at the same record as the one after them,
+	// so they are never it
+	auto it = std::upper_bound(
+		m_vShards.begin(), m_vShards.end(), nRecord, [](int64_t n, const Shard& shard) { return n < shard.m_nFirstRecord; });
+	return unsigned(it - m_vShards.begin()) - 1;
+}
+
+Open_AlteryxYXDB& YXDBDataset::AcquireShard(unsigned nShard)
+{
+	Shard& shard = m_vShards[nShard];
+
+	std::unique_lock<std::mutex> lock(m_shardMutex);
+	for (;;)
+	{
+		if (shard.m_bOpening)
+			m_cvShards.wait(lock);
+		else if (shard.m_pFile)
+		{
+			shard.m_nUsers++;
+			shard.m_nLastUsed = ++m_nUseCount;
+			return *shard.m_pFile;
+		}
+		else if (m_nOpenFiles < m_nMaxOpenFiles)
+			break;
+		else
+		{
+			// close whichever shard nobody is using was used the longest ago, or wait for one to be released
+			Shard* pOldest = NULL;
+			for (Shard& other : m_vShards)
+			{
+				if (other.m_pFile && other.m_nUsers == 0 && (!pOldest || other.m_nLastUsed < pOldest->m_nLastUsed))
+					pOldest = &other;
+			}
+			if (pOldest)
+			{
+				pOldest->m_pFile.reset();
+				m_nOpenFiles--;
+			}
+			else
+				m_cvShards.wait(lock);
+		}
+	}
+
+	// open it outside the lock so the other threads can carry on with the shards that are already open
+	shard.m_bOpening = true;
+	shard.m_nUsers++;
+	m_nOpenFiles++;
+	lock.unlock();
+
+	std::unique_ptr<Open_AlteryxYXDB> pFile(new Open_AlteryxYXDB);
+	try
+	{
+		pFile->SetRecordInfoCache(&m_recordInfoCache);
+		pFile->Open(shard.m_strFile);
+	}
+	catch (...)
+	{
+		lock.lock();
+		shard.m_bOpening = false;
+		shard.m_nUsers--;
+		m_nOpenFiles--;
+		m_cvShards.notify_all();
+		throw;
+	}
+
+	lock.lock();
+	shard.m_pFile = std::move(pFile);
+	shard.m_bOpening = false;
+	shard.m_nLastUsed = ++m_nUseCount;
+	m_cvShards.notify_all();
+	return *shard.m_pFile;
+}
+
+void YXDBDataset::ReleaseShard(unsigned nShard)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_shardMutex);
+		Shard& shard = m_vShards[nShard];
+		shard.m_nUsers--;
+		shard.m_nLastUsed = ++m_nUseCount;
+		if (shard.m_nUsers != 0)
+			return;
+	}
+	m_cvShards.notify_all();
+}
+
+void YXDBDataset::ReleaseCurrentShard()
+{
+	if (m_nCurrentShard >= 0)
+	{
+		ReleaseShard(unsigned(m_nCurrentShard));
+		m_nCurrentShard = -1;
+	}
+}
+
+void YXDBDataset::GoRecord(int64_t nRecord /*= 0*/)
+{
+	if (nRecord >= GetNumRecords() || nRecord < 0)
+		throw Error(U16("YXDBDataset::GoRecord: Attempt to seek past the end of the dataset"));
+
+	// the shard is only acquired, and sought to the record, by the next ReadRecord
+	if (m_nCurrentShard >= 0)
+	{
+		const Shard& shard = m_vShards[m_nCurrentShard];
+		if (nRecord >= shard.m_nFirstRecord && nRecord < shard.m_nFirstRecord + shard.m_nNumRecords)
+			shard.m_pFile->GoRecord(nRecord - shard.m_nFirstRecord);
+		else
+			ReleaseCurrentShard();
+	}
+	m_nCurrentRecord = nRecord;
+}
+
+const RecordData* YXDBDataset::ReadRecord()
+{
+	if (m_nCurrentRecord >= GetNumRecords())
+		return NULL;
+
+	if (m_nCurrentShard < 0
+		|| m_nCurrentRecord >= m_vShards[m_nCurrentShard].m_nFirstRecord + m_vShards[m_nCurrentShard].m_nNumRecords)
+	{
+		ReleaseCurrentShard();
+		const unsigned nShard = FindShard(m_nCurrentRecord);
+		Open_AlteryxYXDB& file = AcquireShard(nShard);
+		m_nCurrentShard = int(nShard);
+		file.GoRecord(m_nCurrentRecord - m_vShards[nShard].m_nFirstRecord);
+	}
+
+	m_nCurrentRecord++;
+	return m_vShards[m_nCurrentShard].m_pFile->ReadRecord();
+}
+
+void YXDBDataset::ParallelScan(
+	const ScanCallback& callback,
+	unsigned nThreads /*= 0*/,
+	bool bOrdered /*= true*/,
+	unsigned nMaxPendingBlocks /*= 0*/)
+{
+	ScanBlocks(
+		[this, &callback](unsigned nShard, const RecordBlock& block) {
+			const int64_t nFirstRecord = m_vShards[nShard].m_nFirstRecord + block.m_nFirstRecord;
+			for (size_t x = 0; x < block.m_vRecords.size(); ++x)
+				callback(nShard, nFirstRecord + int64_t(x), block.m_vRecords[x]);
+		},
+		NULL,
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks);
+}
+
+void YXDBDataset::Scan(
+	const RecordPredicate& predicate,
+	const ScanCallback& callback,
+	unsigned nThreads /*= 0*/,
+	bool bOrdered /*= true*/,
+	unsigned nMaxPendingBlocks /*= 0*/)
+{
+	ScanBlocks(
+		[this, &callback](unsigned nShard, const RecordBlock& block) {
+			const int64_t nFirstRecord = m_vShards[nShard].m_nFirstRecord + block.m_nFirstRecord;
+			for (uint32_t nRecord : block.m_vSelection)
+				callback(nShard, nFirstRecord + nRecord, block.m_vRecords[nRecord]);
+		},
+		&predicate,
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks);
+}
+
+void YXDBDataset::ScanBlocks(
+	const BlockCallback& callback,
+	const RecordPredicate* pPredicate,
+	unsigned nThreads,
+	bool bOrdered,
+	unsigned nMaxPendingBlocks)
+{
+	// the scan may need every open file slot, so give up the one ReadRecord is holding.
+	// The next ReadRecord picks up where it left off
+	ReleaseCurrentShard();
+
+	// every record block of every shard, in order, leaving out the ones whose zone maps rule out pPredicate
+	struct Unit
+	{
+		unsigned nShard;
+		unsigned nBlock;
+	};
+	std::vector<Unit> vUnits;
+	for (unsigned nShard = 0; nShard < m_vShards.size(); ++nShard)
+	{
+		if (pPredicate == NULL || m_vShards[nShard].m_nNumRecordBlocks == 0)
+		{
+			for (unsigned nBlock = 0; nBlock < m_vShards[nShard].m_nNumRecordBlocks; ++nBlock)
+				vUnits.push_back(Unit{ nShard, nBlock });
+			continue;
+		}
+
+		Open_AlteryxYXDB& file = AcquireShard(nShard);
+		std::vector<unsigned> vBlocks;
+		try
+		{
+			vBlocks = file.GetMatchingBlocks(*pPredicate);
+		}
+		catch (...)
+		{
+			ReleaseShard(nShard);
+			throw;
+		}
+		ReleaseShard(nShard);
+		for (unsigned nBlock : vBlocks)
+			vUnits.push_back(Unit{ nShard, nBlock });
+	}
+
+	// a shard only has to stay open while a block is being decoded, since ReadRecordBlock copies the records out
+	ParallelBlockScan(
+		unsigned(vUnits.size()),
+		[this, &vUnits, pPredicate](unsigned nUnit, RecordBlock& r_block, std::vector<unsigned char>& vScratch) {
+			const Unit& unit = vUnits[nUnit];
+			Open_AlteryxYXDB& file = AcquireShard(unit.nShard);
+			try
+			{
+				file.ReadRecordBlock(unit.nBlock, r_block, vScratch);
+			}
+			catch (...)
+			{
+				ReleaseShard(unit.nShard);
+				throw;
+			}
+			ReleaseShard(unit.nShard);
+			if (pPredicate)
+				SelectBlockRecords(*pPredicate, r_block);
+		},
+		[&vUnits, &callback](unsigned nUnit, const RecordBlock& block) { callback(vUnits[nUnit].nShard, block); },
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks,
+		m_nMemoryBudget);
+}
+
+}}  // namespace Alteryx::OpenYXDB
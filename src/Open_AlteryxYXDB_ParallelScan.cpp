@@ -0,0 +1,255 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+#include "ParallelBlockScan.h"
+
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <thread>
+
+namespace Alteryx { namespace OpenYXDB {
+
+void Open_AlteryxYXDB::ParallelScan(
+	const ScanCallback& callback,
+	unsigned nThreads /*= 0*/,
+	bool bOrdered /*= true*/,
+	unsigned nMaxPendingBlocks /*= 0*/)
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::ParallelScan: The file is not open for reading"));
+
+	std::vector<unsigned> vBlocks(GetNumRecordBlocks());
+	for (unsigned x = 0; x < vBlocks.size(); ++x)
+		vBlocks[x] = x;
+	ScanBlocks(
+		vBlocks,
+		[&callback](const RecordBlock& block) {
+			for (size_t x = 0; x < block.m_vRecords.size(); ++x)
+				callback(block.m_nBlock, block.m_nFirstRecord + int64_t(x), block.m_vRecords[x]);
+		},
+		NULL,
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks);
+}
+
+void Open_AlteryxYXDB::Scan(
+	const RecordPredicate& predicate,
+	const ScanCallback& callback,
+	unsigned nThreads /*= 0*/,
+	bool bOrdered /*= true*/,
+	unsigned nMaxPendingBlocks /*= 0*/)
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::Scan: The file is not open for reading"));
+
+	ScanBlocks(
+		GetMatchingBlocks(predicate),
+		[&callback](const RecordBlock& block) {
+			for (uint32_t nRecord : block.m_vSelection)
+				callback(block.m_nBlock, block.m_nFirstRecord + nRecord, block.m_vRecords[nRecord]);
+		},
+		&predicate,
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks);
+}
+
+void Open_AlteryxYXDB::ScanBlocks(
+	const std::vector<unsigned>& vBlocks,
+	const BlockCallback& callback,
+	const RecordPredicate* pPredicate,
+	unsigned nThreads,
+	bool bOrdered,
+	unsigned nMaxPendingBlocks)
+{
+	if (vBlocks.empty())
+		return;
+
+	// load it up front, rather than having all the workers wait on the first one to do it
+	if (vBlocks.size() > 1 || vBlocks[0] != 0)
+		LoadRecordBlockIndex();
+
+	// the units are the positions in vBlocks
+	ParallelBlockScan(
+		unsigned(vBlocks.size()),
+		[this, &vBlocks, pPredicate](unsigned nUnit, RecordBlock& r_block, std::vector<unsigned char>& vScratch) {
+			ReadRecordBlock(vBlocks[nUnit], r_block, vScratch);
+			if (pPredicate)
+				SelectBlockRecords(*pPredicate, r_block);
+		},
+		[&callback](unsigned, const RecordBlock& block) { callback(block); },
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks,
+		0);
+}
+
+void SelectBlockRecords(const RecordPredicate& predicate, RecordBlock& r_block)
+{
+	// only ever grown, like m_vData
+	r_block.m_vSelection.resize(r_block.m_vRecords.size());
+	r_block.m_vSelection.resize(
+		predicate.Select(r_block.m_vRecords.data(), r_block.m_vRecords.size(), r_block.m_vSelection.data()));
+}
+
+void ParallelBlockScan(
+	unsigned nUnits,
+	const BlockDecoder& decode,
+	const BlockConsumer& consume,
+	unsigned nThreads,
+	bool bOrdered,
+	unsigned nMaxPendingBlocks,
+	size_t nMaxPendingBytes)
+{
+	if (nUnits == 0)
+		return;
+
+	if (nThreads == 0)
+		nThreads = std::max(1u, std::thread::hardware_concurrency());
+	nThreads = std::min(nThreads, nUnits);
+	if (nMaxPendingBlocks == 0)
+		nMaxPendingBlocks = 2 * nThreads;
+
+	std::mutex mutex;
+	std::condition_variable cvWorkers;  // signaled when a slot in the reorder window or the memory budget opens up
+	std::condition_variable cvConsumer;  // signaled when a block has been decoded
+	unsigned nNextUnit = 0;
+	unsigned nNextToDeliver = 0;
+	bool bAbort = false;
+	std::exception_ptr pError;
+
+	// the blocks decoded but not consumed yet, and how much data they hold
+	unsigned nPendingBlocks = 0;
+	size_t nPendingBytes = 0;
+
+	// only used when bOrdered.  Decoded blocks wait here until it is their turn,
+	// and the buffers are recycled through vFreeBlocks so we aren't reallocating them for every block
+	std::map<unsigned, std::unique_ptr<RecordBlock>> mapReady;
+	std::vector<std::unique_ptr<RecordBlock>> vFreeBlocks;
+
+	auto SetError = [&](std::exception_ptr p) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!pError)
+			pError = p;
+		bAbort = true;
+		cvWorkers.notify_all();
+		cvConsumer.notify_all();
+	};
+
+	// while nothing is pending there is always room for one more, or nothing would ever finish.
+	// When bOrdered, the next block to deliver was handed out before any that are pending, so it doesn't wait on this
+	auto CanStart = [&]() {
+		if (bOrdered && nNextUnit >= nNextToDeliver + nMaxPendingBlocks)
+			return false;
+		return nMaxPendingBytes == 0 || nPendingBlocks == 0 || nPendingBytes < nMaxPendingBytes;
+	};
+
+
+	auto Worker = [&]() {
+		try
+		{
+			std::vector<unsigned char> vScratch;
+			std::unique_ptr<RecordBlock> pBlock;
+			for (;;)
+			{
+				unsigned nUnit;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cvWorkers.wait(lock, [&] { return bAbort || nNextUnit >= nUnits || CanStart(); });
+					if (bAbort || nNextUnit >= nUnits)
+						return;
+
+					nUnit = nNextUnit++;
+					if (!pBlock)
+					{
+						if (vFreeBlocks.empty())
+							pBlock.reset(new RecordBlock);
+						else
+						{
+							pBlock = std::move(vFreeBlocks.back());
+							vFreeBlocks.pop_back();
+						}
+					}
+				}
+
+				decode(nUnit, *pBlock, vScratch);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					nPendingBlocks++;
+					nPendingBytes += pBlock->m_nDataSize;
+					if (bOrdered)
+					{
+						mapReady[nUnit] = std::move(pBlock);
+						cvConsumer.notify_one();
+					}
+				}
+
+				if (!bOrdered)
+				{
+					consume(nUnit, *pBlock);
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						nPendingBlocks--;
+						nPendingBytes -= pBlock->m_nDataSize;
+					}
+					cvWorkers.notify_all();
+				}
+			}
+		}
+		catch (...)
+		{
+			SetError(std::current_exception());
+		}
+	};
+
+	std::vector<std::thread> vThreads;
+	try
+	{
+		for (unsigned x = 0; x < nThreads; ++x)
+			vThreads.emplace_back(Worker);
+
+		if (bOrdered)
+		{
+			while (nNextToDeliver < nUnits)
+			{
+				std::unique_ptr<RecordBlock> pBlock;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					cvConsumer.wait(lock, [&] { return bAbort || mapReady.count(nNextToDeliver) != 0; });
+					if (bAbort)
+						break;
+
+					auto it = mapReady.find(nNextToDeliver);
+					pBlock = std::move(it->second);
+					mapReady.erase(it);
+				}
+
+				consume(nNextToDeliver, *pBlock);
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					nPendingBlocks--;
+					nPendingBytes -= pBlock->m_nDataSize;
+					vFreeBlocks.push_back(std::move(pBlock));
+					nNextToDeliver++;
+				}
+				cvWorkers.notify_all();
+			}
+		}
+	}
+	catch (...)
+	{
+		SetError(std::current_exception());
+	}
+
+	for (auto& thread : vThreads)
+		thread.join();
+
+	if (pError)
+		std::rethrow_exception(pError);
+}
+
+}}  // namespace Alteryx::OpenYXDB
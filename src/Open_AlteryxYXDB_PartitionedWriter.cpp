@@ -0,0 +1,516 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+
+#include "Base/MiniXmlParser.h"
+#include "RecordLib/FieldAccessor.h"
+
+#pragma warning(push)
+// disable signed to unsigned conversion warning
+#pragma warning(disable : 4245)
+#include "SpookyV2.h"
+#pragma warning(pop)
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <thread>
+
+namespace Alteryx { namespace OpenYXDB {
+
+namespace {
+// the producers hand the records to a partition's thread in batches of about this many bytes,
+// and wait once this many batches are queued for it
+const size_t BatchSize = 1 << 20;
+const size_t MaxQueuedBatches = 4;
+
+// 0 and -0 hash the same, as do all the NaNs
+template <class T>
+uint64_t HashFloatingPoint(const char* pField)
+{
+	T value;
+	memcpy(&value, pField, sizeof(T));
+	if (value == 0)
+		value = 0;
+	else if (std::isnan(value))
+		value = std::numeric_limits<T>::quiet_NaN();
+	return SpookyHash::Hash64(&value, sizeof(T), 0);
+}
+
+// the hash of a field's value, so records with the same value go to the same partition however it was stored.
+// Only the meaningful part of a fixed length string is hashed, since whatever is after its terminator is left over
+uint64_t HashField(const FieldBase& field, const RecordData* pRec)
+{
+	if (field.GetNull(pRec))
+		return 0;
+
+	const char* pField = ToCharP(pRec) + field.GetOffset();
+	switch (field.m_ft)
+	{
+		case E_FT_Bool:
+		{
+			const bool bValue = FieldAccessorDetail::BoolLayout::GetValue(pField);
+			return SpookyHash::Hash64(&bValue, sizeof(bValue), 0);
+		}
+		case E_FT_Byte:
+		case E_FT_Int16:
+		case E_FT_Int32:
+		case E_FT_Int64:
+			// the value is followed by its null flag
+			return SpookyHash::Hash64(pField, field.m_nRawSize - 1, 0);
+		case E_FT_Float:
+			return HashFloatingPoint<float>(pField);
+		case E_FT_Double:
+			return HashFloatingPoint<double>(pField);
+		case E_FT_String:
+		case E_FT_Date:
+		case E_FT_Time:
+		case E_FT_DateTime:
+		case E_FT_FixedDecimal:
+			return SpookyHash::Hash64(
+				pField, FieldAccessorDetail::FixedStringLayout<char>::Length(pField, unsigned(field.m_nSize)), 0);
+		case E_FT_WString:
+			return SpookyHash::Hash64(
+				pField,
+				FieldAccessorDetail::FixedStringLayout<U16unit>::Length(pField, unsigned(field.m_nSize)) * sizeof(U16unit),
+				0);
+		default:
+		{
+			// V_String, V_WString, Blob and SpatialObj
+			BlobVal val = RecordInfo::GetVarDataValue(pRec, field.GetOffset());
+			return SpookyHash::Hash64(val.pValue, val.nLength, 0);
+		}
+	}
+}
+
+// the manifest is written as UTF-8
+AString ConvertToUtf8(const WString& str)
+{
+	AString strRet;
+	strRet.reserve(str.length());
+	for (size_t x = 0; x < str.length(); ++x)
+	{
+		uint32_t c = uint32_t(str[x]);
+		if (c >= 0xd800 && c < 0xdc00 && x + 1 < str.length() && uint32_t(str[x + 1]) >= 0xdc00
+			&& uint32_t(str[x + 1]) < 0xe000)
+			c = 0x10000 + ((c - 0xd800) << 10) + (uint32_t(str[++x]) - 0xdc00);
+
+		if (c < 0x80)
+			strRet.push_back(char(c));
+		else if (c < 0x800)
+		{
+			strRet.push_back(char(0xc0 | (c >> 6)));
+			strRet.push_back(char(0x80 | (c & 0x3f)));
+		}
+		else if (c < 0x10000)
+		{
+			strRet.push_back(char(0xe0 | (c >> 12)));
+			strRet.push_back(char(0x80 | ((c >> 6) & 0x3f)));
+			strRet.push_back(char(0x80 | (c & 0x3f)));
+		}
+		else
+		{
+			strRet.push_back(char(0xf0 | (c >> 18)));
+			strRet.push_back(char(0x80 | ((c >> 12) & 0x3f)));
+			strRet.push_back(char(0x80 | ((c >> 6) & 0x3f)));
+			strRet.push_back(char(0x80 | (c & 0x3f)));
+		}
+	}
+	return strRet;
+}
+
+// the file name without its directory
+WString GetFileNamePart(const WString& strPath)
+{
+	const size_t nPos = strPath.find_last_of(U16("/\\"));
+	return nPos == WString::npos ? strPath : WString(strPath.c_str() + nPos + 1);
+}
+}  // namespace
+
+// records laid out back to back the way AppendRaw wants them
+struct Batch
+{
+	std::vector<char> m_vData;
+	size_t m_nRecords = 0;
+};
+
+struct YXDBPartitionedWriter::Partition
+{
+	unsigned m_nPartition = 0;
+
+	// the producers copy their records into m_batch under m_mutex, and queue it for the thread once it is full.
+	// The written batches are kept in m_vFreeBatches to be reused
+	std::mutex m_mutex;
+	std::condition_variable m_cvWriter;  // signaled when a batch is queued or it is closing
+	std::condition_variable m_cvProducers;  // signaled when there is room in the queue or the thread has failed
+	Batch m_batch;
+	std::deque<Batch> m_queue;
+	std::vector<Batch> m_vFreeBatches;
+	bool m_bClosing = false;
+	std::exception_ptr m_pError;
+	std::thread m_thread;
+
+	// only touched by the thread
+	std::unique_ptr<Open_AlteryxYXDB> m_pFile;
+	WString m_strFile;
+	unsigned m_nFileNum = 0;
+	uint64_t m_nFileBytes = 0;
+	int64_t m_nFileRecords = 0;
+	std::vector<OutputFile> m_vFiles;
+
+	// call with m_mutex locked.  Queues m_batch and starts a new one
+	void QueueBatch(std::unique_lock<std::mutex>& lock)
+	{
+		m_cvProducers.wait(lock, [this] { return m_pError || m_queue.size() < MaxQueuedBatches; });
+		if (m_pError)
+			std::rethrow_exception(m_pError);
+
+		m_queue.push_back(std::move(m_batch));
+		if (m_vFreeBatches.empty())
+			m_batch = Batch();
+		else
+		{
+			m_batch = std::move(m_vFreeBatches.back());
+			m_vFreeBatches.pop_back();
+		}
+		m_cvWriter.notify_one();
+	}
+};
+
+YXDBPartitionedWriter::YXDBPartitionedWriter()
+	: m_ePartitioning(E_Partitioning_RoundRobin)
+	, m_nPartitions(1)
+	, m_nKeyField(-1)
+	, m_nMaxFileSize(0)
+	, m_nNextRoundRobin(0)
+{
+}
+
+YXDBPartitionedWriter::~YXDBPartitionedWriter()
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+}
+
+void YXDBPartitionedWriter::SetPartitioning(E_Partitioning ePartitioning, unsigned nPartitions, int nKeyField /*= -1*/)
+{
+	if (nPartitions == 0)
+		throw Error(U16("YXDBPartitionedWriter::SetPartitioning: There has to be at least 1 partition"));
+	if (ePartitioning == E_Partitioning_Hash && nKeyField < 0)
+		throw Error(U16("YXDBPartitionedWriter::SetPartitioning: Hash partitioning needs a key field"));
+	m_ePartitioning = ePartitioning;
+	m_nPartitions = nPartitions;
+	m_nKeyField = nKeyField;
+}
+
+void YXDBPartitionedWriter::SetMaxFileSize(uint64_t nBytes)
+{
+	m_nMaxFileSize = nBytes;
+}
+
+void YXDBPartitionedWriter::SetFileOptions(const FileOptionsCallback& fileOptions)
+{
+	m_fileOptions = fileOptions;
+}
+
+void YXDBPartitionedWriter::Create(WString strPrefix, const U16unit* pRecordInfoXml)
+{
+	Close();
+
+	m_recordInfo = RecordInfo();
+	m_recordInfo.InitFromXml(pRecordInfoXml);
+	if (m_ePartitioning == E_Partitioning_Hash && m_nKeyField >= int(m_recordInfo.NumFields()))
+		throw Error(U16("YXDBPartitionedWriter::Create: The key field is past the end of the record"));
+
+	m_strPrefix = strPrefix;
+	m_strRecordInfoXml = pRecordInfoXml;
+	m_nNextRoundRobin = 0;
+	m_vFiles.clear();
+
+	for (unsigned x = 0; x < m_nPartitions; ++x)
+	{
+		m_vPartitions.emplace_back(new Partition);
+		m_vPartitions.back()->m_nPartition = x;
+	}
+	for (auto& pPartition : m_vPartitions)
+	{
+		Partition& partition = *pPartition;
+		partition.m_thread = std::thread([this, &partition] { WriterThread(partition); });
+	}
+}
+
+unsigned YXDBPartitionedWriter::Route(const RecordData* pRec)
+{
+	if (m_nPartitions == 1)
+		return 0;
+	if (m_ePartitioning == E_Partitioning_Hash)
+		return unsigned(HashField(*m_recordInfo[m_nKeyField], pRec) % m_nPartitions);
+	return unsigned(m_nNextRoundRobin++ % m_nPartitions);
+}
+
+void YXDBPartitionedWriter::AppendRecord(const RecordData* pRec)
+{
+	AppendRecords(&pRec, 1);
+}
+
+void YXDBPartitionedWriter::AppendRecords(const RecordData* const* ppRecords, size_t nRecords)
+{
+	if (m_vPartitions.empty())
+		throw Error(U16("YXDBPartitionedWriter::AppendRecords: The writer hasn't been created"));
+
+	const unsigned nFixedRecordSize = unsigned(m_recordInfo.GetFixedRecordSize());
+	const bool bContainsVarData = m_recordInfo.ContainsVarData();
+
+	// see RecordInfo::Write - the var data follows its length, so a whole record is one run of bytes
+	auto RecordSize = [nFixedRecordSize, bContainsVarData](const RecordData* pRec) {
+		if (!bContainsVarData)
+			return size_t(nFixedRecordSize);
+		int nVarDataSize;
+		memcpy(&nVarDataSize, ToCharP(pRec) + nFixedRecordSize, sizeof(int));
+		return size_t(nFixedRecordSize) + sizeof(int) + unsigned(nVarDataSize);
+	};
+
+	// sort the records by partition, keeping their order, so each partition is only locked once
+	std::vector<unsigned> vRoutes(nRecords);
+	std::vector<size_t> vStarts(m_nPartitions + 1, 0);
+	for (size_t x = 0; x < nRecords; ++x)
+	{
+		vRoutes[x] = Route(ppRecords[x]);
+		vStarts[vRoutes[x] + 1]++;
+	}
+	for (unsigned x = 0; x < m_nPartitions; ++x)
+		vStarts[x + 1] += vStarts[x];
+	std::vector<const RecordData*> vSorted(nRecords);
+	{
+		std::vector<size_t> vPos(vStarts.begin(), vStarts.end() - 1);
+		for (size_t x = 0; x < nRecords; ++x)
+			vSorted[vPos[vRoutes[x]]++] = ppRecords[x];
+	}
+
+	for (unsigned nPartition = 0; nPartition < m_nPartitions; ++nPartition)
+	{
+		if (vStarts[nPartition] == vStarts[nPartition + 1])
+			continue;
+
+		Partition& partition = *m_vPartitions[nPartition];
+		std::unique_lock<std::mutex> lock(partition.m_mutex);
+		if (partition.m_pError)
+			std::rethrow_exception(partition.m_pError);
+
+		for (size_t x = vStarts[nPartition]; x < vStarts[nPartition + 1]; ++x)
+		{
+			const char* pRec = ToCharP(vSorted[x]);
+			Batch& batch = partition.m_batch;
+			batch.m_vData.insert(batch.m_vData.end(), pRec, pRec + RecordSize(vSorted[x]));
+			batch.m_nRecords++;
+			if (batch.m_vData.size() >= BatchSize)
+				partition.QueueBatch(lock);
+		}
+	}
+}
+
+void YXDBPartitionedWriter::StartFile(Partition& partition)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "-%05u-%05u.yxdb", partition.m_nPartition, partition.m_nFileNum);
+
+	std::unique_ptr<Open_AlteryxYXDB> pFile(new Open_AlteryxYXDB);
+	if (m_fileOptions)
+		m_fileOptions(*pFile);
+	WString strFile = m_strPrefix + ConvertToWString(buffer);
+	pFile->Create(strFile, m_strRecordInfoXml.c_str());
+	partition.m_pFile = std::move(pFile);
+	partition.m_strFile = strFile;
+	partition.m_nFileBytes = 0;
+	partition.m_nFileRecords = 0;
+}
+
+void YXDBPartitionedWriter::FinishFile(Partition& partition)
+{
+	if (!partition.m_pFile)
+		return;
+
+	OutputFile file;
+	file.m_strFile = partition.m_strFile;
+	file.m_nPartition = partition.m_nPartition;
+	file.m_nNumRecords = partition.m_nFileRecords;
+	partition.m_pFile->Close();
+	partition.m_pFile.reset();
+	partition.m_vFiles.push_back(file);
+	partition.m_nFileNum++;
+}
+
+void YXDBPartitionedWriter::WriterThread(Partition& partition)
+{
+	try
+	{
+		const unsigned nFixedRecordSize = unsigned(m_recordInfo.GetFixedRecordSize());
+		const bool bContainsVarData = m_recordInfo.ContainsVarData();
+
+		for (;;)
+		{
+			Batch batch;
+			{
+				std::unique_lock<std::mutex> lock(partition.m_mutex);
+				partition.m_cvWriter.wait(lock, [&] { return !partition.m_queue.empty() || partition.m_bClosing; });
+				if (partition.m_queue.empty())
+					break;
+				batch = std::move(partition.m_queue.front());
+				partition.m_queue.pop_front();
+			}
+			partition.m_cvProducers.notify_all();
+
+			// without a size limit the whole batch goes into the current file.  Otherwise it is split where the
+			// file fills up, but every file gets at least 1 record however big it is
+			const char* pData = batch.m_vData.data();
+			size_t nStart = 0;
+			size_t nPos = 0;
+			size_t nRecords = 0;
+			auto Flush = [&]() {
+				if (nRecords == 0)
+					return;
+				partition.m_pFile->AppendRaw(pData + nStart, nPos - nStart, nRecords);
+				partition.m_nFileBytes += nPos - nStart;
+				partition.m_nFileRecords += int64_t(nRecords);
+				nStart = nPos;
+				nRecords = 0;
+			};
+
+			if (!partition.m_pFile)
+				StartFile(partition);
+			if (m_nMaxFileSize == 0)
+			{
+				nPos = batch.m_vData.size();
+				nRecords = batch.m_nRecords;
+			}
+			else
+			{
+				for (size_t x = 0; x < batch.m_nRecords; ++x)
+				{
+					size_t nRecordSize = nFixedRecordSize;
+					if (bContainsVarData)
+					{
+						int nVarDataSize;
+						memcpy(&nVarDataSize, pData + nPos + nFixedRecordSize, sizeof(int));
+						nRecordSize += sizeof(int) + unsigned(nVarDataSize);
+					}
+
+					const uint64_t nFileBytes = partition.m_nFileBytes + (nPos - nStart);
+					if (nFileBytes != 0 && nFileBytes + nRecordSize > m_nMaxFileSize)
+					{
+						Flush();
+						FinishFile(partition);
+						StartFile(partition);
+					}
+					nPos += nRecordSize;
+					nRecords++;
+				}
+			}
+			Flush();
+
+			std::lock_guard<std::mutex> lock(partition.m_mutex);
+			batch.m_vData.clear();
+			batch.m_nRecords = 0;
+			partition.m_vFreeBatches.push_back(std::move(batch));
+		}
+
+		// so there is always at least 1 file with the schema in it, even if there weren't any records
+		if (partition.m_nPartition == 0 && !partition.m_pFile && partition.m_vFiles.empty())
+			StartFile(partition);
+		FinishFile(partition);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(partition.m_mutex);
+		partition.m_pError = std::current_exception();
+		partition.m_cvProducers.notify_all();
+	}
+}
+
+void YXDBPartitionedWriter::Close()
+{
+	if (m_vPartitions.empty())
+		return;
+
+	for (auto& pPartition : m_vPartitions)
+	{
+		Partition& partition = *pPartition;
+		std::lock_guard<std::mutex> lock(partition.m_mutex);
+		// the last batch doesn't wait for room in the queue, since the thread is about to empty it
+		if (partition.m_batch.m_nRecords != 0)
+			partition.m_queue.push_back(std::move(partition.m_batch));
+		partition.m_bClosing = true;
+		partition.m_cvWriter.notify_one();
+	}
+
+	std::exception_ptr pError;
+	for (auto& pPartition : m_vPartitions)
+	{
+		pPartition->m_thread.join();
+		if (pPartition->m_pError && !pError)
+			pError = pPartition->m_pError;
+		// a file left open by a failure is closed here, but isn't in the manifest
+		pPartition->m_pFile.reset();
+		m_vFiles.insert(m_vFiles.end(), pPartition->m_vFiles.begin(), pPartition->m_vFiles.end());
+	}
+	m_vPartitions.clear();
+
+	if (pError)
+		std::rethrow_exception(pError);
+
+	WriteManifest();
+}
+
+void YXDBPartitionedWriter::WriteManifest()
+{
+	int64_t nNumRecords = 0;
+	for (const OutputFile& file : m_vFiles)
+		nNumRecords += file.m_nNumRecords;
+
+	WString strManifest = U16("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<YXDBManifest Partitioning=\"");
+	strManifest += m_ePartitioning == E_Partitioning_Hash ? U16("Hash") : U16("RoundRobin");
+	strManifest += U16("\" Partitions=\"") + WString(int(m_nPartitions)) + U16("\"");
+	if (m_ePartitioning == E_Partitioning_Hash)
+	{
+		strManifest += U16(" KeyField=\"")
+			+ MINIXML_NAMESPACE::MiniXmlParser::EscapeAttribute(m_recordInfo[m_nKeyField]->GetFieldName().c_str())
+			+ U16("\"");
+	}
+	strManifest += U16(" NumRecords=\"") + WString(nNumRecords) + U16("\">\n");
+	strManifest += m_recordInfo.GetRecordXmlMetaData();
+
+	// the files are named relative to the manifest, which is in the same directory
+	for (const OutputFile& file : m_vFiles)
+	{
+		strManifest += U16("<File Name=\"")
+			+ MINIXML_NAMESPACE::MiniXmlParser::EscapeAttribute(GetFileNamePart(file.m_strFile))
+			+ U16("\" Partition=\"") + WString(int(file.m_nPartition)) + U16("\" NumRecords=\"")
+			+ WString(file.m_nNumRecords) + U16("\" />\n");
+	}
+	strManifest += U16("</YXDBManifest>\n");
+
+	const AString strUtf8 = ConvertToUtf8(strManifest);
+	File_Large file;
+	file.OpenForWrite(GetManifestFile());
+	file.Write(strUtf8.c_str(), unsigned(strUtf8.length()));
+	file.Close();
+}
+
+const std::vector<YXDBPartitionedWriter::OutputFile>& YXDBPartitionedWriter::GetFiles() const
+{
+	return m_vFiles;
+}
+
+WString YXDBPartitionedWriter::GetManifestFile() const
+{
+	return m_strPrefix + U16(".manifest.xml");
+}
+
+}}  // namespace Alteryx::OpenYXDB
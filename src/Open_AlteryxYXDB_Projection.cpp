@@ -0,0 +1,182 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+
+#include "RecordLib/FieldAccessor.h"
+#include "RecordLib/FieldNumBatch.h"
+
+namespace Alteryx { namespace OpenYXDB {
+
+namespace {
+template <class T>
+void ProjectNum(
+	const FieldBase& field,
+	const RecordInfo& recordInfo,
+	const std::vector<const RecordData*>& vRecords,
+	ProjectedColumn& r_column)
+{
+	r_column.m_vValues.resize(vRecords.size() * sizeof(T));
+	T* pValues = reinterpret_cast<T*>(r_column.m_vValues.data());
+	if (vRecords.empty())
+		return;
+
+	// without var data the records in a block are all the same size, so the gather can stride through them
+	if (!recordInfo.ContainsVarData())
+		GatherNumStrided(
+			field,
+			vRecords[0],
+			size_t(recordInfo.GetFixedRecordSize()),
+			vRecords.size(),
+			pValues,
+			r_column.m_vNulls.data());
+	else
+		GatherNum(field, vRecords.data(), vRecords.size(), pValues, r_column.m_vNulls.data());
+}
+
+void ProjectBool(const FieldBase& field, const std::vector<const RecordData*>& vRecords, ProjectedColumn& r_column)
+{
+	const FieldAccessor_Bool accessor(field);
+	r_column.m_vValues.resize(vRecords.size());
+	for (size_t x = 0; x < vRecords.size(); ++x)
+	{
+		TFieldVal<bool> val = accessor.Get(vRecords[x]);
+		r_column.m_vNulls[x] = val.bIsNull;
+		r_column.m_vValues[x] = val.value;
+	}
+}
+
+inline void AppendBytes(ProjectedColumn& r_column, size_t x, const void* pValue, size_t nLength)
+{
+	r_column.m_vBytes.insert(
+		r_column.m_vBytes.end(),
+		static_cast<const unsigned char*>(pValue),
+		static_cast<const unsigned char*>(pValue) + nLength);
+	r_column.m_vOffsets[x + 1] = r_column.m_vBytes.size();
+}
+
+template <class TChar>
+void ProjectFixedString(
+	const std::vector<const RecordData*>& vRecords,
+	unsigned nOffset,
+	unsigned nFieldLen,
+	ProjectedColumn& r_column)
+{
+	// Date, Time, DateTime and FixedDecimal are laid out the same as a String
+	for (size_t x = 0; x < vRecords.size(); ++x)
+	{
+		TFieldVal<TBlobVal<TChar>> val =
+			FieldAccessorDetail::FixedStringLayout<TChar>::Get(vRecords[x], nOffset, nFieldLen);
+		r_column.m_vNulls[x] = val.bIsNull;
+		AppendBytes(r_column, x, val.value.pValue, val.value.nLength * sizeof(TChar));
+	}
+}
+
+void ProjectVarData(const std::vector<const RecordData*>& vRecords, unsigned nOffset, ProjectedColumn& r_column)
+{
+	for (size_t x = 0; x < vRecords.size(); ++x)
+	{
+		BlobVal val = RecordInfo::GetVarDataValue(vRecords[x], nOffset);
+		r_column.m_vNulls[x] = val.pValue == NULL;
+		AppendBytes(r_column, x, val.pValue, val.nLength);
+	}
+}
+}  // namespace
+
+void Open_AlteryxYXDB::SetProjection(const std::vector<unsigned>& vFields)
+{
+	for (unsigned nField : vFields)
+	{
+		if (nField >= m_recordInfo.NumFields())
+			throw Error(U16("Open_AlteryxYXDB::SetProjection: Invalid field number"));
+	}
+	m_vProjection = vFields;
+}
+
+void Open_AlteryxYXDB::SetProjection(const std::vector<StringNoCase>& vFieldNames)
+{
+	std::vector<unsigned> vFields;
+	vFields.reserve(vFieldNames.size());
+	for (const StringNoCase& strFieldName : vFieldNames)
+		vFields.push_back(unsigned(m_recordInfo.GetFieldNum(strFieldName)));
+	m_vProjection.swap(vFields);
+}
+
+void Open_AlteryxYXDB::ReadProjectedBlock(unsigned nBlock, ProjectedBlock& r_block) const
+{
+	ReadRecordBlock(nBlock, r_block.m_recordBlock, r_block.m_vScratch);
+
+	const std::vector<const RecordData*>& vRecords = r_block.m_recordBlock.m_vRecords;
+	r_block.m_nBlock = nBlock;
+	r_block.m_nFirstRecord = r_block.m_recordBlock.m_nFirstRecord;
+	r_block.m_nNumRecords = unsigned(vRecords.size());
+	r_block.m_vColumns.resize(m_vProjection.size());
+
+	for (size_t nColumn = 0; nColumn < m_vProjection.size(); ++nColumn)
+	{
+		const FieldBase* pField = m_recordInfo[m_vProjection[nColumn]];
+		const unsigned nOffset = unsigned(pField->GetOffset());
+
+		ProjectedColumn& column = r_block.m_vColumns[nColumn];
+		column.m_nField = m_vProjection[nColumn];
+		column.m_ft = pField->m_ft;
+		column.m_bIsBytes = false;
+		column.m_vNulls.resize(vRecords.size());
+		column.m_vValues.clear();
+		column.m_vOffsets.clear();
+		column.m_vBytes.clear();
+
+		switch (pField->m_ft)
+		{
+			case E_FT_Bool:
+				ProjectBool(*pField, vRecords, column);
+				continue;
+			case E_FT_Byte:
+				ProjectNum<unsigned char>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			case E_FT_Int16:
+				ProjectNum<int16_t>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			case E_FT_Int32:
+				ProjectNum<int32_t>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			case E_FT_Int64:
+				ProjectNum<int64_t>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			case E_FT_Float:
+				ProjectNum<float>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			case E_FT_Double:
+				ProjectNum<double>(*pField, m_recordInfo, vRecords, column);
+				continue;
+			default:
+				break;
+		}
+
+		column.m_bIsBytes = true;
+		column.m_vOffsets.resize(vRecords.size() + 1);
+		column.m_vOffsets[0] = 0;
+		switch (pField->m_ft)
+		{
+			case E_FT_String:
+			case E_FT_Date:
+			case E_FT_Time:
+			case E_FT_DateTime:
+			case E_FT_FixedDecimal:
+				ProjectFixedString<char>(vRecords, nOffset, pField->m_nSize, column);
+				break;
+			case E_FT_WString:
+				ProjectFixedString<U16unit>(vRecords, nOffset, pField->m_nSize, column);
+				break;
+			case E_FT_V_String:
+			case E_FT_V_WString:
+			case E_FT_Blob:
+			case E_FT_SpatialObj:
+				ProjectVarData(vRecords, nOffset, column);
+				break;
+			default:
+				throw Error(U16("Open_AlteryxYXDB::ReadProjectedBlock: Unsupported field type"));
+		}
+	}
+}
+
+}}  // namespace Alteryx::OpenYXDB
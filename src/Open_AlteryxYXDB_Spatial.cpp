@@ -0,0 +1,382 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Alteryx { namespace OpenYXDB {
+
+namespace {
+// the ESRI shape types.  See the ESRI Shapefile Technical Description
+enum E_ShpType
+{
+	E_ShpType_Null = 0,
+	E_ShpType_Point = 1,
+	E_ShpType_PolyLine = 3,
+	E_ShpType_Polygon = 5,
+	E_ShpType_MultiPoint = 8,
+	E_ShpType_PointZ = 11,
+	E_ShpType_PolyLineZ = 13,
+	E_ShpType_PolygonZ = 15,
+	E_ShpType_MultiPointZ = 18,
+	E_ShpType_PointM = 21,
+	E_ShpType_PolyLineM = 23,
+	E_ShpType_PolygonM = 25,
+	E_ShpType_MultiPointM = 28,
+	E_ShpType_MultiPatch = 31
+};
+
+inline double ReadDouble(const unsigned char* p)
+{
+	double d;
+	memcpy(&d, p, sizeof(d));
+	return d;
+}
+
+// rounded outwards, so the float box always contains the double one
+inline float FloatDown(double d)
+{
+	float f = float(d);
+	if (double(f) > d)
+		f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+	return f;
+}
+inline float FloatUp(double d)
+{
+	float f = float(d);
+	if (double(f) < d)
+		f = std::nextafter(f, std::numeric_limits<float>::infinity());
+	return f;
+}
+
+inline SpatialIndex::Box EmptyBox()
+{
+	const float fInf = std::numeric_limits<float>::infinity();
+	SpatialIndex::Box ret = { fInf, fInf, -fInf, -fInf };
+	return ret;
+}
+
+inline void ExtendBox(SpatialIndex::Box& r_box, const SpatialIndex::Box& o)
+{
+	r_box.m_fMinX = std::min(r_box.m_fMinX, o.m_fMinX);
+	r_box.m_fMinY = std::min(r_box.m_fMinY, o.m_fMinY);
+	r_box.m_fMaxX = std::max(r_box.m_fMaxX, o.m_fMaxX);
+	r_box.m_fMaxY = std::max(r_box.m_fMaxY, o.m_fMaxY);
+}
+
+inline bool BoxIntersects(const SpatialIndex::Box& box, const SpatialBoundingBox& query)
+{
+	return box.m_fMinX <= query.m_dMaxX && query.m_dMinX <= box.m_fMaxX && box.m_fMinY <= query.m_dMaxY
+		   && query.m_dMinY <= box.m_fMaxY;
+}
+
+// the bounding box of the SpatialObj field at nOffset.  GetAsSpatialBlob validates the blob, and isn't
+// thread safe, so this goes to the var data directly
+inline SpatialBoundingBox GetFieldBoundingBox(const RecordData* pRec, int nOffset)
+{
+	BlobVal val = RecordInfo::GetVarDataValue(pRec, nOffset);
+	return SpatialBoundingBox::FromShpBlob(val.pValue, val.nLength);
+}
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// SpatialBoundingBox
+
+SpatialBoundingBox::SpatialBoundingBox()
+	: m_dMinX(std::numeric_limits<double>::infinity())
+	, m_dMinY(std::numeric_limits<double>::infinity())
+	, m_dMaxX(-std::numeric_limits<double>::infinity())
+	, m_dMaxY(-std::numeric_limits<double>::infinity())
+{
+}
+
+SpatialBoundingBox::SpatialBoundingBox(double dMinX, double dMinY, double dMaxX, double dMaxY)
+	: m_dMinX(dMinX)
+	, m_dMinY(dMinY)
+	, m_dMaxX(dMaxX)
+	, m_dMaxY(dMaxY)
+{
+}
+
+void SpatialBoundingBox::Extend(const SpatialBoundingBox& o)
+{
+	if (o.IsEmpty())
+		return;
+	m_dMinX = std::min(m_dMinX, o.m_dMinX);
+	m_dMinY = std::min(m_dMinY, o.m_dMinY);
+	m_dMaxX = std::max(m_dMaxX, o.m_dMaxX);
+	m_dMaxY = std::max(m_dMaxY, o.m_dMaxY);
+}
+
+/*static*/ SpatialBoundingBox SpatialBoundingBox::FromShpBlob(const void* pBlob, size_t nLength)
+{
+	const unsigned char* p = static_cast<const unsigned char*>(pBlob);
+	if (p == NULL || nLength < sizeof(int32_t))
+		return SpatialBoundingBox();
+
+	int32_t nShpType;
+	memcpy(&nShpType, p, sizeof(nShpType));
+	SpatialBoundingBox ret;
+	switch (nShpType)
+	{
+		case E_ShpType_Point:
+		case E_ShpType_PointZ:
+		case E_ShpType_PointM:
+			// just X and Y
+			if (nLength >= 4 + 2 * sizeof(double))
+			{
+				ret.m_dMinX = ret.m_dMaxX = ReadDouble(p + 4);
+				ret.m_dMinY = ret.m_dMaxY = ReadDouble(p + 12);
+			}
+			break;
+		case E_ShpType_PolyLine:
+		case E_ShpType_Polygon:
+		case E_ShpType_MultiPoint:
+		case E_ShpType_PolyLineZ:
+		case E_ShpType_PolygonZ:
+		case E_ShpType_MultiPointZ:
+		case E_ShpType_PolyLineM:
+		case E_ShpType_PolygonM:
+		case E_ShpType_MultiPointM:
+		case E_ShpType_MultiPatch:
+			// the box comes first - Xmin, Ymin, Xmax, Ymax
+			if (nLength >= 4 + 4 * sizeof(double))
+			{
+				ret.m_dMinX = ReadDouble(p + 4);
+				ret.m_dMinY = ReadDouble(p + 12);
+				ret.m_dMaxX = ReadDouble(p + 20);
+				ret.m_dMaxY = ReadDouble(p + 28);
+			}
+			break;
+		default:
+			break;
+	}
+
+	// this also catches NaN's
+	if (ret.IsEmpty())
+		return SpatialBoundingBox();
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SpatialIndex
+
+void SpatialIndex::Clear()
+{
+	m_vRecordBoxes.clear();
+	m_vGroupBoxes.clear();
+}
+
+void SpatialIndex::Resize(int64_t nRecords)
+{
+	m_vRecordBoxes.assign(size_t(nRecords), EmptyBox());
+	m_vGroupBoxes.clear();
+}
+
+void SpatialIndex::Set(int64_t nRecord, const SpatialBoundingBox& box)
+{
+	Box& r_box = m_vRecordBoxes[size_t(nRecord)];
+	if (box.IsEmpty())
+		r_box = EmptyBox();
+	else
+	{
+		r_box.m_fMinX = FloatDown(box.m_dMinX);
+		r_box.m_fMinY = FloatDown(box.m_dMinY);
+		r_box.m_fMaxX = FloatUp(box.m_dMaxX);
+		r_box.m_fMaxY = FloatUp(box.m_dMaxY);
+	}
+}
+
+void SpatialIndex::Append(const SpatialBoundingBox& box)
+{
+	m_vRecordBoxes.push_back(EmptyBox());
+	Set(int64_t(m_vRecordBoxes.size() - 1), box);
+}
+
+void SpatialIndex::Assign(std::vector<Box>&& vRecordBoxes)
+{
+	m_vRecordBoxes.swap(vRecordBoxes);
+	m_vGroupBoxes.clear();
+}
+
+void SpatialIndex::Finish()
+{
+	const size_t nGroups = (m_vRecordBoxes.size() + GroupSize - 1) / GroupSize;
+	m_vGroupBoxes.assign(nGroups, EmptyBox());
+	for (size_t x = 0; x < m_vRecordBoxes.size(); ++x)
+		ExtendBox(m_vGroupBoxes[x / GroupSize], m_vRecordBoxes[x]);
+}
+
+std::vector<int64_t> SpatialIndex::Query(const SpatialBoundingBox& box) const
+{
+	std::vector<int64_t> vRet;
+	if (box.IsEmpty())
+		return vRet;
+
+	for (size_t nGroup = 0; nGroup < m_vGroupBoxes.size(); ++nGroup)
+	{
+		if (!BoxIntersects(m_vGroupBoxes[nGroup], box))
+			continue;
+
+		const size_t nEnd = std::min(m_vRecordBoxes.size(), (nGroup + 1) * GroupSize);
+		for (size_t x = nGroup * GroupSize; x < nEnd; ++x)
+		{
+			if (BoxIntersects(m_vRecordBoxes[x], box))
+				vRet.push_back(int64_t(x));
+		}
+	}
+	return vRet;
+}
+
+std::vector<unsigned> SpatialIndex::QueryBlocks(const SpatialBoundingBox& box) const
+{
+	static_assert(RecordsPerBlock % GroupSize == 0, "a group must not straddle record blocks");
+
+	std::vector<unsigned> vRet;
+	if (box.IsEmpty())
+		return vRet;
+
+	const size_t nGroupsPerBlock = RecordsPerBlock / GroupSize;
+	for (size_t nGroup = 0; nGroup < m_vGroupBoxes.size(); ++nGroup)
+	{
+		const unsigned nBlock = unsigned(nGroup / nGroupsPerBlock);
+		if (!vRet.empty() && vRet.back() == nBlock)
+			continue;
+		if (!BoxIntersects(m_vGroupBoxes[nGroup], box))
+			continue;
+
+		// the group box is only a bound - make sure a record really does intersect
+		const size_t nEnd = std::min(m_vRecordBoxes.size(), (nGroup + 1) * GroupSize);
+		for (size_t x = nGroup * GroupSize; x < nEnd; ++x)
+		{
+			if (BoxIntersects(m_vRecordBoxes[x], box))
+			{
+				vRet.push_back(nBlock);
+				break;
+			}
+		}
+	}
+	return vRet;
+}
+
+SpatialBoundingBox SpatialIndex::GetExtent() const
+{
+	Box extent = EmptyBox();
+	for (const Box& box : m_vGroupBoxes)
+		ExtendBox(extent, box);
+	if (!(extent.m_fMinX <= extent.m_fMaxX))
+		return SpatialBoundingBox();
+	return SpatialBoundingBox(extent.m_fMinX, extent.m_fMinY, extent.m_fMaxX, extent.m_fMaxY);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Open_AlteryxYXDB
+
+int Open_AlteryxYXDB::FindSpatialField(int nField) const
+{
+	if (nField < 0)
+	{
+		for (unsigned x = 0; x < m_recordInfo.NumFields(); ++x)
+		{
+			if (m_recordInfo[x]->m_ft == E_FT_SpatialObj)
+				return int(x);
+		}
+		throw Error(U16("Open_AlteryxYXDB: There is no spatial field to index"));
+	}
+	if (unsigned(nField) >= m_recordInfo.NumFields() || m_recordInfo[nField]->m_ft != E_FT_SpatialObj)
+		throw Error(U16("Open_AlteryxYXDB: The spatial index field is not a spatial field"));
+	return nField;
+}
+
+void Open_AlteryxYXDB::IndexSpatialRecord(const RecordData* pRec)
+{
+	m_spatialIndex.Append(GetFieldBoundingBox(pRec, m_recordInfo[m_nSpatialIndexField]->GetOffset()));
+}
+
+void Open_AlteryxYXDB::WriteSpatialIndex()
+{
+	m_header.extHdr.nSpatialIndexField = unsigned(m_nSpatialIndexField);
+	m_header.extHdr.nSpatialIndexPos = m_pFile->Tell();
+
+	const std::vector<SpatialIndex::Box>& vBoxes = m_spatialIndex.GetRecordBoxes();
+	int64_t nSize = int64_t(vBoxes.size());
+	m_pFile->Write(&nSize, sizeof(nSize));
+
+	// in pieces, since Write takes an unsigned
+	const size_t nBoxesPerWrite = 0x1000000;
+	for (size_t x = 0; x < vBoxes.size(); x += nBoxesPerWrite)
+	{
+		const size_t nBoxes = std::min(nBoxesPerWrite, vBoxes.size() - x);
+		m_pFile->Write(vBoxes.data() + x, unsigned(nBoxes * sizeof(SpatialIndex::Box)));
+	}
+}
+
+void Open_AlteryxYXDB::LoadSpatialIndex() const
+{
+	std::lock_guard<std::mutex> lock(m_recordBlockIndexMutex);
+	if (m_bSpatialIndexLoaded)
+		return;
+
+	std::vector<unsigned char> vBuffer;
+	const int64_t nPos = m_header.extHdr.nSpatialIndexPos;
+	int64_t nSize;
+	memcpy(&nSize, m_pInFile->GetAt(nPos, sizeof(nSize), vBuffer), sizeof(nSize));
+	if (nSize != m_header.userHdr.nNumRecords)
+		throw Error(m_pInFile->GetFileName() + U16(" \nThe spatial index is corrupt."));
+
+	std::vector<SpatialIndex::Box> vBoxes(static_cast<size_t>(nSize));
+	if (nSize != 0)
+		memcpy(
+			vBoxes.data(),
+			m_pInFile->GetAt(nPos + sizeof(nSize), vBoxes.size() * sizeof(SpatialIndex::Box), vBuffer),
+			vBoxes.size() * sizeof(SpatialIndex::Box));
+	m_spatialIndex.Assign(std::move(vBoxes));
+	m_spatialIndex.Finish();
+	m_bSpatialIndexLoaded = true;
+}
+
+void Open_AlteryxYXDB::BuildSpatialIndex(int nField /*= -1*/, unsigned nThreads /*= 0*/)
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::BuildSpatialIndex: The file is not open for reading"));
+
+	nField = FindSpatialField(nField);
+
+	// every record has its own slot, so the workers don't need to coordinate
+	m_nSpatialIndexField = -1;
+	m_spatialIndex.Resize(m_header.userHdr.nNumRecords);
+	const int nOffset = m_recordInfo[nField]->GetOffset();
+	ParallelScan(
+		[this, nOffset](unsigned /*nBlock*/, int64_t nRecord, const RecordData* pRec) {
+			m_spatialIndex.Set(nRecord, GetFieldBoundingBox(pRec, nOffset));
+		},
+		nThreads,
+		false);
+	m_spatialIndex.Finish();
+	m_nSpatialIndexField = nField;
+	m_bSpatialIndexLoaded = true;
+}
+
+int Open_AlteryxYXDB::GetSpatialIndexField() const
+{
+	return m_nSpatialIndexField;
+}
+
+std::vector<int64_t> Open_AlteryxYXDB::QuerySpatialIndex(const SpatialBoundingBox& box) const
+{
+	if (m_nSpatialIndexField < 0)
+		throw Error(U16("Open_AlteryxYXDB::QuerySpatialIndex: There is no spatial index"));
+	LoadSpatialIndex();
+	return m_spatialIndex.Query(box);
+}
+
+std::vector<unsigned> Open_AlteryxYXDB::QuerySpatialIndexBlocks(const SpatialBoundingBox& box) const
+{
+	if (m_nSpatialIndexField < 0)
+		throw Error(U16("Open_AlteryxYXDB::QuerySpatialIndexBlocks: There is no spatial index"));
+	LoadSpatialIndex();
+	return m_spatialIndex.QueryBlocks(box);
+}
+
+}}  // namespace Alteryx::OpenYXDB
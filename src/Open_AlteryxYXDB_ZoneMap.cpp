@@ -0,0 +1,731 @@
+#include "stdafx.h"
+
+#include "Open_AlteryxYXDB.h"
+
+#include "RecordLib/FieldAccessor.h"
+
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace Alteryx { namespace OpenYXDB {
+
+namespace {
+// the key of a value - see ZoneMapStats
+union Key
+{
+	int64_t n;
+	double d;
+};
+
+// the distinct counts are estimated with a HyperLogLog sketch of this many 1 byte registers per field
+const unsigned SketchRegisters = 1024;
+const unsigned SketchIndexBits = 10;
+
+// the # of digits in the key of a Date, Time or DateTime, or 0 for anything else
+inline unsigned DateTimeDigits(E_FieldType ft)
+{
+	switch (ft)
+	{
+		case E_FT_Date:
+			return 8;
+		case E_FT_Time:
+			return 6;
+		case E_FT_DateTime:
+			return 14;
+		default:
+			return 0;
+	}
+}
+
+// the digits of a date or time as a number, filled out to nDigits with nFill.  Anything that isn't a digit is skipped
+int64_t DateTimeKey(const char* p, size_t nLen, unsigned nDigits, int nFill)
+{
+	int64_t nRet = 0;
+	unsigned nFound = 0;
+	for (size_t x = 0; x < nLen && p[x] != 0 && nFound < nDigits; ++x)
+	{
+		if (p[x] >= '0' && p[x] <= '9')
+		{
+			nRet = nRet * 10 + (p[x] - '0');
+			++nFound;
+		}
+	}
+	for (; nFound < nDigits; ++nFound)
+		nRet = nRet * 10 + nFill;
+	return nRet;
+}
+
+template <E_FieldType ft>
+inline bool GetIntKey(const char* pField, Key& r_key)
+{
+	typedef FieldAccessorDetail::Layout<ft> T_Layout;
+	if (T_Layout::GetNull(pField))
+		return false;
+	r_key.n = int64_t(T_Layout::GetValue(pField));
+	return true;
+}
+
+template <E_FieldType ft>
+inline bool GetDoubleKey(const char* pField, Key& r_key)
+{
+	typedef FieldAccessorDetail::Layout<ft> T_Layout;
+	if (T_Layout::GetNull(pField))
+		return false;
+	r_key.d = double(T_Layout::GetValue(pField));
+	return true;
+}
+
+// returns false if the value is null.  The field has to have a key
+bool GetKey(const FieldBase& field, const RecordData* pRec, Key& r_key)
+{
+	const unsigned nOffset = unsigned(field.GetOffset());
+	const char* pField = ToCharP(pRec) + nOffset;
+	switch (field.m_ft)
+	{
+		case E_FT_Bool:
+			return GetIntKey<E_FT_Bool>(pField, r_key);
+		case E_FT_Byte:
+			return GetIntKey<E_FT_Byte>(pField, r_key);
+		case E_FT_Int16:
+			return GetIntKey<E_FT_Int16>(pField, r_key);
+		case E_FT_Int32:
+			return GetIntKey<E_FT_Int32>(pField, r_key);
+		case E_FT_Int64:
+			return GetIntKey<E_FT_Int64>(pField, r_key);
+		case E_FT_Float:
+			return GetDoubleKey<E_FT_Float>(pField, r_key);
+		case E_FT_Double:
+			return GetDoubleKey<E_FT_Double>(pField, r_key);
+		case E_FT_Date:
+		case E_FT_Time:
+		case E_FT_DateTime:
+			if (FieldAccessorDetail::FixedStringLayout<char>::GetNull(pRec, nOffset, unsigned(field.m_nSize)))
+				return false;
+			r_key.n = DateTimeKey(pField, unsigned(field.m_nSize), DateTimeDigits(field.m_ft), 0);
+			return true;
+		case E_FT_FixedDecimal:
+		{
+			if (FieldAccessorDetail::FixedDecimalLayout::GetNull(pRec, nOffset, unsigned(field.m_nSize)))
+				return false;
+			r_key.d = FieldAccessorDetail::FixedDecimalLayout::GetDouble(pField, unsigned(field.m_nSize));
+			return true;
+		}
+		default:
+			assert(false);
+			return false;
+	}
+}
+
+inline uint64_t HashKey(Key key, bool bDouble)
+{
+	// so 0 and -0 are the same value
+	if (bDouble && key.d == 0)
+		key.n = 0;
+
+	// the splitmix64 finalizer
+	uint64_t h = uint64_t(key.n);
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ull;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebull;
+	h ^= h >> 31;
+	return h;
+}
+
+inline void AddToSketch(unsigned char* pRegisters, uint64_t h)
+{
+	// the top bits pick the register, which keeps the longest run of leading 0's seen in the rest
+	unsigned char& r_register = pRegisters[h >> (64 - SketchIndexBits)];
+	uint64_t nRest = h << SketchIndexBits;
+	unsigned char nRank = 1;
+	while (nRank <= 64 - SketchIndexBits && (nRest & (uint64_t(1) << 63)) == 0)
+	{
+		nRest <<= 1;
+		++nRank;
+	}
+	if (nRank > r_register)
+		r_register = nRank;
+}
+
+unsigned EstimateDistinct(const unsigned char* pRegisters)
+{
+	const double m = SketchRegisters;
+	double dSum = 0;
+	unsigned nZeros = 0;
+	for (unsigned x = 0; x < SketchRegisters; ++x)
+	{
+		dSum += std::ldexp(1.0, -int(pRegisters[x]));
+		if (pRegisters[x] == 0)
+			++nZeros;
+	}
+
+	double dEstimate = 0.7213 / (1 + 1.079 / m) * m * m / dSum;
+	// linear counting is more accurate for the small counts
+	if (dEstimate <= 2.5 * m && nZeros != 0)
+		dEstimate = m * std::log(m / nZeros);
+	return unsigned(dEstimate + 0.5);
+}
+
+ZoneMapStats EmptyStats(bool bDouble)
+{
+	ZoneMapStats ret;
+	if (bDouble)
+	{
+		ret.dMin = std::numeric_limits<double>::infinity();
+		ret.dMax = -std::numeric_limits<double>::infinity();
+	}
+	else
+	{
+		ret.nMin = std::numeric_limits<int64_t>::max();
+		ret.nMax = std::numeric_limits<int64_t>::min();
+	}
+	ret.nNullCount = 0;
+	ret.nDistinctCount = 0;
+	return ret;
+}
+
+inline unsigned NumBlockRecords(int64_t nNumRecords, unsigned nBlock)
+{
+	return unsigned(std::min<int64_t>(RecordsPerBlock, nNumRecords - int64_t(nBlock) * RecordsPerBlock));
+}
+
+// whether str is the start of a value laid out as a Date ("yyyy-mm-dd"), Time ("hh:mm:ss") or DateTime is stored
+bool IsDateTimePrefix(const WString& str, E_FieldType ft)
+{
+	const char* pLayout = ft == E_FT_Date ? "0000-00-00" : ft == E_FT_Time ? "00:00:00" : "0000-00-00 00:00:00";
+	if (str.Length() > strlen(pLayout))
+		return false;
+	for (unsigned x = 0; x < str.Length(); ++x)
+	{
+		const U16unit c = str[x];
+		if (pLayout[x] == '0' ? c < '0' || c > '9' : c != U16unit(pLayout[x]))
+			return false;
+	}
+	return true;
+}
+
+// adds the term for a RecordPredicate::Bound on field nField, or returns false if the stats can't check it.
+// RecordPredicate compares a Date, Time or DateTime as the string it is stored as, and the stats as its digits.
+// Those sort the same way as long as the string being compared to is laid out like the stored values, so an end of
+// the range that isn't is left open
+bool AddBoundTerm(ScanPredicate& r_predicate, unsigned nField, const RecordPredicate::Bound& bound)
+{
+	const E_FieldType ft = bound.m_pField->m_ft;
+	switch (bound.m_eKind)
+	{
+		case RecordPredicate::Bound::E_Kind_IsNull:
+			r_predicate.AddIsNull(nField);
+			return true;
+		case RecordPredicate::Bound::E_Kind_IsNotNull:
+			r_predicate.AddIsNotNull(nField);
+			return true;
+		case RecordPredicate::Bound::E_Kind_IntRange:
+			if (!ScanPredicate::HasKey(ft))
+				return false;
+			r_predicate.AddIntRange(nField, bound.m_nMin, bound.m_nMax);
+			return true;
+		case RecordPredicate::Bound::E_Kind_DoubleRange:
+			if (!ScanPredicate::HasKey(ft))
+				return false;
+			r_predicate.AddDoubleRange(nField, bound.m_dMin, bound.m_dMax);
+			return true;
+		case RecordPredicate::Bound::E_Kind_StringRange:
+		{
+			if (DateTimeDigits(ft) == 0)
+				return false;
+			// AddDateTimeRange fills an empty min with 0's and an empty max with 9's
+			const AString strMin(
+				bound.m_bHasMin && IsDateTimePrefix(bound.m_strMin, ft) ? ConvertToAString(bound.m_strMin) : AString());
+			const AString strMax(
+				bound.m_bHasMax && IsDateTimePrefix(bound.m_strMax, ft) ? ConvertToAString(bound.m_strMax) : AString());
+			r_predicate.AddDateTimeRange(nField, strMin.c_str(), strMax.c_str());
+			return true;
+		}
+	}
+	return false;
+}
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////
+// ScanPredicate
+
+ScanPredicate::ScanPredicate(const RecordInfo& recordInfo)
+	: m_pRecordInfo(&recordInfo)
+{
+}
+
+/*static*/ bool ScanPredicate::HasKey(E_FieldType ft)
+{
+	switch (ft)
+	{
+		case E_FT_Bool:
+		case E_FT_Byte:
+		case E_FT_Int16:
+		case E_FT_Int32:
+		case E_FT_Int64:
+		case E_FT_Float:
+		case E_FT_Double:
+		case E_FT_Date:
+		case E_FT_Time:
+		case E_FT_DateTime:
+		case E_FT_FixedDecimal:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*static*/ bool ScanPredicate::HasDoubleKey(E_FieldType ft)
+{
+	return ft == E_FT_Float || ft == E_FT_Double || ft == E_FT_FixedDecimal;
+}
+
+ScanPredicate::Term& ScanPredicate::AddTerm(unsigned nField, E_Op eOp, bool bKeyed)
+{
+	if (nField >= m_pRecordInfo->NumFields())
+		throw Error(U16("ScanPredicate: The field number is out of range"));
+
+	const FieldBase* pField = (*m_pRecordInfo)[nField];
+	if (bKeyed && !HasKey(pField->m_ft))
+		throw Error(XMSG(
+			"ScanPredicate: Field @1 is @2, which can't be compared by range.",
+			pField->GetFieldName().c_str(),
+			GetNameFromFieldType(pField->m_ft)));
+
+	Term term;
+	term.m_pField = pField;
+	term.m_nField = nField;
+	term.m_eOp = eOp;
+	term.m_nMin = 0;
+	term.m_nMax = 0;
+	m_vTerms.push_back(term);
+	return m_vTerms.back();
+}
+
+ScanPredicate& ScanPredicate::AddIntRange(unsigned nField, int64_t nMin, int64_t nMax)
+{
+	Term& term = AddTerm(nField, E_Op_Range, true);
+	if (HasDoubleKey(term.m_pField->m_ft))
+	{
+		term.m_dMin = double(nMin);
+		term.m_dMax = double(nMax);
+	}
+	else
+	{
+		term.m_nMin = nMin;
+		term.m_nMax = nMax;
+	}
+	return *this;
+}
+
+ScanPredicate& ScanPredicate::AddDoubleRange(unsigned nField, double dMin, double dMax)
+{
+	Term& term = AddTerm(nField, E_Op_Range, true);
+	if (HasDoubleKey(term.m_pField->m_ft))
+	{
+		term.m_dMin = dMin;
+		term.m_dMax = dMax;
+		return *this;
+	}
+
+	// the whole numbers in the range.  -2^63 is the smallest int64, and 2^63 is just past the biggest
+	const double dTwo63 = 9223372036854775808.0;
+	if (!(dMin <= dMax) || dMin >= dTwo63 || dMax < -dTwo63)
+	{
+		term.m_nMin = std::numeric_limits<int64_t>::max();
+		term.m_nMax = std::numeric_limits<int64_t>::min();
+	}
+	else
+	{
+		term.m_nMin = dMin <= -dTwo63 ? std::numeric_limits<int64_t>::min() : int64_t(std::ceil(dMin));
+		term.m_nMax = dMax >= dTwo63 ? std::numeric_limits<int64_t>::max() : int64_t(std::floor(dMax));
+	}
+	return *this;
+}
+
+ScanPredicate& ScanPredicate::AddDateTimeRange(unsigned nField, const char* pMin, const char* pMax)
+{
+	Term& term = AddTerm(nField, E_Op_Range, true);
+	const unsigned nDigits = DateTimeDigits(term.m_pField->m_ft);
+	if (nDigits == 0)
+	{
+		m_vTerms.pop_back();
+		throw Error(U16("ScanPredicate::AddDateTimeRange: The field is not a Date, Time or DateTime"));
+	}
+	term.m_nMin = DateTimeKey(pMin, strlen(pMin), nDigits, 0);
+	term.m_nMax = DateTimeKey(pMax, strlen(pMax), nDigits, 9);
+	return *this;
+}
+
+ScanPredicate& ScanPredicate::AddIsNull(unsigned nField)
+{
+	AddTerm(nField, E_Op_IsNull, false);
+	return *this;
+}
+
+ScanPredicate& ScanPredicate::AddIsNotNull(unsigned nField)
+{
+	AddTerm(nField, E_Op_IsNotNull, false);
+	return *this;
+}
+
+bool ScanPredicate::Matches(const RecordData* pRec) const
+{
+	for (const Term& term : m_vTerms)
+	{
+		switch (term.m_eOp)
+		{
+			case E_Op_Range:
+			{
+				Key key;
+				if (!GetKey(*term.m_pField, pRec, key))
+					return false;
+				if (HasDoubleKey(term.m_pField->m_ft))
+				{
+					if (!(key.d >= term.m_dMin && key.d <= term.m_dMax))
+						return false;
+				}
+				else if (key.n < term.m_nMin || key.n > term.m_nMax)
+					return false;
+				break;
+			}
+			case E_Op_IsNull:
+				if (!term.m_pField->GetNull(pRec))
+					return false;
+				break;
+			case E_Op_IsNotNull:
+				if (term.m_pField->GetNull(pRec))
+					return false;
+				break;
+		}
+	}
+	return true;
+}
+
+bool ScanPredicate::MightMatch(const ZoneMapStats* const* ppStats, unsigned nRecords) const
+{
+	for (size_t x = 0; x < m_vTerms.size(); ++x)
+	{
+		const ZoneMapStats* pStats = ppStats[x];
+		if (pStats == NULL)
+			continue;
+
+		const Term& term = m_vTerms[x];
+		switch (term.m_eOp)
+		{
+			case E_Op_Range:
+				// an empty block range means there are no values to compare
+				if (HasDoubleKey(term.m_pField->m_ft))
+				{
+					if (!(pStats->dMin <= pStats->dMax) || term.m_dMax < pStats->dMin || term.m_dMin > pStats->dMax)
+						return false;
+				}
+				else if (
+					pStats->nMin > pStats->nMax || term.m_nMax < pStats->nMin || term.m_nMin > pStats->nMax)
+					return false;
+				break;
+			case E_Op_IsNull:
+				if (pStats->nNullCount == 0)
+					return false;
+				break;
+			case E_Op_IsNotNull:
+				if (pStats->nNullCount >= nRecords)
+					return false;
+				break;
+		}
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Open_AlteryxYXDB
+
+void Open_AlteryxYXDB::StartZoneMaps()
+{
+	m_vZoneMapFields.clear();
+	m_vZoneMaps.clear();
+	if (m_bWriteZoneMaps)
+	{
+		for (unsigned x = 0; x < m_recordInfo.NumFields(); ++x)
+		{
+			if (ScanPredicate::HasKey(m_recordInfo[x]->m_ft))
+				m_vZoneMapFields.push_back(x);
+		}
+	}
+	m_vZoneMapRegisters.assign(m_vZoneMapFields.size() * SketchRegisters, 0);
+}
+
+void Open_AlteryxYXDB::AddZoneMapRecord(int64_t nRecord, const RecordData* pRec)
+{
+	const size_t nFields = m_vZoneMapFields.size();
+	if ((nRecord % RecordsPerBlock) == 0)
+	{
+		if (nRecord != 0)
+			FinishZoneMapBlock();
+		for (unsigned nField : m_vZoneMapFields)
+			m_vZoneMaps.push_back(EmptyStats(ScanPredicate::HasDoubleKey(m_recordInfo[nField]->m_ft)));
+	}
+
+	ZoneMapStats* pStats = m_vZoneMaps.data() + m_vZoneMaps.size() - nFields;
+	for (size_t x = 0; x < nFields; ++x)
+	{
+		const FieldBase& field = *m_recordInfo[m_vZoneMapFields[x]];
+		ZoneMapStats& r_stats = pStats[x];
+		Key key;
+		if (!GetKey(field, pRec, key))
+		{
+			r_stats.nNullCount++;
+			continue;
+		}
+
+		const bool bDouble = ScanPredicate::HasDoubleKey(field.m_ft);
+		if (bDouble)
+		{
+			// NaN's aren't in any range, so they are left out
+			if (key.d < r_stats.dMin)
+				r_stats.dMin = key.d;
+			if (key.d > r_stats.dMax)
+				r_stats.dMax = key.d;
+		}
+		else
+		{
+			if (key.n < r_stats.nMin)
+				r_stats.nMin = key.n;
+			if (key.n > r_stats.nMax)
+				r_stats.nMax = key.n;
+		}
+		AddToSketch(&m_vZoneMapRegisters[x * SketchRegisters], HashKey(key, bDouble));
+	}
+}
+
+void Open_AlteryxYXDB::FinishZoneMapBlock()
+{
+	const size_t nFields = m_vZoneMapFields.size();
+	// m_nCurrentRecord is already past the end of the block, unless it is the last one
+	const unsigned nBlock = unsigned(m_vZoneMaps.size() / nFields - 1);
+	const unsigned nRecords = NumBlockRecords(m_nCurrentRecord, nBlock);
+	ZoneMapStats* pStats = m_vZoneMaps.data() + m_vZoneMaps.size() - nFields;
+	for (size_t x = 0; x < nFields; ++x)
+	{
+		unsigned char* pRegisters = &m_vZoneMapRegisters[x * SketchRegisters];
+		const unsigned nValues = nRecords - pStats[x].nNullCount;
+		unsigned nDistinct = EstimateDistinct(pRegisters);
+		if (nDistinct > nValues)
+			nDistinct = nValues;
+		else if (nDistinct == 0 && nValues != 0)
+			nDistinct = 1;
+		pStats[x].nDistinctCount = nDistinct;
+		memset(pRegisters, 0, SketchRegisters);
+	}
+}
+
+void Open_AlteryxYXDB::WriteZoneMaps()
+{
+	// the last block is still open.  m_nCurrentRecord is the # of records now
+	if (!m_vZoneMaps.empty())
+		FinishZoneMapBlock();
+
+	m_header.extHdr.nZoneMapPos = m_pFile->Tell();
+	unsigned nFields = unsigned(m_vZoneMapFields.size());
+	unsigned nBlocks = unsigned(m_vZoneMaps.size() / nFields);
+	m_pFile->Write(&nFields, sizeof(nFields));
+	m_pFile->Write(&nBlocks, sizeof(nBlocks));
+	m_pFile->Write(m_vZoneMapFields.data(), unsigned(nFields * sizeof(unsigned)));
+	if (nBlocks != 0)
+		m_pFile->Write(m_vZoneMaps.data(), unsigned(m_vZoneMaps.size() * sizeof(ZoneMapStats)));
+}
+
+void Open_AlteryxYXDB::LoadZoneMaps() const
+{
+	std::lock_guard<std::mutex> lock(m_recordBlockIndexMutex);
+	if (m_bZoneMapsLoaded)
+		return;
+
+	if (HasZoneMaps())
+	{
+		std::vector<unsigned char> vBuffer;
+		int64_t nPos = m_header.extHdr.nZoneMapPos;
+		unsigned nSizes[2];
+		memcpy(nSizes, m_pInFile->GetAt(nPos, sizeof(nSizes), vBuffer), sizeof(nSizes));
+		nPos += sizeof(nSizes);
+		const unsigned nFields = nSizes[0];
+		const unsigned nBlocks = nSizes[1];
+		if (nFields == 0 || nFields > m_recordInfo.NumFields() || nBlocks != GetNumRecordBlocks())
+			throw Error(m_pInFile->GetFileName() + U16(" \nThe zone maps are corrupt."));
+
+		std::vector<unsigned> vFields(nFields);
+		memcpy(vFields.data(), m_pInFile->GetAt(nPos, nFields * sizeof(unsigned), vBuffer), nFields * sizeof(unsigned));
+		nPos += nFields * sizeof(unsigned);
+		for (unsigned nField : vFields)
+		{
+			if (nField >= m_recordInfo.NumFields() || !ScanPredicate::HasKey(m_recordInfo[nField]->m_ft))
+				throw Error(m_pInFile->GetFileName() + U16(" \nThe zone maps are corrupt."));
+		}
+
+		std::vector<ZoneMapStats> vStats(size_t(nBlocks) * nFields);
+		if (!vStats.empty())
+			memcpy(
+				vStats.data(),
+				m_pInFile->GetAt(nPos, vStats.size() * sizeof(ZoneMapStats), vBuffer),
+				vStats.size() * sizeof(ZoneMapStats));
+
+		m_vZoneMapFields.swap(vFields);
+		m_vZoneMaps.swap(vStats);
+	}
+	m_bZoneMapsLoaded = true;
+}
+
+bool Open_AlteryxYXDB::HasZoneMaps() const
+{
+	const HeaderExtension& ext = m_header.extHdr;
+	return m_pInFile && ext.IsValid() && ext.nVersion >= 5 && ext.nZoneMapPos != 0;
+}
+
+const ZoneMapStats* Open_AlteryxYXDB::GetZoneMapStats(unsigned nBlock, unsigned nField) const
+{
+	if (!HasZoneMaps())
+		return NULL;
+	LoadZoneMaps();
+
+	const size_t nFields = m_vZoneMapFields.size();
+	if (nBlock >= m_vZoneMaps.size() / nFields)
+		return NULL;
+	for (size_t x = 0; x < nFields; ++x)
+	{
+		if (m_vZoneMapFields[x] == nField)
+			return &m_vZoneMaps[nBlock * nFields + x];
+	}
+	return NULL;
+}
+
+std::vector<unsigned> Open_AlteryxYXDB::GetMatchingBlocks(const ScanPredicate& predicate) const
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::GetMatchingBlocks: The file is not open for reading"));
+
+	const unsigned nNumBlocks = GetNumRecordBlocks();
+	std::vector<unsigned> vRet;
+	vRet.reserve(nNumBlocks);
+	if (!HasZoneMaps())
+	{
+		for (unsigned x = 0; x < nNumBlocks; ++x)
+			vRet.push_back(x);
+		return vRet;
+	}
+	LoadZoneMaps();
+
+	// where each term's field is in a block's stats, or -1 if it doesn't have any
+	const std::vector<ScanPredicate::Term>& vTerms = predicate.GetTerms();
+	const size_t nFields = m_vZoneMapFields.size();
+	std::vector<int> vTermStats(vTerms.size(), -1);
+	for (size_t x = 0; x < vTerms.size(); ++x)
+		vTermStats[x] = FindZoneMapField(vTerms[x].m_nField);
+
+	std::vector<const ZoneMapStats*> vStats(vTerms.size());
+	for (unsigned nBlock = 0; nBlock < nNumBlocks; ++nBlock)
+	{
+		const ZoneMapStats* pBlockStats = m_vZoneMaps.data() + size_t(nBlock) * nFields;
+		for (size_t x = 0; x < vTerms.size(); ++x)
+			vStats[x] = vTermStats[x] < 0 ? NULL : pBlockStats + vTermStats[x];
+		if (predicate.MightMatch(vStats.data(), NumBlockRecords(m_header.userHdr.nNumRecords, nBlock)))
+			vRet.push_back(nBlock);
+	}
+	return vRet;
+}
+
+std::vector<unsigned> Open_AlteryxYXDB::GetMatchingBlocks(const RecordPredicate& predicate) const
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::GetMatchingBlocks: The file is not open for reading"));
+
+	const unsigned nNumBlocks = GetNumRecordBlocks();
+	std::vector<unsigned> vRet;
+	vRet.reserve(nNumBlocks);
+	if (HasZoneMaps())
+		LoadZoneMaps();
+
+	// each bound the stats can check becomes a ScanPredicate of its own, so they are checked the same way.
+	// The bound's field may be from another RecordInfo with the same layout, so it is found by where it is
+	struct BoundTerm
+	{
+		ScanPredicate predicate;
+		int nStats;
+	};
+	std::map<const RecordPredicate::Bound*, BoundTerm> mapTerms;
+	for (const RecordPredicate::Bound* pBound : predicate.GetBounds())
+	{
+		for (unsigned nField = 0; nField < m_recordInfo.NumFields(); ++nField)
+		{
+			const FieldBase& field = *m_recordInfo[nField];
+			if (field.GetOffset() != pBound->m_pField->GetOffset() || field.m_ft != pBound->m_pField->m_ft)
+				continue;
+
+			const int nStats = FindZoneMapField(nField);
+			ScanPredicate term(m_recordInfo);
+			if (nStats >= 0 && AddBoundTerm(term, nField, *pBound))
+				mapTerms.emplace(pBound, BoundTerm{ term, nStats });
+			break;
+		}
+	}
+
+	const size_t nFields = m_vZoneMapFields.size();
+	for (unsigned nBlock = 0; nBlock < nNumBlocks; ++nBlock)
+	{
+		if (mapTerms.empty())
+		{
+			vRet.push_back(nBlock);
+			continue;
+		}
+
+		const ZoneMapStats* pBlockStats = m_vZoneMaps.data() + size_t(nBlock) * nFields;
+		const unsigned nRecords = NumBlockRecords(m_header.userHdr.nNumRecords, nBlock);
+		const bool bMightMatch = predicate.MightMatch([&](const RecordPredicate::Bound& bound) {
+			auto it = mapTerms.find(&bound);
+			if (it == mapTerms.end())
+				return true;
+			const ZoneMapStats* pStats = pBlockStats + it->second.nStats;
+			return it->second.predicate.MightMatch(&pStats, nRecords);
+		});
+		if (bMightMatch)
+			vRet.push_back(nBlock);
+	}
+	return vRet;
+}
+
+int Open_AlteryxYXDB::FindZoneMapField(unsigned nField) const
+{
+	for (size_t x = 0; x < m_vZoneMapFields.size(); ++x)
+	{
+		if (m_vZoneMapFields[x] == nField)
+			return int(x);
+	}
+	return -1;
+}
+
+void Open_AlteryxYXDB::Scan(
+	const ScanPredicate& predicate,
+	const ScanCallback& callback,
+	unsigned nThreads /*= 0*/,
+	bool bOrdered /*= true*/,
+	unsigned nMaxPendingBlocks /*= 0*/)
+{
+	if (!m_pInFile)
+		throw Error(U16("Open_AlteryxYXDB::Scan: The file is not open for reading"));
+
+	ScanBlocks(
+		GetMatchingBlocks(predicate),
+		[&predicate, &callback](const RecordBlock& block) {
+			for (size_t x = 0; x < block.m_vRecords.size(); ++x)
+			{
+				if (predicate.Matches(block.m_vRecords[x]))
+					callback(block.m_nBlock, block.m_nFirstRecord + int64_t(x), block.m_vRecords[x]);
+			}
+		},
+		NULL,
+		nThreads,
+		bOrdered,
+		nMaxPendingBlocks);
+}
+
+}}  // namespace Alteryx::OpenYXDB
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "Open_AlteryxYXDB.h"
+
+namespace Alteryx { namespace OpenYXDB {
+
+typedef std::function<void(unsigned nUnit, RecordBlock& r_block, std::vector<unsigned char>& vScratch)> BlockDecoder;
+typedef std::function<void(unsigned nUnit, const RecordBlock& block)> BlockConsumer;
+
+// The engine behind Open_AlteryxYXDB::ParallelScan and YXDBDataset::ParallelScan.  Units 0 to nUnits - 1 are
+// handed out in order to nThreads worker threads (0 for 1 per core), which each decode one into a RecordBlock with
+// decode.  If bOrdered, consume is called on this thread in unit order and at most nMaxPendingBlocks (0 for 2 per
+// thread) decoded blocks are held waiting their turn, otherwise it is called on the worker thread as soon as the
+// block is decoded.  If nMaxPendingBytes isn't 0, no more units are started while the decoded blocks not yet consumed
+// take up that much, so the memory used is at most about nMaxPendingBytes plus 1 block per thread.
+// The first exception thrown by either is rethrown here once the workers have stopped.
+void ParallelBlockScan(
+	unsigned nUnits,
+	const BlockDecoder& decode,
+	const BlockConsumer& consume,
+	unsigned nThreads,
+	bool bOrdered,
+	unsigned nMaxPendingBlocks,
+	size_t nMaxPendingBytes);
+
+// leaves the indexes of the records of r_block that match predicate in r_block.m_vSelection
+void SelectBlockRecords(const RecordPredicate& predicate, RecordBlock& r_block);
+
+}}  // namespace Alteryx::OpenYXDB
@@ -3,6 +3,7 @@
 #include "RecordLib/Record.h"
 
 #include "RecordLib/FieldBase.h"
+#include "RecordLib/RecordAllocator.h"
 #include "RecordLib/RecordData.h"
 
 namespace SRC {
@@ -21,27 +22,30 @@ void Record::Allocate(unsigned nNewMinimumVarDataSize)
 
 	if (m_nCurrentBufferSize < nMinSize)
 	{
+		unsigned nNewBufferSize;
 		if (m_bContainsVarData)
 		{
-			m_nCurrentBufferSize = nMinSize;
-			m_nCurrentBufferSize *= 2;
-			if (m_nCurrentBufferSize > MaxFieldLength)
-				m_nCurrentBufferSize = MaxFieldLength;
+			nNewBufferSize = nMinSize;
+			nNewBufferSize *= 2;
+			if (nNewBufferSize > MaxFieldLength)
+				nNewBufferSize = MaxFieldLength;
 		}
 		else
-			m_nCurrentBufferSize = m_nFixedRecordSize;
+			nNewBufferSize = m_nFixedRecordSize;
 
 		// The following assert is a soft limit, not a hard one.
 		// It is here to help find random uninitialized memory errors.
-		m_pRecord = realloc(m_pRecord, m_nCurrentBufferSize);
-		if (m_pRecord == 0)
-			throw Error(
-				XMSG("Unable to allocate @1 bytes of memory.", String(static_cast<int64_t>(m_nCurrentBufferSize))));
+		void* pNewRecord = m_pAllocator->Reallocate(m_pRecord, m_nCurrentBufferSize, nNewBufferSize);
+		if (pNewRecord == 0)
+			throw Error(XMSG("Unable to allocate @1 bytes of memory.", String(static_cast<int64_t>(nNewBufferSize))));
+		m_pRecord = pNewRecord;
+		m_nCurrentBufferSize = nNewBufferSize;
 	}
 }
 
-void Record::Init(int nFixedRecordSize, bool bContainsVarData)
+void Record::Init(int nFixedRecordSize, bool bContainsVarData, RecordAllocator& allocator)
 {
+	m_pAllocator = &allocator;
 	m_nFixedRecordSize = nFixedRecordSize;
 	m_bContainsVarData = bContainsVarData;
 	Allocate(0);
@@ -58,7 +62,7 @@ void Record::Reset(int nVarDataSize)
 Record::~Record()
 {
 	if (m_pRecord)
-		free(m_pRecord);
+		m_pAllocator->Free(m_pRecord, m_nCurrentBufferSize);
 }
 
 // returns the offset within the var data to the start
@@ -0,0 +1,212 @@
+#include "stdafx.h"
+
+#include "RecordLib/RecordAllocator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace SRC {
+namespace {
+class MallocRecordAllocator : public RecordAllocator
+{
+public:
+	void* Reallocate(void* pOld, size_t /*nOldSize*/, size_t nNewSize) override
+	{
+		return realloc(pOld, nNewSize);
+	}
+	void Free(void* p, size_t /*nSize*/) override
+	{
+		free(p);
+	}
+};
+
+const size_t ArenaAlignment = 16;
+
+inline size_t AlignUp(size_t nSize)
+{
+	return (nSize + ArenaAlignment - 1) & ~(ArenaAlignment - 1);
+}
+}  // namespace
+
+RecordAllocator::~RecordAllocator()
+{
+}
+
+/*static*/ RecordAllocator& RecordAllocator::GetDefault()
+{
+	static MallocRecordAllocator allocator;
+	return allocator;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// RecordArenaAllocator
+
+RecordArenaAllocator::RecordArenaAllocator(size_t nChunkSize)
+	: m_nChunkSize(AlignUp(nChunkSize))
+	, m_nCurrentChunk(0)
+	, m_nUsed(0)
+	, m_pLast(NULL)
+{
+}
+
+RecordArenaAllocator::~RecordArenaAllocator()
+{
+	for (Chunk& chunk : m_vChunks)
+		free(chunk.pData);
+}
+
+void* RecordArenaAllocator::AllocateNew(size_t nSize)
+{
+	nSize = AlignUp(nSize);
+	if (m_vChunks.empty() || m_nUsed + nSize > m_vChunks[m_nCurrentChunk].nSize)
+	{
+		// move on to the next chunk that is big enough, which after a Reset may be one we already have
+		size_t nNext = m_vChunks.empty() ? 0 : m_nCurrentChunk + 1;
+		while (nNext < m_vChunks.size() && m_vChunks[nNext].nSize < nSize)
+			++nNext;
+		if (nNext == m_vChunks.size())
+		{
+			Chunk chunk;
+			chunk.nSize = nSize > m_nChunkSize ? nSize : m_nChunkSize;
+			chunk.pData = static_cast<char*>(malloc(chunk.nSize));
+			if (chunk.pData == NULL)
+				return NULL;
+			m_vChunks.push_back(chunk);
+		}
+		m_nCurrentChunk = nNext;
+		m_nUsed = 0;
+	}
+
+	m_pLast = m_vChunks[m_nCurrentChunk].pData + m_nUsed;
+	m_nUsed += nSize;
+	return m_pLast;
+}
+
+void* RecordArenaAllocator::Reallocate(void* pOld, size_t nOldSize, size_t nNewSize)
+{
+	if (pOld != NULL && pOld == m_pLast)
+	{
+		// the last allocation can grow or shrink in place if it still fits in its chunk
+		const Chunk& chunk = m_vChunks[m_nCurrentChunk];
+		const size_t nStart = size_t(static_cast<char*>(pOld) - chunk.pData);
+		if (nStart + AlignUp(nNewSize) <= chunk.nSize)
+		{
+			m_nUsed = nStart + AlignUp(nNewSize);
+			return pOld;
+		}
+	}
+
+	void* pNew = AllocateNew(nNewSize);
+	if (pNew != NULL && pOld != NULL)
+		memcpy(pNew, pOld, nOldSize < nNewSize ? nOldSize : nNewSize);
+	return pNew;
+}
+
+void RecordArenaAllocator::Free(void* /*p*/, size_t /*nSize*/)
+{
+}
+
+void RecordArenaAllocator::Reset()
+{
+	m_nCurrentChunk = 0;
+	m_nUsed = 0;
+	m_pLast = NULL;
+}
+
+size_t RecordArenaAllocator::GetBytesReserved() const
+{
+	size_t nRet = 0;
+	for (const Chunk& chunk : m_vChunks)
+		nRet += chunk.nSize;
+	return nRet;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////
+// RecordPoolAllocator
+
+RecordPoolAllocator::RecordPoolAllocator(size_t nMaxPooledSize)
+	: m_nMaxPooledSize(nMaxPooledSize < MinPooledSize ? MinPooledSize : nMaxPooledSize)
+{
+	int nClasses = SizeClass(m_nMaxPooledSize) + 1;
+	m_vFreeLists.resize(nClasses, NULL);
+}
+
+RecordPoolAllocator::~RecordPoolAllocator()
+{
+	Trim();
+}
+
+int RecordPoolAllocator::SizeClass(size_t nSize) const
+{
+	if (nSize > m_nMaxPooledSize)
+		return -1;
+
+	int nClass = 0;
+	while ((MinPooledSize << nClass) < nSize)
+		++nClass;
+	return nClass;
+}
+
+void* RecordPoolAllocator::Reallocate(void* pOld, size_t nOldSize, size_t nNewSize)
+{
+	const int nOldClass = pOld ? SizeClass(nOldSize) : -1;
+	const int nNewClass = SizeClass(nNewSize);
+
+	if (pOld != NULL)
+	{
+		// the buffer is already the size of its whole class
+		if (nOldClass >= 0 && nOldClass == nNewClass)
+			return pOld;
+		if (nOldClass < 0 && nNewClass < 0)
+			return realloc(pOld, nNewSize);
+	}
+
+	void* pNew;
+	if (nNewClass < 0)
+		pNew = malloc(nNewSize);
+	else if (m_vFreeLists[nNewClass] != NULL)
+	{
+		pNew = m_vFreeLists[nNewClass];
+		memcpy(&m_vFreeLists[nNewClass], pNew, sizeof(void*));
+	}
+	else
+		pNew = malloc(MinPooledSize << nNewClass);
+
+	if (pNew != NULL && pOld != NULL)
+	{
+		memcpy(pNew, pOld, nOldSize < nNewSize ? nOldSize : nNewSize);
+		Free(pOld, nOldSize);
+	}
+	return pNew;
+}
+
+void RecordPoolAllocator::Free(void* p, size_t nSize)
+{
+	if (p == NULL)
+		return;
+
+	const int nClass = SizeClass(nSize);
+	if (nClass < 0)
+	{
+		free(p);
+		return;
+	}
+
+	memcpy(p, &m_vFreeLists[nClass], sizeof(void*));
+	m_vFreeLists[nClass] = p;
+}
+
+void RecordPoolAllocator::Trim()
+{
+	for (void*& r_pHead : m_vFreeLists)
+	{
+		while (r_pHead != NULL)
+		{
+			void* pNext;
+			memcpy(&pNext, r_pHead, sizeof(void*));
+			free(r_pHead);
+			r_pHead = pNext;
+		}
+	}
+}
+}  // namespace SRC
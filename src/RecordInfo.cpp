@@ -622,9 +622,14 @@ void RecordInfo::InitFromXml(
 }
 
 SmartPointerRefObj<Record> RecordInfo::CreateRecord() const
+{
+	return CreateRecord(RecordAllocator::GetDefault());
+}
+
+SmartPointerRefObj<Record> RecordInfo::CreateRecord(RecordAllocator& r_allocator) const
 {
 	SmartPointerRefObj<Record> pRet(new Record);
-	pRet->Init(m_nFixedRecordSize, m_bContainsVarData);
+	pRet->Init(m_nFixedRecordSize, m_bContainsVarData, r_allocator);
 	return pRet;
 }
 
@@ -0,0 +1,906 @@
+#include "stdafx.h"
+
+#include "RecordLib/RecordPredicate.h"
+
+#include "RecordLib/FieldAccessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace SRC {
+
+struct RecordPredicate::Node
+{
+	enum E_Type
+	{
+		E_Type_Test,
+		E_Type_And,
+		E_Type_Or
+	};
+	E_Type m_eType = E_Type_Test;
+	std::vector<std::shared_ptr<const Node>> m_vChildren;
+
+	// a test.  The layout of the field and the comparison are bound into m_pTest and m_pRefine
+	const FieldBase* m_pField = NULL;
+	unsigned m_nOffset = 0;
+	unsigned m_nFieldLen = 0;
+
+	int64_t m_nValue = 0;
+	double m_dValue = 0;
+	WString m_strValue;
+
+	// sorted, for In.  m_vBytes are the strings as the field stores them
+	std::vector<int64_t> m_vInts;
+	std::vector<double> m_vDoubles;
+	std::vector<std::string> m_vBytes;
+
+	// what the test says about the field's values, for RecordPredicate::MightMatch
+	RecordPredicate::Bound m_bound;
+
+	bool (*m_pTest)(const Node& node, const RecordData* pRecord) = NULL;
+	size_t (*m_pRefine)(const Node& node, const RecordData* const* ppRecords, uint32_t* pSelection, size_t nSelection) =
+		NULL;
+};
+
+namespace {
+typedef RecordPredicate::Node Node;
+
+template <class T>
+struct Tag
+{
+	typedef T Type;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// the getters read a field straight from the record
+
+template <E_FieldType ft>
+struct NumGetter
+{
+	typedef FieldAccessorDetail::Layout<ft> T_Layout;
+	static const bool IsDouble = ft == E_FT_Float || ft == E_FT_Double;
+
+	static inline bool GetNull(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::GetNull(ToCharP(pRecord) + node.m_nOffset);
+	}
+	static inline typename T_Layout::T_Value Get(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::GetValue(ToCharP(pRecord) + node.m_nOffset);
+	}
+};
+
+struct FixedDecimalGetter
+{
+	typedef FieldAccessorDetail::FixedDecimalLayout T_Layout;
+	static const bool IsDouble = true;
+
+	static inline bool GetNull(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::GetNull(pRecord, node.m_nOffset, node.m_nFieldLen);
+	}
+	static inline double Get(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::GetDouble(ToCharP(pRecord) + node.m_nOffset, node.m_nFieldLen);
+	}
+};
+
+template <class T_Layout>
+struct StringGetter
+{
+	typedef typename T_Layout::T_Char T_Char;
+
+	static inline bool GetNull(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::GetNull(pRecord, node.m_nOffset, node.m_nFieldLen);
+	}
+	static inline TFieldVal<TBlobVal<T_Char>> Get(const Node& node, const RecordData* pRecord)
+	{
+		return T_Layout::Get(pRecord, node.m_nOffset, node.m_nFieldLen);
+	}
+};
+
+// Blob and SpatialObj - GetNull is thread safe
+struct FieldGetter
+{
+	static inline bool GetNull(const Node& node, const RecordData* pRecord)
+	{
+		return node.m_pField->GetNull(pRecord);
+	}
+};
+
+// calls f with a Tag of the getter for a number field.  Returns false if it isn't one
+template <class F>
+bool WithNumGetter(E_FieldType ft, F f)
+{
+	switch (ft)
+	{
+		case E_FT_Bool:
+			f(Tag<NumGetter<E_FT_Bool>>());
+			return true;
+		case E_FT_Byte:
+			f(Tag<NumGetter<E_FT_Byte>>());
+			return true;
+		case E_FT_Int16:
+			f(Tag<NumGetter<E_FT_Int16>>());
+			return true;
+		case E_FT_Int32:
+			f(Tag<NumGetter<E_FT_Int32>>());
+			return true;
+		case E_FT_Int64:
+			f(Tag<NumGetter<E_FT_Int64>>());
+			return true;
+		case E_FT_Float:
+			f(Tag<NumGetter<E_FT_Float>>());
+			return true;
+		case E_FT_Double:
+			f(Tag<NumGetter<E_FT_Double>>());
+			return true;
+		case E_FT_FixedDecimal:
+			f(Tag<FixedDecimalGetter>());
+			return true;
+		default:
+			return false;
+	}
+}
+
+// the same for a field that holds a string
+template <class F>
+bool WithStringGetter(E_FieldType ft, F f)
+{
+	switch (ft)
+	{
+		case E_FT_String:
+		case E_FT_Date:
+		case E_FT_Time:
+		case E_FT_DateTime:
+		case E_FT_FixedDecimal:
+			f(Tag<StringGetter<FieldAccessorDetail::FixedStringLayout<char>>>());
+			return true;
+		case E_FT_WString:
+			f(Tag<StringGetter<FieldAccessorDetail::FixedStringLayout<U16unit>>>());
+			return true;
+		case E_FT_V_String:
+			f(Tag<StringGetter<FieldAccessorDetail::VarStringLayout<char>>>());
+			return true;
+		case E_FT_V_WString:
+			f(Tag<StringGetter<FieldAccessorDetail::VarStringLayout<U16unit>>>());
+			return true;
+		default:
+			return false;
+	}
+}
+
+template <class F>
+void WithCompare(RecordPredicate::E_Compare eCompare, F f)
+{
+	switch (eCompare)
+	{
+		case RecordPredicate::E_Compare_Equal:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_Equal>());
+			break;
+		case RecordPredicate::E_Compare_NotEqual:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_NotEqual>());
+			break;
+		case RecordPredicate::E_Compare_Less:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_Less>());
+			break;
+		case RecordPredicate::E_Compare_LessOrEqual:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_LessOrEqual>());
+			break;
+		case RecordPredicate::E_Compare_Greater:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_Greater>());
+			break;
+		case RecordPredicate::E_Compare_GreaterOrEqual:
+			f(std::integral_constant<RecordPredicate::E_Compare, RecordPredicate::E_Compare_GreaterOrEqual>());
+			break;
+	}
+}
+
+template <RecordPredicate::E_Compare eCompare, class T>
+inline bool CompareValues(const T& a, const T& b)
+{
+	switch (eCompare)
+	{
+		case RecordPredicate::E_Compare_Equal:
+			return a == b;
+		case RecordPredicate::E_Compare_NotEqual:
+			return a != b;
+		case RecordPredicate::E_Compare_Less:
+			return a < b;
+		case RecordPredicate::E_Compare_LessOrEqual:
+			return a <= b;
+		case RecordPredicate::E_Compare_Greater:
+			return a > b;
+		case RecordPredicate::E_Compare_GreaterOrEqual:
+			return a >= b;
+	}
+	return false;
+}
+
+template <class T>
+inline const T& GetConstant(const Node& node);
+template <>
+inline const int64_t& GetConstant<int64_t>(const Node& node)
+{
+	return node.m_nValue;
+}
+template <>
+inline const double& GetConstant<double>(const Node& node)
+{
+	return node.m_dValue;
+}
+
+template <class T>
+inline const std::vector<T>& GetList(const Node& node);
+template <>
+inline const std::vector<int64_t>& GetList<int64_t>(const Node& node)
+{
+	return node.m_vInts;
+}
+template <>
+inline const std::vector<double>& GetList<double>(const Node& node)
+{
+	return node.m_vDoubles;
+}
+
+inline unsigned GetUnit(const char* p, size_t x)
+{
+	return static_cast<unsigned char>(p[x]);
+}
+inline unsigned GetUnit(const U16unit* p, size_t x)
+{
+	// WString views may not be aligned
+	U16unit c;
+	memcpy(&c, p + x, sizeof(c));
+	return c;
+}
+
+// compares a field's string to a UTF-16 string unit by unit
+template <class T_Char>
+inline int CompareUnits(const TBlobVal<T_Char>& val, const WString& str)
+{
+	const size_t nLen = std::min(size_t(val.nLength), str.size());
+	for (size_t x = 0; x < nLen; ++x)
+	{
+		const unsigned a = GetUnit(val.pValue, x);
+		const unsigned b = str[x];
+		if (a != b)
+			return a < b ? -1 : 1;
+	}
+	if (val.nLength == str.size())
+		return 0;
+	return val.nLength < str.size() ? -1 : 1;
+}
+
+// the bytes of str as a field of T_Char stores it.  False if it can't, since a String can only hold Latin-1
+bool Encode(const WString& str, char, std::string& r_bytes)
+{
+	r_bytes.resize(str.size());
+	for (size_t x = 0; x < str.size(); ++x)
+	{
+		if (str[x] > 0xff)
+			return false;
+		r_bytes[x] = char(str[x]);
+	}
+	return true;
+}
+bool Encode(const WString& str, U16unit, std::string& r_bytes)
+{
+	r_bytes.assign(reinterpret_cast<const char*>(str.data()), str.size() * sizeof(U16unit));
+	return true;
+}
+
+// orders a field's bytes against the encoded constants
+struct BytesLess
+{
+	inline bool operator()(const std::string& a, const std::pair<const char*, size_t>& b) const
+	{
+		const int n = memcmp(a.data(), b.first, std::min(a.size(), b.second));
+		return n < 0 || (n == 0 && a.size() < b.second);
+	}
+	inline bool operator()(const std::pair<const char*, size_t>& a, const std::string& b) const
+	{
+		const int n = memcmp(a.first, b.data(), std::min(a.second, b.size()));
+		return n < 0 || (n == 0 && a.second < b.size());
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////////////
+// the tests
+
+template <class T_Getter, class T_Value, RecordPredicate::E_Compare eCompare>
+struct CompareTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		if (T_Getter::GetNull(node, pRecord))
+			return false;
+		return CompareValues<eCompare>(T_Value(T_Getter::Get(node, pRecord)), GetConstant<T_Value>(node));
+	}
+};
+
+template <class T_Getter, class T_Value>
+struct InTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		if (T_Getter::GetNull(node, pRecord))
+			return false;
+		const std::vector<T_Value>& vList = GetList<T_Value>(node);
+		return std::binary_search(vList.begin(), vList.end(), T_Value(T_Getter::Get(node, pRecord)));
+	}
+};
+
+template <class T_Getter, RecordPredicate::E_Compare eCompare>
+struct StringCompareTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		auto val = T_Getter::Get(node, pRecord);
+		if (val.bIsNull)
+			return false;
+		return CompareValues<eCompare>(CompareUnits(val.value, node.m_strValue), 0);
+	}
+};
+
+// Equal and In are in the list, NotEqual isn't
+template <class T_Getter, bool bIn>
+struct StringInTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		auto val = T_Getter::Get(node, pRecord);
+		if (val.bIsNull)
+			return false;
+		const std::pair<const char*, size_t> bytes(
+			reinterpret_cast<const char*>(val.value.pValue), val.value.nLength * sizeof(*val.value.pValue));
+		return std::binary_search(node.m_vBytes.begin(), node.m_vBytes.end(), bytes, BytesLess()) == bIn;
+	}
+};
+
+template <class T_Getter>
+struct StartsWithTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		auto val = T_Getter::Get(node, pRecord);
+		if (val.bIsNull || node.m_vBytes.empty())
+			return false;
+		const std::string& prefix = node.m_vBytes[0];
+		return val.value.nLength * sizeof(*val.value.pValue) >= prefix.size()
+			&& memcmp(val.value.pValue, prefix.data(), prefix.size()) == 0;
+	}
+};
+
+template <class T_Getter, bool bNull>
+struct NullTest
+{
+	static inline bool Test(const Node& node, const RecordData* pRecord)
+	{
+		return T_Getter::GetNull(node, pRecord) == bNull;
+	}
+};
+
+// the batch form of every test.  It writes each index back whether it passed or not, and only moves on
+// if it did, so there is no branch to mispredict
+template <class T_Test>
+size_t RefineTest(const Node& node, const RecordData* const* ppRecords, uint32_t* pSelection, size_t nSelection)
+{
+	size_t nOut = 0;
+	for (size_t x = 0; x < nSelection; ++x)
+	{
+		const uint32_t nIndex = pSelection[x];
+		pSelection[nOut] = nIndex;
+		nOut += T_Test::Test(node, ppRecords[nIndex]) ? 1 : 0;
+	}
+	return nOut;
+}
+
+template <class T_Test>
+void Bind(Node& node)
+{
+	node.m_pTest = &T_Test::Test;
+	node.m_pRefine = &RefineTest<T_Test>;
+}
+
+std::shared_ptr<Node> NewTest(const FieldBase& field)
+{
+	auto pNode = std::make_shared<Node>();
+	pNode->m_pField = &field;
+	pNode->m_nOffset = unsigned(field.GetOffset());
+	pNode->m_nFieldLen = unsigned(field.m_nSize);
+	pNode->m_bound.m_pField = &field;
+	return pNode;
+}
+
+// the bound of a comparison to m_nValue or m_dValue.  Less and Greater are given the same range as LessOrEqual and
+// GreaterOrEqual, which is a little wider than they need.  NotEqual only rules out nulls, the default
+template <class T_Value>
+void SetCompareBound(Node& node, RecordPredicate::E_Compare eCompare)
+{
+	if (eCompare == RecordPredicate::E_Compare_NotEqual)
+		return;
+
+	RecordPredicate::Bound& bound = node.m_bound;
+	const bool bHasMin = eCompare != RecordPredicate::E_Compare_Less && eCompare != RecordPredicate::E_Compare_LessOrEqual;
+	const bool bHasMax =
+		eCompare != RecordPredicate::E_Compare_Greater && eCompare != RecordPredicate::E_Compare_GreaterOrEqual;
+	if (std::is_same<T_Value, double>::value)
+	{
+		bound.m_eKind = RecordPredicate::Bound::E_Kind_DoubleRange;
+		bound.m_dMin = bHasMin ? node.m_dValue : -std::numeric_limits<double>::infinity();
+		bound.m_dMax = bHasMax ? node.m_dValue : std::numeric_limits<double>::infinity();
+	}
+	else
+	{
+		bound.m_eKind = RecordPredicate::Bound::E_Kind_IntRange;
+		bound.m_nMin = bHasMin ? node.m_nValue : std::numeric_limits<int64_t>::min();
+		bound.m_nMax = bHasMax ? node.m_nValue : std::numeric_limits<int64_t>::max();
+	}
+}
+
+void SetStringBound(Node& node, bool bHasMin, const WString& strMin, bool bHasMax, const WString& strMax)
+{
+	RecordPredicate::Bound& bound = node.m_bound;
+	bound.m_eKind = RecordPredicate::Bound::E_Kind_StringRange;
+	bound.m_bHasMin = bHasMin;
+	bound.m_bHasMax = bHasMax;
+	bound.m_strMin = strMin;
+	bound.m_strMax = strMax;
+}
+
+// the bound of an In, from its sorted list.  An empty list matches nothing, but is left to rule out just the nulls
+void SetInBound(Node& node)
+{
+	RecordPredicate::Bound& bound = node.m_bound;
+	if (!node.m_vInts.empty())
+	{
+		bound.m_eKind = RecordPredicate::Bound::E_Kind_IntRange;
+		bound.m_nMin = node.m_vInts.front();
+		bound.m_nMax = node.m_vInts.back();
+	}
+	else if (!node.m_vDoubles.empty())
+	{
+		bound.m_eKind = RecordPredicate::Bound::E_Kind_DoubleRange;
+		bound.m_dMin = node.m_vDoubles.front();
+		bound.m_dMax = node.m_vDoubles.back();
+	}
+}
+
+void ThrowCantCompare(const FieldBase& field, const char* pWhat)
+{
+	throw Error(XMSG(
+		"RecordPredicate: Field @1 is @2, which can't be compared to @3.",
+		field.GetFieldName().c_str(),
+		GetNameFromFieldType(field.m_ft),
+		ConvertToWString(pWhat)));
+}
+
+// T_Const is the type of the constant, which is in both m_nValue and m_dValue
+template <class T_Const>
+void BindNumCompare(Node& node, RecordPredicate::E_Compare eCompare)
+{
+	const bool bNum = WithNumGetter(node.m_pField->m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		typedef typename std::conditional<T_Getter::IsDouble, double, T_Const>::type T_Value;
+		WithCompare(eCompare, [&](auto compare) {
+			Bind<CompareTest<T_Getter, T_Value, decltype(compare)::value>>(node);
+		});
+		SetCompareBound<T_Value>(node, eCompare);
+	});
+	if (!bNum)
+		ThrowCantCompare(*node.m_pField, "a number");
+}
+
+// the whole numbers among vValues
+std::vector<int64_t> WholeNumbers(const std::vector<double>& vValues)
+{
+	const double dTwo63 = 9223372036854775808.0;
+	std::vector<int64_t> vRet;
+	for (double d : vValues)
+	{
+		if (d >= -dTwo63 && d < dTwo63 && std::floor(d) == d)
+			vRet.push_back(int64_t(d));
+	}
+	return vRet;
+}
+
+template <class T>
+void SortUnique(std::vector<T>& r_v)
+{
+	std::sort(r_v.begin(), r_v.end());
+	r_v.erase(std::unique(r_v.begin(), r_v.end()), r_v.end());
+}
+
+// the constants as the field stores them, leaving out any it can't hold
+template <class T_Getter>
+void EncodeStrings(Node& node, const std::vector<WString>& vValues)
+{
+	typedef typename T_Getter::T_Char T_Char;
+	std::string bytes;
+	for (const WString& str : vValues)
+	{
+		if (Encode(str, T_Char(), bytes))
+			node.m_vBytes.push_back(bytes);
+	}
+	SortUnique(node.m_vBytes);
+}
+
+bool TestNode(const Node& node, const RecordData* pRecord)
+{
+	switch (node.m_eType)
+	{
+		case Node::E_Type_Test:
+			return node.m_pTest(node, pRecord);
+		case Node::E_Type_And:
+			for (const auto& pChild : node.m_vChildren)
+			{
+				if (!TestNode(*pChild, pRecord))
+					return false;
+			}
+			return true;
+		case Node::E_Type_Or:
+			for (const auto& pChild : node.m_vChildren)
+			{
+				if (TestNode(*pChild, pRecord))
+					return true;
+			}
+			return false;
+	}
+	return false;
+}
+
+// the buffers the Or refine works in, kept between calls so that a scan doesn't allocate them for every block.
+// One set per level of Or nesting - a deque, so adding a level doesn't move the ones the outer Ors are using
+struct OrScratch
+{
+	std::vector<uint32_t> vRemaining;
+	std::vector<uint32_t> vAccepted;
+	std::vector<uint32_t> vPassed;
+	std::vector<uint32_t> vTemp;
+};
+thread_local std::deque<OrScratch> t_orScratch;
+
+size_t RefineNode(
+	const Node& node,
+	const RecordData* const* ppRecords,
+	uint32_t* pSelection,
+	size_t nSelection,
+	unsigned nOrDepth)
+{
+	switch (node.m_eType)
+	{
+		case Node::E_Type_Test:
+			return node.m_pRefine(node, ppRecords, pSelection, nSelection);
+		case Node::E_Type_And:
+			for (const auto& pChild : node.m_vChildren)
+			{
+				if (nSelection == 0)
+					break;
+				nSelection = RefineNode(*pChild, ppRecords, pSelection, nSelection, nOrDepth);
+			}
+			return nSelection;
+		case Node::E_Type_Or:
+		{
+			if (t_orScratch.size() <= nOrDepth)
+				t_orScratch.resize(nOrDepth + 1);
+			OrScratch& r_scratch = t_orScratch[nOrDepth];
+
+			// each alternative only looks at the records none of the ones before it took
+			std::vector<uint32_t>& r_vRemaining = r_scratch.vRemaining;
+			std::vector<uint32_t>& r_vAccepted = r_scratch.vAccepted;
+			std::vector<uint32_t>& r_vPassed = r_scratch.vPassed;
+			std::vector<uint32_t>& r_vTemp = r_scratch.vTemp;
+			r_vRemaining.assign(pSelection, pSelection + nSelection);
+			r_vAccepted.clear();
+			for (const auto& pChild : node.m_vChildren)
+			{
+				r_vPassed = r_vRemaining;
+				r_vPassed.resize(RefineNode(*pChild, ppRecords, r_vPassed.data(), r_vPassed.size(), nOrDepth + 1));
+				if (r_vPassed.empty())
+					continue;
+
+				r_vTemp.clear();
+				std::merge(
+					r_vAccepted.begin(),
+					r_vAccepted.end(),
+					r_vPassed.begin(),
+					r_vPassed.end(),
+					std::back_inserter(r_vTemp));
+				r_vAccepted.swap(r_vTemp);
+
+				r_vTemp.clear();
+				std::set_difference(
+					r_vRemaining.begin(),
+					r_vRemaining.end(),
+					r_vPassed.begin(),
+					r_vPassed.end(),
+					std::back_inserter(r_vTemp));
+				r_vRemaining.swap(r_vTemp);
+				if (r_vRemaining.empty())
+					break;
+			}
+			std::copy(r_vAccepted.begin(), r_vAccepted.end(), pSelection);
+			return r_vAccepted.size();
+		}
+	}
+	return 0;
+}
+
+void GetNodeBounds(const Node& node, std::vector<const RecordPredicate::Bound*>& r_vBounds)
+{
+	if (node.m_eType == Node::E_Type_Test)
+		r_vBounds.push_back(&node.m_bound);
+	for (const auto& pChild : node.m_vChildren)
+		GetNodeBounds(*pChild, r_vBounds);
+}
+
+bool NodeMightMatch(const Node& node, const std::function<bool(const RecordPredicate::Bound& bound)>& boundMightMatch)
+{
+	switch (node.m_eType)
+	{
+		case Node::E_Type_Test:
+			return boundMightMatch(node.m_bound);
+		case Node::E_Type_And:
+			for (const auto& pChild : node.m_vChildren)
+			{
+				if (!NodeMightMatch(*pChild, boundMightMatch))
+					return false;
+			}
+			return true;
+		case Node::E_Type_Or:
+			for (const auto& pChild : node.m_vChildren)
+			{
+				if (NodeMightMatch(*pChild, boundMightMatch))
+					return true;
+			}
+			return false;
+	}
+	return true;
+}
+
+std::shared_ptr<const Node> Combine(
+	Node::E_Type eType,
+	const std::shared_ptr<const Node>& pA,
+	const std::shared_ptr<const Node>& pB)
+{
+	auto pNode = std::make_shared<Node>();
+	pNode->m_eType = eType;
+	for (const auto& pChild : { pA, pB })
+	{
+		if (pChild->m_eType == eType)
+			pNode->m_vChildren.insert(pNode->m_vChildren.end(), pChild->m_vChildren.begin(), pChild->m_vChildren.end());
+		else
+			pNode->m_vChildren.push_back(pChild);
+	}
+	return pNode;
+}
+}  // namespace
+
+RecordPredicate::RecordPredicate()
+{
+}
+
+RecordPredicate::RecordPredicate(std::shared_ptr<const Node> pRoot)
+	: m_pRoot(std::move(pRoot))
+{
+}
+
+/*static*/ RecordPredicate RecordPredicate::Compare(const FieldBase& field, E_Compare eCompare, int nValue)
+{
+	return Compare(field, eCompare, int64_t(nValue));
+}
+
+/*static*/ RecordPredicate RecordPredicate::Compare(const FieldBase& field, E_Compare eCompare, int64_t nValue)
+{
+	auto pNode = NewTest(field);
+	pNode->m_nValue = nValue;
+	pNode->m_dValue = double(nValue);
+	BindNumCompare<int64_t>(*pNode, eCompare);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::Compare(const FieldBase& field, E_Compare eCompare, double dValue)
+{
+	auto pNode = NewTest(field);
+	pNode->m_dValue = dValue;
+	BindNumCompare<double>(*pNode, eCompare);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::Compare(const FieldBase& field, E_Compare eCompare, const WString& strValue)
+{
+	auto pNode = NewTest(field);
+	pNode->m_strValue = strValue;
+	const bool bString = WithStringGetter(field.m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		if (eCompare == E_Compare_Equal || eCompare == E_Compare_NotEqual)
+		{
+			EncodeStrings<T_Getter>(*pNode, std::vector<WString>(1, strValue));
+			if (eCompare == E_Compare_Equal)
+				Bind<StringInTest<T_Getter, true>>(*pNode);
+			else
+				Bind<StringInTest<T_Getter, false>>(*pNode);
+		}
+		else
+			WithCompare(eCompare, [&](auto compare) {
+				Bind<StringCompareTest<T_Getter, decltype(compare)::value>>(*pNode);
+			});
+	});
+	if (eCompare != E_Compare_NotEqual)
+		SetStringBound(
+			*pNode,
+			eCompare != E_Compare_Less && eCompare != E_Compare_LessOrEqual,
+			strValue,
+			eCompare != E_Compare_Greater && eCompare != E_Compare_GreaterOrEqual,
+			strValue);
+	if (!bString)
+		ThrowCantCompare(field, "a string");
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::In(const FieldBase& field, const std::vector<int64_t>& vValues)
+{
+	auto pNode = NewTest(field);
+	const bool bNum = WithNumGetter(field.m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		if (T_Getter::IsDouble)
+		{
+			for (int64_t n : vValues)
+				pNode->m_vDoubles.push_back(double(n));
+			SortUnique(pNode->m_vDoubles);
+			Bind<InTest<T_Getter, double>>(*pNode);
+		}
+		else
+		{
+			pNode->m_vInts = vValues;
+			SortUnique(pNode->m_vInts);
+			Bind<InTest<T_Getter, int64_t>>(*pNode);
+		}
+	});
+	if (!bNum)
+		ThrowCantCompare(field, "a number");
+	SetInBound(*pNode);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::In(const FieldBase& field, const std::vector<double>& vValues)
+{
+	auto pNode = NewTest(field);
+	const bool bNum = WithNumGetter(field.m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		if (T_Getter::IsDouble)
+		{
+			// NaN isn't equal to anything, and would break the sort
+			for (double d : vValues)
+			{
+				if (!std::isnan(d))
+					pNode->m_vDoubles.push_back(d);
+			}
+			SortUnique(pNode->m_vDoubles);
+			Bind<InTest<T_Getter, double>>(*pNode);
+		}
+		else
+		{
+			// a whole number field can only equal the whole numbers
+			pNode->m_vInts = WholeNumbers(vValues);
+			SortUnique(pNode->m_vInts);
+			Bind<InTest<T_Getter, int64_t>>(*pNode);
+		}
+	});
+	if (!bNum)
+		ThrowCantCompare(field, "a number");
+	SetInBound(*pNode);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::In(const FieldBase& field, const std::vector<WString>& vValues)
+{
+	auto pNode = NewTest(field);
+	const bool bString = WithStringGetter(field.m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		EncodeStrings<T_Getter>(*pNode, vValues);
+		Bind<StringInTest<T_Getter, true>>(*pNode);
+	});
+	if (!bString)
+		ThrowCantCompare(field, "a string");
+	if (!vValues.empty())
+	{
+		const auto minmax = std::minmax_element(vValues.begin(), vValues.end());
+		SetStringBound(*pNode, true, *minmax.first, true, *minmax.second);
+	}
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::StartsWith(const FieldBase& field, const WString& strPrefix)
+{
+	auto pNode = NewTest(field);
+	const bool bString = WithStringGetter(field.m_ft, [&](auto getter) {
+		typedef typename decltype(getter)::Type T_Getter;
+		// if the field can't hold the prefix m_vBytes is left empty, and nothing matches
+		std::string bytes;
+		if (Encode(strPrefix, typename T_Getter::T_Char(), bytes))
+			pNode->m_vBytes.push_back(bytes);
+		Bind<StartsWithTest<T_Getter>>(*pNode);
+	});
+	if (!bString)
+		ThrowCantCompare(field, "a string");
+	SetStringBound(*pNode, true, strPrefix, true, strPrefix);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::IsNull(const FieldBase& field)
+{
+	auto pNode = NewTest(field);
+	// the string layouts cover FixedDecimal as well
+	if (!WithStringGetter(field.m_ft, [&](auto getter) { Bind<NullTest<typename decltype(getter)::Type, true>>(*pNode); })
+		&& !WithNumGetter(field.m_ft, [&](auto getter) { Bind<NullTest<typename decltype(getter)::Type, true>>(*pNode); }))
+		Bind<NullTest<FieldGetter, true>>(*pNode);
+	pNode->m_bound.m_eKind = Bound::E_Kind_IsNull;
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::IsNotNull(const FieldBase& field)
+{
+	auto pNode = NewTest(field);
+	if (!WithStringGetter(field.m_ft, [&](auto getter) { Bind<NullTest<typename decltype(getter)::Type, false>>(*pNode); })
+		&& !WithNumGetter(field.m_ft, [&](auto getter) { Bind<NullTest<typename decltype(getter)::Type, false>>(*pNode); }))
+		Bind<NullTest<FieldGetter, false>>(*pNode);
+	return RecordPredicate(pNode);
+}
+
+/*static*/ RecordPredicate RecordPredicate::And(const RecordPredicate& a, const RecordPredicate& b)
+{
+	// one that matches everything doesn't change anything
+	if (!a.m_pRoot)
+		return b;
+	if (!b.m_pRoot)
+		return a;
+	return RecordPredicate(Combine(Node::E_Type_And, a.m_pRoot, b.m_pRoot));
+}
+
+/*static*/ RecordPredicate RecordPredicate::Or(const RecordPredicate& a, const RecordPredicate& b)
+{
+	if (!a.m_pRoot || !b.m_pRoot)
+		return RecordPredicate();
+	return RecordPredicate(Combine(Node::E_Type_Or, a.m_pRoot, b.m_pRoot));
+}
+
+bool RecordPredicate::Matches(const RecordData* pRecord) const
+{
+	return !m_pRoot || TestNode(*m_pRoot, pRecord);
+}
+
+size_t RecordPredicate::Select(const RecordData* const* ppRecords, size_t nRecords, uint32_t* pSelection) const
+{
+	for (size_t x = 0; x < nRecords; ++x)
+		pSelection[x] = uint32_t(x);
+	return Refine(ppRecords, pSelection, nRecords);
+}
+
+size_t RecordPredicate::Refine(const RecordData* const* ppRecords, uint32_t* pSelection, size_t nSelection) const
+{
+	if (!m_pRoot)
+		return nSelection;
+	return RefineNode(*m_pRoot, ppRecords, pSelection, nSelection, 0);
+}
+
+std::vector<const RecordPredicate::Bound*> RecordPredicate::GetBounds() const
+{
+	std::vector<const Bound*> vRet;
+	if (m_pRoot)
+		GetNodeBounds(*m_pRoot, vRet);
+	return vRet;
+}
+
+bool RecordPredicate::MightMatch(const std::function<bool(const Bound& bound)>& boundMightMatch) const
+{
+	return !m_pRoot || NodeMightMatch(*m_pRoot, boundMightMatch);
+}
+
+}  // namespace SRC
@@ -0,0 +1,71 @@
+#include <iostream>
+
+#include "TestUtil.h"
+
+int g_nFailures = 0;
+
+void Check(bool bOk, const char* pWhat)
+{
+	if (!bOk)
+	{
+		std::cout << "FAILED: " << pWhat << "\n";
+		++g_nFailures;
+	}
+}
+
+SRC::String TestRecordInfoXml(bool bVarData)
+{
+	SRC::String strXml = U16("<RecordInfo>");
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Id"), SRC::E_FT_Int64);
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Value"), SRC::E_FT_Double);
+	if (bVarData)
+		strXml += SRC::RecordInfo::CreateFieldXml(U16("Name"), SRC::E_FT_V_String, 256);
+	else
+		strXml += SRC::RecordInfo::CreateFieldXml(U16("Name"), SRC::E_FT_String, 64);
+	strXml += U16("</RecordInfo>");
+	return strXml;
+}
+
+void FillTestRecord(const SRC::RecordInfo& recordInfo, SRC::Record* pRec, int64_t nRecord)
+{
+	pRec->Reset();
+	recordInfo[0]->SetFromInt64(pRec, nRecord);
+	if (nRecord % 7 == 0)
+		recordInfo[1]->SetNull(pRec);
+	else
+		recordInfo[1]->SetFromDouble(pRec, nRecord * 0.5);
+	recordInfo[2]->SetFromString(pRec, EnglishNumber(int(nRecord % 100000)));
+}
+
+bool IsTestRecord(const SRC::RecordInfo& recordInfo, const SRC::RecordData* pRec, int64_t nRecord)
+{
+	if (recordInfo[0]->GetAsInt64(pRec).value != nRecord)
+		return false;
+	SRC::TFieldVal<double> value = recordInfo[1]->GetAsDouble(pRec);
+	if (nRecord % 7 == 0 ? !value.bIsNull : value.bIsNull || value.value != nRecord * 0.5)
+		return false;
+	return recordInfo[2]->GetAsAString(pRec).value.pValue == EnglishNumber(int(nRecord % 100000));
+}
+
+void CheckTestFile(const U16unit* pFile, const char* pWhat)
+{
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(pFile);
+	Check(file.GetNumRecords() == NumTestRecords, pWhat);
+
+	int64_t nRecord = 0;
+	bool bOk = true;
+	while (const SRC::RecordData* pRec = file.ReadRecord())
+		bOk = bOk && IsTestRecord(file.m_recordInfo, pRec, nRecord++);
+	Check(bOk && nRecord == NumTestRecords, pWhat);
+
+	std::mt19937 r;
+	for (unsigned x = 0; x < 50; ++x)
+	{
+		nRecord = int64_t(r() % NumTestRecords);
+		file.GoRecord(nRecord);
+		const SRC::RecordData* pRec = file.ReadRecord();
+		bOk = bOk && pRec && IsTestRecord(file.m_recordInfo, pRec, nRecord);
+	}
+	Check(bOk, pWhat);
+}
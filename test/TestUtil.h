@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "FieldType.h"
+#include "Open_AlteryxYXDB.h"
+#include "SrcLib_Replacement.h"
+
+// The tests write files with the options being tested, read them back and check that every
+// record came back the way it went in.  Check counts the ones that fail so that main can
+// return non-zero.
+extern int g_nFailures;
+void Check(bool bOk, const char* pWhat);
+
+// only used for generating sample data
+SRC::AString EnglishNumber(int n);
+
+// enough records to cross the RecordsPerBlock boundary a few times
+const int64_t NumTestRecords = 200000;
+
+// Id Int64, Value Double and Name, which is a V_String if bVarData and a String otherwise
+SRC::String TestRecordInfoXml(bool bVarData);
+
+// every field is a function of the record number, so a record can be checked on its own.
+// Every 7th Value is null.
+void FillTestRecord(const SRC::RecordInfo& recordInfo, SRC::Record* pRec, int64_t nRecord);
+bool IsTestRecord(const SRC::RecordInfo& recordInfo, const SRC::RecordData* pRec, int64_t nRecord);
+
+// reads all of pFile, checks each record and then jumps around it with GoRecord
+void CheckTestFile(const U16unit* pFile, const char* pWhat);
+
+enum E_AppendMode
+{
+	E_Append_Record,
+	E_Append_Records,
+	E_Append_Raw
+};
+
+// writes the test records to pFile through one of the append calls, after setOptions has set up the file
+template <class T_Options>
+void WriteTestFile(const U16unit* pFile, bool bVarData, E_AppendMode eMode, T_Options setOptions)
+{
+	Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+	setOptions(fileOut);
+	fileOut.Create(pFile, TestRecordInfoXml(bVarData).c_str());
+
+	// AppendRecords and AppendRaw are given batches of records copied one after the other into a buffer
+	const size_t nBatch = 1000;
+	std::vector<char> vBuffer;
+	std::vector<size_t> vOffsets;
+	std::vector<const SRC::RecordData*> vRecords;
+
+	SRC::SmartPointerRefObj<SRC::Record> pRec = fileOut.m_recordInfo.CreateRecord();
+	for (int64_t nRecord = 0; nRecord < NumTestRecords; ++nRecord)
+	{
+		FillTestRecord(fileOut.m_recordInfo, pRec.Get(), nRecord);
+		if (eMode == E_Append_Record)
+		{
+			fileOut.AppendRecord(pRec->GetRecord());
+			continue;
+		}
+
+		const char* pData = reinterpret_cast<const char*>(pRec->GetRecord());
+		vOffsets.push_back(vBuffer.size());
+		vBuffer.insert(vBuffer.end(), pData, pData + fileOut.m_recordInfo.GetRecordLen(pRec->GetRecord()));
+		if (vOffsets.size() == nBatch || nRecord + 1 == NumTestRecords)
+		{
+			if (eMode == E_Append_Raw)
+				fileOut.AppendRaw(vBuffer.data(), vBuffer.size(), vOffsets.size());
+			else
+			{
+				vRecords.clear();
+				for (size_t nOffset : vOffsets)
+					vRecords.push_back(reinterpret_cast<const SRC::RecordData*>(vBuffer.data() + nOffset));
+				fileOut.AppendRecords(vRecords.data(), vRecords.size());
+			}
+			vBuffer.clear();
+			vOffsets.clear();
+		}
+	}
+	fileOut.Close();
+}
+
+// the tests, one per feature
+void TestAppendRecords();
+void TestParallelScan();
+void TestCompressionThreads();
+void TestReadBatch();
+void TestProjection();
+void TestRecordBlockIndex();
+void TestRecordOffsetIndex();
+void TestReadAhead();
+void TestCodecs();
+void TestCompressionBlockSize();
+void TestLzfDecompressors();
+void TestCompressionLevels();
+void TestFieldNumBatch();
+void TestFieldAccessor();
+void TestFieldScratch();
+void TestFieldStringAccessor();
+void TestRecordAllocator();
+void TestBuildSpatialIndex();
+void TestSpatialIndex();
+void TestZoneMaps();
+void TestRecordPredicate();
+void TestDataset();
+void TestPartitionedWriter();
+void TestBlockCache();
@@ -0,0 +1,45 @@
+#include <cstring>
+
+#include "TestUtil.h"
+
+void TestAppendRecords()
+{
+	const char* pNames[] = { "AppendRecord", "AppendRecords", "AppendRaw" };
+	for (bool bVarData : { false, true })
+	{
+		for (E_AppendMode eMode : { E_Append_Record, E_Append_Records, E_Append_Raw })
+		{
+			SRC::AString strWhat = SRC::AString(pNames[eMode]) + (bVarData ? " with var data" : " without var data");
+			WriteTestFile(U16("temp_append.yxdb"), bVarData, eMode, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+			CheckTestFile(U16("temp_append.yxdb"), strWhat.c_str());
+		}
+	}
+
+	// a record that claims a negative amount of var data is rejected before anything is written
+	Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+	fileOut.Create(U16("temp_append.yxdb"), TestRecordInfoXml(true).c_str());
+	SRC::SmartPointerRefObj<SRC::Record> pRec = fileOut.m_recordInfo.CreateRecord();
+	FillTestRecord(fileOut.m_recordInfo, pRec.Get(), 1);
+
+	const char* pData = reinterpret_cast<const char*>(pRec->GetRecord());
+	std::vector<char> vBad(pData, pData + fileOut.m_recordInfo.GetRecordLen(pRec->GetRecord()));
+	const int nVarDataSize = -1;
+	memcpy(vBad.data() + fileOut.m_recordInfo.GetFixedRecordSize(), &nVarDataSize, sizeof(nVarDataSize));
+
+	const SRC::RecordData* ppRecords[] = { pRec->GetRecord(), reinterpret_cast<const SRC::RecordData*>(vBad.data()) };
+	bool bThrew = false;
+	try
+	{
+		fileOut.AppendRecords(ppRecords, 2);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "AppendRecords with a negative var data size");
+	fileOut.Close();
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_append.yxdb"));
+	Check(file.GetNumRecords() == 0, "AppendRecords with a negative var data size");
+}
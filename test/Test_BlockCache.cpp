@@ -0,0 +1,72 @@
+#include "TestUtil.h"
+
+#include "Base/BlockCache.h"
+
+namespace {
+SRC::BlockCache::T_Block MakeBlock(size_t nSize)
+{
+	std::shared_ptr<SRC::BlockCache::Block> pBlock = std::make_shared<SRC::BlockCache::Block>();
+	pBlock->m_vData.resize(nSize);
+	pBlock->m_vData.shrink_to_fit();
+	return pBlock;
+}
+
+// reads every record of file, after going back to nRecord
+bool ReadFrom(Alteryx::OpenYXDB::Open_AlteryxYXDB& file, int64_t nRecord)
+{
+	bool bOk = true;
+	file.GoRecord(nRecord);
+	while (const SRC::RecordData* pRec = file.ReadRecord())
+		bOk = bOk && IsTestRecord(file.m_recordInfo, pRec, nRecord++);
+	return bOk && nRecord == NumTestRecords;
+}
+}  // namespace
+
+void TestBlockCache()
+{
+	// blocks much bigger than a stripe's share of the budget are still cached, up to the budget of the whole cache
+	const size_t nBlockSize = 200 * 1024;
+	SRC::BlockCache cache(1024 * 1024);
+	SRC::FileIdentity file;
+	file.nInode = 1;
+	for (int64_t nPos = 0; nPos < 20; ++nPos)
+		cache.Insert(file, nPos, MakeBlock(nBlockSize));
+	SRC::BlockCache::Stats stats = cache.GetStats();
+	Check(stats.nBlocks == 5 && stats.nBytes == 5 * nBlockSize, "BlockCache budget");
+	Check(cache.Find(file, 19) != NULL, "BlockCache Find");
+
+	// one bigger than the whole cache is passed back but not kept
+	SRC::BlockCache::T_Block pBig = MakeBlock(2 * 1024 * 1024);
+	Check(cache.Insert(file, 100, pBig) == pBig && cache.Find(file, 100) == NULL, "BlockCache too big");
+
+	cache.SetMaxBytes(2 * nBlockSize);
+	stats = cache.GetStats();
+	Check(stats.nBlocks == 2 && stats.nBytes == 2 * nBlockSize, "BlockCache SetMaxBytes");
+	cache.Clear();
+	Check(cache.GetStats().nBytes == 0 && cache.Find(file, 19) == NULL, "BlockCache Clear");
+
+	// two readers of the same file share the blocks, and a reader going back doesn't decompress them again.
+	// The 4MB blocks are more than 1/16 of the cache
+	WriteTestFile(U16("temp_blockcache.yxdb"),
+				  true,
+				  E_Append_Records,
+				  [](Alteryx::OpenYXDB::Open_AlteryxYXDB& fileOut) { fileOut.SetCompressionBlockSize(0x400000); });
+	SRC::BlockCache fileCache(32 * 1024 * 1024);
+	Alteryx::OpenYXDB::Open_AlteryxYXDB reader1, reader2;
+	reader1.SetBlockCache(&fileCache);
+	reader2.SetBlockCache(&fileCache);
+	reader1.Open(U16("temp_blockcache.yxdb"));
+	reader2.Open(U16("temp_blockcache.yxdb"));
+
+	Check(ReadFrom(reader1, 0), "BlockCache first reader");
+	stats = fileCache.GetStats();
+	Check(stats.nHits == 0 && stats.nMisses != 0 && stats.nBlocks == stats.nMisses, "BlockCache first reader");
+
+	Check(ReadFrom(reader2, 0), "BlockCache second reader");
+	SRC::BlockCache::Stats stats2 = fileCache.GetStats();
+	Check(stats2.nHits == stats.nBlocks && stats2.nMisses == stats.nMisses, "BlockCache second reader");
+
+	Check(ReadFrom(reader1, 12345), "BlockCache GoRecord back");
+	SRC::BlockCache::Stats stats3 = fileCache.GetStats();
+	Check(stats3.nHits > stats2.nHits && stats3.nMisses == stats.nMisses, "BlockCache GoRecord back");
+}
@@ -0,0 +1,35 @@
+#include "TestUtil.h"
+
+void TestCompressionBlockSize()
+{
+	// the reader has to pick the block size up from the header, even one that isn't a power of 2
+	const unsigned nBlockSizes[] = { Alteryx::OpenYXDB::MinLzfBlockSize,
+									 3 * Alteryx::OpenYXDB::MinLzfBlockSize + 12345,
+									 Alteryx::OpenYXDB::MaxLzfBlockSize };
+	for (unsigned nBlockSize : nBlockSizes)
+	{
+		for (bool bVarData : { false, true })
+		{
+			WriteTestFile(U16("temp_blocksize.yxdb"),
+						  bVarData,
+						  E_Append_Records,
+						  [&](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetCompressionBlockSize(nBlockSize); });
+			CheckTestFile(U16("temp_blocksize.yxdb"), "compression block size");
+		}
+	}
+
+	for (unsigned nBlockSize : { Alteryx::OpenYXDB::MinLzfBlockSize - 1, Alteryx::OpenYXDB::MaxLzfBlockSize + 1 })
+	{
+		bool bThrew = false;
+		try
+		{
+			Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+			file.SetCompressionBlockSize(nBlockSize);
+		}
+		catch (const SRC::Error&)
+		{
+			bThrew = true;
+		}
+		Check(bThrew, "a compression block size out of range");
+	}
+}
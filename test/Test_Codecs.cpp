@@ -0,0 +1,96 @@
+#include <atomic>
+
+#include "Base/Codec.h"
+#include "TestUtil.h"
+
+namespace {
+// LZ4 under another id, counting its calls to check that a registered codec is used for both writing and reading
+class Codec_Counting : public SRC::Codec
+{
+public:
+	mutable std::atomic<unsigned> m_nCompressed{ 0 };
+	mutable std::atomic<unsigned> m_nDecompressed{ 0 };
+
+	unsigned GetId() const override
+	{
+		return 200;
+	}
+	const char* GetName() const override
+	{
+		return "Counting";
+	}
+	unsigned Compress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		++m_nCompressed;
+		return SRC::CodecRegistry::GetCodec(SRC::E_Codec_LZ4).Compress(pIn, nInSize, pOut, nOutSize);
+	}
+	unsigned Decompress(const void* pIn, unsigned nInSize, void* pOut, unsigned nOutSize) const override
+	{
+		++m_nDecompressed;
+		return SRC::CodecRegistry::GetCodec(SRC::E_Codec_LZ4).Decompress(pIn, nInSize, pOut, nOutSize);
+	}
+};
+}  // namespace
+
+void TestCodecs()
+{
+	// random bytes, which don't compress, and text that does
+	std::mt19937 r;
+	std::vector<unsigned char> vRandom(100000), vText;
+	for (unsigned char& c : vRandom)
+		c = static_cast<unsigned char>(r());
+	while (vText.size() < 100000)
+	{
+		SRC::AString str = EnglishNumber(int(r() % 1000000));
+		vText.insert(vText.end(), str.c_str(), str.c_str() + str.size());
+	}
+
+	for (unsigned nCodec : { SRC::E_Codec_LZF, SRC::E_Codec_LZ4, SRC::E_Codec_LZ4HC })
+	{
+		const SRC::Codec& codec = SRC::CodecRegistry::GetCodec(nCodec);
+		Check(codec.GetId() == nCodec, codec.GetName());
+		for (const std::vector<unsigned char>* pData : { &vRandom, &vText })
+		{
+			std::vector<unsigned char> vCompressed(pData->size() * 2), vOut(pData->size());
+			unsigned nCompressed = codec.Compress(pData->data(), unsigned(pData->size()), vCompressed.data(),
+												  unsigned(vCompressed.size()));
+			unsigned nOut = codec.Decompress(vCompressed.data(), nCompressed, vOut.data(), unsigned(vOut.size()));
+			Check(nCompressed != 0 && nOut == pData->size() && vOut == *pData, codec.GetName());
+
+			// not enough room either way gives 0 rather than writing past the end
+			Check(nCompressed < 100 || codec.Decompress(vCompressed.data(), nCompressed, vOut.data(), 100) == 0,
+				  codec.GetName());
+			if (pData == &vText)
+				Check(nCompressed < pData->size() / 2 &&
+						  codec.Compress(pData->data(), unsigned(pData->size()), vCompressed.data(), 100) == 0,
+					  codec.GetName());
+		}
+
+		WriteTestFile(U16("temp_codec.yxdb"),
+					  true,
+					  E_Append_Records,
+					  [&](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetCompressionCodec(nCodec); });
+		CheckTestFile(U16("temp_codec.yxdb"), codec.GetName());
+	}
+
+	Check(SRC::CodecRegistry::FindCodec(200) == NULL, "an unregistered codec");
+	bool bThrew = false;
+	try
+	{
+		SRC::CodecRegistry::GetCodec(200);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "GetCodec for an unregistered codec");
+
+	static Codec_Counting counting;
+	SRC::CodecRegistry::RegisterCodec(&counting);
+	WriteTestFile(U16("temp_codec.yxdb"),
+				  false,
+				  E_Append_Record,
+				  [](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetCompressionCodec(200); });
+	CheckTestFile(U16("temp_codec.yxdb"), "a registered codec");
+	Check(counting.m_nCompressed != 0 && counting.m_nDecompressed != 0, "a registered codec");
+}
@@ -0,0 +1,48 @@
+#include <cstdio>
+
+#include "TestUtil.h"
+
+namespace {
+long GetFileSize(const char* pFile)
+{
+	long nSize = -1;
+	if (FILE* pF = fopen(pFile, "rb"))
+	{
+		fseek(pF, 0, SEEK_END);
+		nSize = ftell(pF);
+		fclose(pF);
+	}
+	return nSize;
+}
+}  // namespace
+
+void TestCompressionLevels()
+{
+	const char* pCodecs[] = { "", "LZF", "LZ4", "LZ4HC" };
+	const char* pLevels[] = { "Fast", "Default", "Dense" };
+	for (unsigned nCodec : { SRC::E_Codec_LZF, SRC::E_Codec_LZ4, SRC::E_Codec_LZ4HC })
+	{
+		long nSizes[3] = {};
+		for (SRC::E_CompressionLevel eLevel :
+			 { SRC::E_CompressionLevel_Fast, SRC::E_CompressionLevel_Default, SRC::E_CompressionLevel_Dense })
+		{
+			SRC::AString strWhat = SRC::AString(pCodecs[nCodec]) + " " + pLevels[eLevel];
+			WriteTestFile(U16("temp_level.yxdb"),
+						  true,
+						  E_Append_Records,
+						  [&](Alteryx::OpenYXDB::Open_AlteryxYXDB& file)
+						  {
+							  file.SetCompressionCodec(nCodec);
+							  file.SetCompressionLevel(eLevel);
+						  });
+			CheckTestFile(U16("temp_level.yxdb"), strWhat.c_str());
+			nSizes[eLevel] = GetFileSize("temp_level.yxdb");
+		}
+
+		// the levels only change how hard the codec works, and working harder shouldn't make it bigger
+		SRC::AString strWhat = SRC::AString(pCodecs[nCodec]) + " levels";
+		Check(nSizes[SRC::E_CompressionLevel_Dense] <= nSizes[SRC::E_CompressionLevel_Default] &&
+				  nSizes[SRC::E_CompressionLevel_Default] <= nSizes[SRC::E_CompressionLevel_Fast],
+			  strWhat.c_str());
+	}
+}
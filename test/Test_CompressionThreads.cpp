@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+
+#include "TestUtil.h"
+
+namespace {
+std::vector<char> ReadWholeFile(const char* pFile)
+{
+	std::vector<char> vData;
+	if (FILE* pF = fopen(pFile, "rb"))
+	{
+		char buffer[65536];
+		while (size_t n = fread(buffer, 1, sizeof(buffer), pF))
+			vData.insert(vData.end(), buffer, buffer + n);
+		fclose(pF);
+	}
+
+	// everything but when it was written
+	if (vData.size() >= sizeof(Alteryx::OpenYXDB::Header))
+	{
+		size_t nDate = offsetof(Alteryx::OpenYXDB::FileHeaderStruct, creationDate);
+		std::fill(vData.begin() + nDate, vData.begin() + nDate + sizeof(int32_t), 0);
+	}
+	return vData;
+}
+}  // namespace
+
+void TestCompressionThreads()
+{
+	// the blocks are compressed the same way whichever thread does it, so the files come out the same
+	WriteTestFile(U16("temp_threads0.yxdb"), true, E_Append_Record, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+	CheckTestFile(U16("temp_threads0.yxdb"), "0 compression threads");
+
+	for (unsigned nThreads : { 1, 4 })
+	{
+		WriteTestFile(U16("temp_threads.yxdb"),
+					  true,
+					  E_Append_Record,
+					  [&](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetCompressionThreads(nThreads); });
+		CheckTestFile(U16("temp_threads.yxdb"), "compression threads");
+
+		std::vector<char> vFile = ReadWholeFile("temp_threads.yxdb");
+		Check(!vFile.empty() && vFile == ReadWholeFile("temp_threads0.yxdb"), "compression threads give the same file");
+	}
+}
@@ -0,0 +1,142 @@
+#include <mutex>
+#include <string>
+
+#include "TestUtil.h"
+
+namespace {
+// the test records split across shards of these sizes, numbered on from one shard to the next.
+// The empty one is in there on purpose
+const int64_t ShardSizes[] = { 70000, 0, 1000, 129000 };
+
+std::vector<SRC::WString> WriteShards()
+{
+	std::vector<SRC::WString> vFiles;
+	int64_t nRecord = 0;
+	for (int64_t nSize : ShardSizes)
+	{
+		const std::string strFile = "temp_dataset_" + std::to_string(vFiles.size()) + ".yxdb";
+		vFiles.push_back(SRC::ConvertToWString(strFile.c_str()));
+
+		Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+		fileOut.SetZoneMaps(vFiles.size() % 2 == 1);
+		fileOut.Create(vFiles.back().c_str(), TestRecordInfoXml(true).c_str());
+		SRC::SmartPointerRefObj<SRC::Record> pRec = fileOut.m_recordInfo.CreateRecord();
+		for (int64_t nEnd = nRecord + nSize; nRecord < nEnd; ++nRecord)
+		{
+			FillTestRecord(fileOut.m_recordInfo, pRec.Get(), nRecord);
+			fileOut.AppendRecord(pRec->GetRecord());
+		}
+		fileOut.Close();
+	}
+	return vFiles;
+}
+
+// every record exactly once, and in order if bOrdered
+template <class T_Scan>
+bool CheckScan(Alteryx::OpenYXDB::YXDBDataset& dataset, bool bOrdered, T_Scan scan, int64_t nExpected)
+{
+	std::vector<int> vSeen(static_cast<size_t>(NumTestRecords));
+	int64_t nNext = 0, nFound = 0;
+	bool bOk = true;
+	std::mutex mutex;
+	scan([&](unsigned nShard, int64_t nRecord, const SRC::RecordData* pRec) {
+		std::lock_guard<std::mutex> lock(mutex);
+		bOk = bOk && nRecord >= 0 && nRecord < NumTestRecords && dataset.FindShard(nRecord) == nShard &&
+			  IsTestRecord(dataset.m_recordInfo, pRec, nRecord) && vSeen[size_t(nRecord)]++ == 0;
+		bOk = bOk && (!bOrdered || nRecord >= nNext);
+		nNext = nRecord + 1;
+		++nFound;
+	});
+	return bOk && nFound == nExpected;
+}
+}  // namespace
+
+void TestDataset()
+{
+	std::vector<SRC::WString> vFiles = WriteShards();
+
+	// few enough open files that the shards have to take turns, and a budget of less than a block
+	Alteryx::OpenYXDB::YXDBDataset dataset;
+	dataset.SetMaxOpenFiles(2);
+	dataset.SetMemoryBudget(64 * 1024);
+	dataset.Open(vFiles);
+	Check(dataset.GetNumShards() == 4 && dataset.GetNumRecords() == NumTestRecords, "YXDBDataset records");
+	Check(dataset.GetShardFirstRecord(2) == 70000 && dataset.GetShardNumRecords(1) == 0 &&
+			  dataset.GetShardFirstRecord(3) == 71000 && dataset.FindShard(69999) == 0 &&
+			  dataset.FindShard(70000) == 2 && dataset.FindShard(71000) == 3,
+		  "YXDBDataset shards");
+
+	int64_t nRecord = 0;
+	bool bOk = true;
+	while (const SRC::RecordData* pRec = dataset.ReadRecord())
+		bOk = bOk && IsTestRecord(dataset.m_recordInfo, pRec, nRecord++);
+	Check(bOk && nRecord == NumTestRecords, "YXDBDataset ReadRecord");
+
+	// jumping around, across the shard boundaries and back
+	std::mt19937 r;
+	std::vector<int64_t> vRecords = { 69999, 70000, 0, 70999, 71000, NumTestRecords - 1, 70000, 69999 };
+	for (unsigned x = 0; x < 50; ++x)
+		vRecords.push_back(int64_t(r() % NumTestRecords));
+	for (int64_t nGo : vRecords)
+	{
+		dataset.GoRecord(nGo);
+		const SRC::RecordData* pRec = dataset.ReadRecord();
+		bOk = bOk && pRec && IsTestRecord(dataset.m_recordInfo, pRec, nGo);
+		pRec = dataset.ReadRecord();
+		if (nGo + 1 == NumTestRecords)
+			bOk = bOk && pRec == NULL;
+		else
+			bOk = bOk && pRec && IsTestRecord(dataset.m_recordInfo, pRec, nGo + 1);
+	}
+	Check(bOk, "YXDBDataset GoRecord");
+
+	bool bThrew = false;
+	try
+	{
+		dataset.GoRecord(NumTestRecords);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "YXDBDataset GoRecord past the end");
+
+	// a scan in the middle of reading doesn't lose the place
+	dataset.GoRecord(69998);
+	dataset.ReadRecord();
+	for (bool bOrdered : { true, false })
+	{
+		bOk = CheckScan(
+			dataset,
+			bOrdered,
+			[&](const Alteryx::OpenYXDB::YXDBDataset::ScanCallback& callback) {
+				dataset.ParallelScan(callback, 4, bOrdered, 2);
+			},
+			NumTestRecords);
+		Check(bOk, bOrdered ? "YXDBDataset ordered ParallelScan" : "YXDBDataset unordered ParallelScan");
+	}
+	const SRC::RecordData* pRec = dataset.ReadRecord();
+	Check(pRec && IsTestRecord(dataset.m_recordInfo, pRec, 69999), "YXDBDataset ReadRecord after a scan");
+	pRec = dataset.ReadRecord();
+	Check(pRec && IsTestRecord(dataset.m_recordInfo, pRec, 70000), "YXDBDataset ReadRecord after a scan");
+
+	// just the ones the predicate matches, whether or not their shard has zone maps to skip blocks with
+	typedef SRC::RecordPredicate RP;
+	const RP predicate = RP::Or(RP::Compare(*dataset.m_recordInfo[0], RP::E_Compare_Less, 500),
+								RP::Compare(*dataset.m_recordInfo[0], RP::E_Compare_GreaterOrEqual, 70500));
+	int64_t nExpected = 0;
+	dataset.GoRecord(0);
+	while (const SRC::RecordData* pRec = dataset.ReadRecord())
+		nExpected += predicate.Matches(pRec) ? 1 : 0;
+	for (bool bOrdered : { true, false })
+	{
+		bOk = CheckScan(
+			dataset,
+			bOrdered,
+			[&](const Alteryx::OpenYXDB::YXDBDataset::ScanCallback& callback) {
+				dataset.Scan(predicate, callback, 4, bOrdered);
+			},
+			nExpected);
+		Check(bOk, bOrdered ? "YXDBDataset ordered Scan" : "YXDBDataset unordered Scan");
+	}
+}
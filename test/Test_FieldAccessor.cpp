@@ -0,0 +1,122 @@
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// TestUtil.h brings in SrcLib_Replacement.h, which has to come before the RecordLib headers
+#include "TestUtil.h"
+
+#include "RecordLib/FieldAccessor.h"
+
+namespace {
+// what FieldBase says the accessor should give
+template <class T_Value>
+T_Value GetExpected(const SRC::FieldBase& field, const SRC::RecordData* pRec)
+{
+	if (field.GetNull(pRec))
+		return T_Value(0);
+	if (std::is_same<T_Value, bool>::value)
+		return T_Value(field.GetAsBool(pRec).value);
+	if (std::numeric_limits<T_Value>::is_integer)
+		return T_Value(field.GetAsInt64(pRec).value);
+	return T_Value(field.GetAsDouble(pRec).value);
+}
+
+template <SRC::E_FieldType ft>
+bool IsExpected(const SRC::FieldAccessor<ft>& accessor, const SRC::FieldBase& field, const SRC::RecordData* pRec)
+{
+	typedef typename SRC::FieldAccessor<ft>::T_Value T_Value;
+	T_Value expected = GetExpected<T_Value>(field, pRec);
+	T_Value value = accessor.GetValue(pRec);
+	SRC::TFieldVal<T_Value> val = accessor.Get(pRec);
+	return accessor.GetNull(pRec) == field.GetNull(pRec) && val.bIsNull == field.GetNull(pRec) &&
+		   memcmp(&value, &expected, sizeof(T_Value)) == 0 && memcmp(&val.value, &expected, sizeof(T_Value)) == 0;
+}
+
+// sets values through FieldBase and reads them through the accessor, then the other way around
+template <SRC::E_FieldType ft>
+bool CheckAccessor(const SRC::RecordInfo& recordInfo, unsigned nField, const std::vector<double>& vValues)
+{
+	typedef typename SRC::FieldAccessor<ft>::T_Value T_Value;
+	const SRC::FieldBase& field = *recordInfo[nField];
+	SRC::FieldAccessor<ft> accessor(field);
+	bool bOk = accessor.GetOffset() == unsigned(field.GetOffset());
+
+	SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord();
+	for (double dValue : vValues)
+	{
+		// the values are set through FieldBase, which converts them to the field's type
+		field.SetFromDouble(pRec.Get(), dValue);
+		bOk = bOk && IsExpected(accessor, field, pRec->GetRecord());
+		field.SetNull(pRec.Get());
+		bOk = bOk && IsExpected(accessor, field, pRec->GetRecord());
+
+		T_Value value = T_Value(dValue);
+		accessor.SetValue(pRec.Get(), value);
+		bOk = bOk && !field.GetNull(pRec->GetRecord()) &&
+			  GetExpected<T_Value>(field, pRec->GetRecord()) == value;
+		accessor.SetNull(pRec->GetRecord());
+		bOk = bOk && field.GetNull(pRec->GetRecord()) && accessor.GetValue(pRec->GetRecord()) == T_Value(0);
+		accessor.Set(pRec.Get(), SRC::TFieldVal<T_Value>(false, value));
+		bOk = bOk && IsExpected(accessor, field, pRec->GetRecord()) && accessor.GetValue(pRec->GetRecord()) == value;
+		accessor.Set(pRec->GetRecord(), SRC::TFieldVal<T_Value>(true, value));
+		bOk = bOk && IsExpected(accessor, field, pRec->GetRecord()) && field.GetNull(pRec->GetRecord());
+	}
+
+	// setting a field only touches that field
+	for (unsigned x = 0; x < recordInfo.NumFields(); ++x)
+		recordInfo[x]->SetFromInt32(pRec.Get(), 1);
+	accessor.SetNull(pRec.Get());
+	for (unsigned x = 0; x < recordInfo.NumFields(); ++x)
+		bOk = bOk && (x == nField || recordInfo[x]->GetAsInt32(pRec->GetRecord()).value == 1);
+	return bOk;
+}
+}  // namespace
+
+void TestFieldAccessor()
+{
+	// every fixed width type, after a String so they aren't aligned
+	SRC::RecordInfo recordInfo;
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Code"), SRC::E_FT_String, 3));
+	const SRC::E_FieldType types[] = { SRC::E_FT_Bool,  SRC::E_FT_Byte,  SRC::E_FT_Int16, SRC::E_FT_Int32,
+									   SRC::E_FT_Int64, SRC::E_FT_Float, SRC::E_FT_Double };
+	for (SRC::E_FieldType ft : types)
+		recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(SRC::GetNameFromFieldType(ft), ft));
+
+	const std::vector<double> vBools = { 0, 1 };
+	const std::vector<double> vBytes = { 0, 1, 127, 128, 255 };
+	const std::vector<double> vInts = { 0, 1, -1, 32767, -32768 };
+	const std::vector<double> vInt32s = { 0, -1, 2147483647, -2147483648.0, 123456 };
+	const std::vector<double> vInt64s = { 0, -1, 9007199254740992.0, -9007199254740992.0, 1e15 };
+	const std::vector<double> vDoubles = { 0, -0.0, 1.5, -1e300, 5e-324, std::numeric_limits<double>::infinity() };
+	const std::vector<double> vFloats = { 0, -0.0, 1.5, -3e38, 1e-40, 1e10 };
+
+	Check(CheckAccessor<SRC::E_FT_Bool>(recordInfo, 1, vBools), "FieldAccessor Bool");
+	Check(CheckAccessor<SRC::E_FT_Byte>(recordInfo, 2, vBytes), "FieldAccessor Byte");
+	Check(CheckAccessor<SRC::E_FT_Int16>(recordInfo, 3, vInts), "FieldAccessor Int16");
+	Check(CheckAccessor<SRC::E_FT_Int32>(recordInfo, 4, vInt32s), "FieldAccessor Int32");
+	Check(CheckAccessor<SRC::E_FT_Int64>(recordInfo, 5, vInt64s), "FieldAccessor Int64");
+	Check(CheckAccessor<SRC::E_FT_Float>(recordInfo, 6, vFloats), "FieldAccessor Float");
+	Check(CheckAccessor<SRC::E_FT_Double>(recordInfo, 7, vDoubles), "FieldAccessor Double");
+
+	// the bool layout is bit 0 for the value and bit 1 for null
+	SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord();
+	SRC::FieldAccessor_Bool flag(*recordInfo[1]);
+	const char* pFlag = SRC::ToCharP(pRec->GetRecord()) + flag.GetOffset();
+	recordInfo[1]->SetFromBool(pRec.Get(), true);
+	Check(*pFlag == 1 && flag.GetValue(pRec->GetRecord()) && !flag.GetNull(pRec->GetRecord()), "FieldAccessor Bool layout");
+	recordInfo[1]->SetNull(pRec.Get());
+	Check((*pFlag & 2) != 0 && flag.GetNull(pRec->GetRecord()) && !flag.GetValue(pRec->GetRecord()),
+		  "FieldAccessor Bool layout");
+
+	// the type has to be the field's own
+	bool bThrew = false;
+	try
+	{
+		SRC::FieldAccessor_Int64 wrong(*recordInfo[4]);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "FieldAccessor of the wrong type");
+}
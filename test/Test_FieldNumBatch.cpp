@@ -0,0 +1,187 @@
+#include <cstring>
+#include <limits>
+
+#include "RecordLib/FieldNumBatch.h"
+#include "TestUtil.h"
+
+namespace {
+const SRC::E_FieldType NumTypes[] = { SRC::E_FT_Byte,  SRC::E_FT_Int16, SRC::E_FT_Int32,
+									  SRC::E_FT_Int64, SRC::E_FT_Float, SRC::E_FT_Double };
+
+// a value of field nField's type for record nRecord, including the extremes.  Every so often it is null,
+// on a different pattern for each field
+void SetNum(const SRC::FieldBase& field, unsigned nField, SRC::Record* pRec, unsigned nRecord)
+{
+	if ((nRecord + nField) % (3 + nField) == 0)
+	{
+		field.SetNull(pRec);
+		return;
+	}
+
+	const double dSpecial[] = { std::numeric_limits<double>::infinity(), -0.0, 5e-324, -1e300, 1e-300 };
+	const int64_t nSpecial[] = { std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), -1, 0 };
+	switch (field.m_ft)
+	{
+		case SRC::E_FT_Float:
+			field.SetFromDouble(pRec, nRecord % 11 == 0 ? float(dSpecial[nRecord % 4]) : nRecord * -0.25f);
+			break;
+		case SRC::E_FT_Double:
+			field.SetFromDouble(pRec, nRecord % 11 == 0 ? dSpecial[nRecord % 5] : nRecord * 1.5e10);
+			break;
+		case SRC::E_FT_Int64:
+			field.SetFromInt64(pRec, nRecord % 11 == 0 ? nSpecial[nRecord % 4] : int64_t(nRecord) * -123456789);
+			break;
+		case SRC::E_FT_Int32:
+			field.SetFromInt32(pRec, nRecord % 11 == 0 ? std::numeric_limits<int>::min() : int(nRecord * 7919));
+			break;
+		case SRC::E_FT_Int16:
+			field.SetFromInt32(pRec, int(nRecord % 65536) - 32768);
+			break;
+		default:
+			field.SetFromInt32(pRec, int(nRecord % 256));
+			break;
+	}
+}
+
+// what GetAsXxx says the gathered value should be
+template <class T_Num>
+T_Num GetExpected(const SRC::FieldBase& field, const SRC::RecordData* pRec)
+{
+	if (field.GetNull(pRec))
+		return T_Num(0);
+	if (std::numeric_limits<T_Num>::is_integer)
+		return T_Num(field.GetAsInt64(pRec).value);
+	return T_Num(field.GetAsDouble(pRec).value);
+}
+
+// a gather has to give exactly what the getters do, bit for bit
+template <class T_Num>
+bool IsExpected(
+	const SRC::FieldBase& field,
+	const SRC::RecordData* const* ppRecords,
+	size_t nRecords,
+	const T_Num* pValues,
+	const unsigned char* pNulls)
+{
+	for (size_t x = 0; x < nRecords; ++x)
+	{
+		T_Num expected = GetExpected<T_Num>(field, ppRecords[x]);
+		if (memcmp(&expected, &pValues[x], sizeof(T_Num)) != 0 || pNulls[x] != (field.GetNull(ppRecords[x]) ? 1 : 0))
+			return false;
+	}
+	return true;
+}
+
+// checks GatherNum and GatherNumStrided on field over every count of records up to nMaxRecords, from
+// records nStride bytes apart in vBuffer
+template <class T_Num>
+bool CheckGather(const SRC::FieldBase& field, const std::vector<char>& vBuffer, size_t nStride, size_t nMaxRecords)
+{
+	std::vector<const SRC::RecordData*> vRecords;
+	for (size_t x = 0; x < nMaxRecords; ++x)
+		vRecords.push_back(reinterpret_cast<const SRC::RecordData*>(vBuffer.data() + x * nStride));
+
+	bool bOk = true;
+	std::vector<T_Num> vValues, vOne(1);
+	std::vector<unsigned char> vNulls, vOneNull(1);
+	for (size_t nRecords = 0; nRecords <= nMaxRecords; nRecords += nRecords < 40 ? 1 : 37)
+	{
+		// with a guard value after the end, which must not be touched
+		vValues.assign(nRecords + 1, T_Num(42));
+		vNulls.assign(nRecords + 1, 42);
+		SRC::GatherNum(field, vRecords.data(), nRecords, vValues.data(), vNulls.data());
+		bOk = bOk && IsExpected(field, vRecords.data(), nRecords, vValues.data(), vNulls.data()) &&
+			  vValues[nRecords] == T_Num(42) && vNulls[nRecords] == 42;
+
+		vValues.assign(nRecords + 1, T_Num(42));
+		vNulls.assign(nRecords + 1, 42);
+		SRC::GatherNumStrided(field, vBuffer.data(), nStride, nRecords, vValues.data(), vNulls.data());
+		bOk = bOk && IsExpected(field, vRecords.data(), nRecords, vValues.data(), vNulls.data()) &&
+			  vValues[nRecords] == T_Num(42) && vNulls[nRecords] == 42;
+
+		// a single record never gets as far as a vector, so this is the scalar code to compare the vectors with
+		for (size_t x = 0; bOk && x < nRecords; ++x)
+		{
+			SRC::GatherNum(field, &vRecords[x], 1, vOne.data(), vOneNull.data());
+			bOk = memcmp(&vOne[0], &vValues[x], sizeof(T_Num)) == 0 && vOneNull[0] == vNulls[x];
+		}
+	}
+
+	// the records in reverse, which the pointer gathers don't care about
+	std::vector<const SRC::RecordData*> vReversed(vRecords.rbegin(), vRecords.rend());
+	vValues.assign(nMaxRecords, T_Num(0));
+	vNulls.assign(nMaxRecords, 0);
+	SRC::GatherNum(field, vReversed.data(), nMaxRecords, vValues.data(), vNulls.data());
+	return bOk && IsExpected(field, vReversed.data(), nMaxRecords, vValues.data(), vNulls.data());
+}
+
+bool CheckField(const SRC::FieldBase& field, const std::vector<char>& vBuffer, size_t nStride, size_t nMaxRecords)
+{
+	switch (field.m_ft)
+	{
+		case SRC::E_FT_Byte:
+			return CheckGather<unsigned char>(field, vBuffer, nStride, nMaxRecords);
+		case SRC::E_FT_Int16:
+			return CheckGather<int16_t>(field, vBuffer, nStride, nMaxRecords);
+		case SRC::E_FT_Int32:
+			return CheckGather<int32_t>(field, vBuffer, nStride, nMaxRecords);
+		case SRC::E_FT_Int64:
+			return CheckGather<int64_t>(field, vBuffer, nStride, nMaxRecords);
+		case SRC::E_FT_Float:
+			return CheckGather<float>(field, vBuffer, nStride, nMaxRecords);
+		default:
+			return CheckGather<double>(field, vBuffer, nStride, nMaxRecords);
+	}
+}
+}  // namespace
+
+void TestFieldNumBatch()
+{
+	// a Bool and a String in front put the numbers at odd offsets
+	SRC::RecordInfo recordInfo;
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Flag"), SRC::E_FT_Bool));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Code"), SRC::E_FT_String, 3));
+	for (SRC::E_FieldType ft : NumTypes)
+		recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(SRC::GetNameFromFieldType(ft), ft));
+	const size_t nRecordSize = size_t(recordInfo.GetFixedRecordSize());
+
+	// the records nStride bytes apart: back to back, with a few bytes between them so the fields aren't
+	// aligned, far apart, and all on top of each other
+	const size_t nMaxRecords = 300;
+	for (size_t nStride : { nRecordSize, nRecordSize + 3, nRecordSize * 64 + 1, size_t(0) })
+	{
+		std::vector<char> vBuffer(nRecordSize + nStride * nMaxRecords);
+		SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord();
+		for (unsigned x = 0; x < nMaxRecords; ++x)
+		{
+			pRec->Reset();
+			recordInfo[0]->SetFromBool(pRec.Get(), x % 2 == 0);
+			recordInfo[1]->SetFromString(pRec.Get(), "abc", 3);
+			for (unsigned nField = 2; nField < recordInfo.NumFields(); ++nField)
+				SetNum(*recordInfo[nField], nField, pRec.Get(), x);
+			memcpy(vBuffer.data() + x * nStride, pRec->GetRecord(), nRecordSize);
+		}
+
+		for (unsigned nField = 2; nField < recordInfo.NumFields(); ++nField)
+		{
+			SRC::AString strWhat = SRC::AString("GatherNum ") +
+								   SRC::ConvertToAString(SRC::GetNameFromFieldType(recordInfo[nField]->m_ft));
+			Check(CheckField(*recordInfo[nField], vBuffer, nStride, nMaxRecords), strWhat.c_str());
+		}
+	}
+
+	// the type of the values has to match the field
+	bool bThrew = false;
+	try
+	{
+		const SRC::RecordData* pRecord = NULL;
+		double dValue;
+		unsigned char nNull;
+		SRC::GatherNum(*recordInfo[2], &pRecord, 0, &dValue, &nNull);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "GatherNum into the wrong type");
+}
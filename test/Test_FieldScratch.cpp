@@ -0,0 +1,107 @@
+#include <thread>
+
+// TestUtil.h brings in SrcLib_Replacement.h, which has to come before the RecordLib headers
+#include "TestUtil.h"
+
+#include "RecordLib/FieldBase.h"
+
+namespace {
+// what each of the getters gave for a record, as text
+struct Values
+{
+	SRC::AString m_strText;
+	SRC::AString m_strNumber;
+	SRC::AString m_strWide;
+	int m_nInt;
+	double m_dDouble;
+	unsigned m_nErrors;
+
+	bool operator==(const Values& o) const
+	{
+		return m_strText == o.m_strText && m_strNumber == o.m_strNumber && m_strWide == o.m_strWide &&
+			   m_nInt == o.m_nInt && m_dDouble == o.m_dDouble && m_nErrors == o.m_nErrors;
+	}
+};
+
+// the values that have to go through the scratch's buffers, and the conversion errors they cause
+Values GetValues(const SRC::RecordInfo& recordInfo, const SRC::RecordData* pRec, SRC::FieldScratch& r_scratch)
+{
+	Values values;
+	unsigned nErrors = r_scratch.GetConversionErrorCount();
+	values.m_strText = recordInfo[0]->GetAsAStringReentrant(pRec, r_scratch).value.pValue;
+	values.m_nInt = recordInfo[0]->GetAsInt32Reentrant(pRec, r_scratch).value;
+	values.m_dDouble = recordInfo[0]->GetAsDoubleReentrant(pRec, r_scratch).value;
+	values.m_strNumber = recordInfo[1]->GetAsAStringReentrant(pRec, r_scratch).value.pValue;
+	values.m_strWide = SRC::ConvertToAString(recordInfo[2]->GetAsWStringReentrant(pRec, r_scratch).value.pValue);
+	values.m_nErrors = r_scratch.GetConversionErrorCount() - nErrors;
+	return values;
+}
+}  // namespace
+
+void TestFieldScratch()
+{
+	// text that is sometimes a number and sometimes isn't, a number that has to be formatted, and a wide string
+	SRC::RecordInfo recordInfo;
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Text"), SRC::E_FT_V_String, 100));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Number"), SRC::E_FT_Double));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Wide"), SRC::E_FT_V_WString, 100));
+
+	const unsigned nRecords = 2000;
+	std::vector<SRC::SmartPointerRefObj<SRC::Record>> vRecords;
+	for (unsigned x = 0; x < nRecords; ++x)
+	{
+		vRecords.push_back(recordInfo.CreateRecord());
+		SRC::Record* pRec = vRecords.back().Get();
+		pRec->Reset();
+		if (x % 3 == 0)
+			recordInfo[0]->SetFromString(pRec, EnglishNumber(int(x)));
+		else
+			recordInfo[0]->SetFromInt32(pRec, int(x));
+		recordInfo[1]->SetFromDouble(pRec, x / 8.0);
+		recordInfo[2]->SetFromString(pRec, EnglishNumber(int(x) * 1001));
+	}
+
+	// the answers, one record at a time on this thread
+	std::vector<Values> vExpected;
+	unsigned nExpectedErrors = 0;
+	{
+		SRC::FieldScratch scratch;
+		for (const SRC::SmartPointerRefObj<SRC::Record>& pRec : vRecords)
+		{
+			vExpected.push_back(GetValues(recordInfo, pRec->GetRecord(), scratch));
+			nExpectedErrors += vExpected.back().m_nErrors;
+		}
+		Check(nExpectedErrors != 0 && scratch.GetConversionErrorCount() == nExpectedErrors, "FieldScratch errors");
+	}
+
+	// every thread reads every record through the same fields, starting in different places
+	const unsigned nThreads = 8;
+	std::vector<unsigned> vErrors(nThreads);
+	std::vector<char> vOk(nThreads);
+	std::vector<std::thread> vThreads;
+	for (unsigned t = 0; t < nThreads; ++t)
+	{
+		vThreads.emplace_back(
+			[&, t]
+			{
+				SRC::FieldScratch scratch;
+				bool bOk = true;
+				for (unsigned nPass = 0; nPass < 5; ++nPass)
+				{
+					for (unsigned x = 0; x < nRecords; ++x)
+					{
+						unsigned nRecord = (x + t * 251) % nRecords;
+						bOk = bOk && GetValues(recordInfo, vRecords[nRecord]->GetRecord(), scratch) == vExpected[nRecord];
+					}
+				}
+				vOk[t] = bOk;
+				vErrors[t] = scratch.GetConversionErrorCount();
+			});
+	}
+	for (std::thread& thread : vThreads)
+		thread.join();
+
+	// each scratch only counts its own thread's errors
+	for (unsigned t = 0; t < nThreads; ++t)
+		Check(vOk[t] && vErrors[t] == 5 * nExpectedErrors, "FieldScratch from several threads");
+}
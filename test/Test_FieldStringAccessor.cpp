@@ -0,0 +1,105 @@
+#include <string>
+
+// TestUtil.h brings in SrcLib_Replacement.h, which has to come before the RecordLib headers
+#include "TestUtil.h"
+
+#include "RecordLib/FieldAccessor.h"
+
+namespace {
+// what FieldBase says the view should hold
+SRC::TFieldVal<std::string> GetExpected(const SRC::FieldBase& field, const SRC::RecordData* pRec, char)
+{
+	SRC::TFieldVal<SRC::AStringVal> val = field.GetAsAString(pRec);
+	return SRC::TFieldVal<std::string>(val.bIsNull, val.bIsNull ? std::string() : std::string(val.value.pValue));
+}
+
+SRC::TFieldVal<std::u16string> GetExpected(const SRC::FieldBase& field, const SRC::RecordData* pRec, U16unit)
+{
+	SRC::TFieldVal<SRC::WStringVal> val = field.GetAsWString(pRec);
+	const char16_t* pValue = reinterpret_cast<const char16_t*>(val.value.pValue);
+	return SRC::TFieldVal<std::u16string>(val.bIsNull, val.bIsNull ? std::u16string() : std::u16string(pValue));
+}
+
+template <SRC::E_FieldType ft>
+bool IsExpected(const SRC::FieldStringAccessor<ft>& accessor, const SRC::FieldBase& field, const SRC::RecordData* pRec)
+{
+	typedef typename SRC::FieldStringAccessor<ft>::T_Char T_Char;
+	auto expected = GetExpected(field, pRec, T_Char());
+	SRC::TFieldVal<SRC::TBlobVal<T_Char>> val = accessor.Get(pRec);
+	if (val.bIsNull || expected.bIsNull)
+		return val.bIsNull == expected.bIsNull && accessor.GetNull(pRec) && val.value.pValue == NULL &&
+			   val.value.nLength == 0;
+
+	// the view isn't terminated, and a WString view may not be aligned
+	typedef typename decltype(expected.value)::value_type T_Unit;
+	decltype(expected.value) strValue(val.value.nLength, T_Unit(0));
+	memcpy(&strValue[0], val.value.pValue, val.value.nLength * sizeof(T_Char));
+	return !accessor.GetNull(pRec) && strValue == expected.value;
+}
+}  // namespace
+
+void TestFieldStringAccessor()
+{
+	// each string type, after a Byte so the fixed ones aren't aligned, and a V_String between the var ones
+	SRC::RecordInfo recordInfo;
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Flag"), SRC::E_FT_Byte));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Code"), SRC::E_FT_String, 8));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Wide Code"), SRC::E_FT_WString, 8));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Text"), SRC::E_FT_V_String, 1000));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Other"), SRC::E_FT_V_String, 1000));
+	recordInfo.AddField(SRC::RecordInfo::CreateFieldXml(U16("Wide Text"), SRC::E_FT_V_WString, 1000));
+
+	const SRC::FieldStringAccessor_String code(*recordInfo[1]);
+	const SRC::FieldStringAccessor_WString wideCode(*recordInfo[2]);
+	const SRC::FieldStringAccessor_V_String text(*recordInfo[3]);
+	const SRC::FieldStringAccessor_V_WString wideText(*recordInfo[5]);
+
+	// null, empty, small enough to live inline in the var data offset, exactly the fixed width,
+	// too long for the fixed width, and well into the var data
+	const U16unit* pValues[] = { NULL,
+									  U16(""),
+									  U16("a"),
+									  U16("ab"),
+									  U16("abc"),
+									  U16("été"),
+									  U16("12345678"),
+									  U16("123456789abc"),
+									  U16("two hundred thousand and one, give or take a few hundred characters") };
+	SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord();
+	for (const U16unit* pValue : pValues)
+	{
+		for (const U16unit* pOther : { (const U16unit*)NULL, U16("x"), pValues[8] })
+		{
+			pRec->Reset();
+			recordInfo[0]->SetFromInt32(pRec.Get(), 255);
+			for (unsigned x = 1; x < recordInfo.NumFields(); ++x)
+			{
+				const U16unit* pSet = x == 4 ? pOther : pValue;
+				if (pSet)
+					recordInfo[x]->SetFromString(pRec.Get(), pSet);
+				else
+					recordInfo[x]->SetNull(pRec.Get());
+			}
+
+			const SRC::RecordData* pData = pRec->GetRecord();
+			SRC::AString strWhat = SRC::AString("FieldStringAccessor ") + (pValue ? SRC::ConvertToAString(pValue) : "null");
+			Check(IsExpected(code, *recordInfo[1], pData), (strWhat + " String").c_str());
+			Check(IsExpected(wideCode, *recordInfo[2], pData), (strWhat + " WString").c_str());
+			Check(IsExpected(text, *recordInfo[3], pData), (strWhat + " V_String").c_str());
+			Check(IsExpected(wideText, *recordInfo[5], pData), (strWhat + " V_WString").c_str());
+			Check(pValue == NULL || !text.GetNull(pData), (strWhat + " is not null").c_str());
+		}
+	}
+
+	// the type has to be the field's own
+	bool bThrew = false;
+	try
+	{
+		SRC::FieldStringAccessor_String wrong(*recordInfo[3]);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "FieldStringAccessor of the wrong type");
+}
@@ -0,0 +1,199 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "Base/LzfWrapper.h"
+#include "TestUtil.h"
+
+namespace {
+// what a decompressor did with one stream.  The wide copy decompressors can write past the end of the data
+// they return (but never past out_len), so only the bytes they return are compared
+struct Result
+{
+	unsigned m_nReturn;
+	int m_nErrno;
+	std::vector<unsigned char> m_vOut;
+	bool m_bGuardIntact;
+};
+
+const unsigned GuardSize = 64;
+const unsigned char GuardByte = 0xcd;
+
+template <class T_Decompress>
+Result Decompress(T_Decompress decompress, const std::vector<unsigned char>& vIn, unsigned nOutLen)
+{
+	std::vector<unsigned char> vOut(nOutLen + GuardSize, GuardByte);
+	Result result;
+	errno = 0;
+	result.m_nReturn = decompress(vIn.data(), unsigned(vIn.size()), vOut.data(), nOutLen);
+	result.m_nErrno = errno;
+	result.m_bGuardIntact = true;
+	for (unsigned x = nOutLen; x < vOut.size(); ++x)
+		result.m_bGuardIntact = result.m_bGuardIntact && vOut[x] == GuardByte;
+	vOut.resize(result.m_nReturn <= nOutLen ? result.m_nReturn : 0);
+	result.m_vOut.swap(vOut);
+	return result;
+}
+
+// runs every available decompressor on vIn and checks they all match the reference
+class Checker
+{
+	std::vector<SRC::LzfWrapper::E_LzfDecompressor> m_vDecompressors;
+
+public:
+	unsigned m_nStreams = 0;
+	unsigned m_nErrors = 0;
+	bool m_bOk = true;
+
+	Checker()
+	{
+		for (SRC::LzfWrapper::E_LzfDecompressor eDecompressor :
+			 { SRC::LzfWrapper::E_LzfDecompressor_SSE2, SRC::LzfWrapper::E_LzfDecompressor_AVX2 })
+		{
+			if (SRC::LzfWrapper::SetDecompressor(eDecompressor) == eDecompressor)
+				m_vDecompressors.push_back(eDecompressor);
+		}
+	}
+	~Checker()
+	{
+		SRC::LzfWrapper::SetDecompressor(SRC::LzfWrapper::GetBestDecompressor());
+	}
+
+	void Run(const std::vector<unsigned char>& vIn, unsigned nOutLen)
+	{
+		Result reference = Decompress(&SRC::LzfWrapper::lzf_decompress_reference, vIn, nOutLen);
+		++m_nStreams;
+		m_nErrors += reference.m_nReturn == 0 ? 1 : 0;
+
+		for (SRC::LzfWrapper::E_LzfDecompressor eDecompressor : m_vDecompressors)
+		{
+			SRC::LzfWrapper::SetDecompressor(eDecompressor);
+			Result result = Decompress(&SRC::LzfWrapper::lzf_decompress, vIn, nOutLen);
+			bool bSame = result.m_nReturn == reference.m_nReturn && result.m_vOut == reference.m_vOut &&
+						 result.m_bGuardIntact && (reference.m_nReturn != 0 || result.m_nErrno == reference.m_nErrno);
+			if (!bSame && m_bOk)
+			{
+				std::cout << "decompressor " << eDecompressor << " returned " << result.m_nReturn << " errno "
+						  << result.m_nErrno << " for a " << vIn.size() << " byte stream into " << nOutLen
+						  << " bytes, the reference returned " << reference.m_nReturn << " errno " << reference.m_nErrno
+						  << "\n";
+			}
+			m_bOk = m_bOk && bSame;
+		}
+	}
+
+	// the stream itself, with too little room, and cut short
+	void RunAll(const std::vector<unsigned char>& vData, std::mt19937& r)
+	{
+		typedef unsigned (*CompressFn)(const void*, unsigned, void*, unsigned);
+		const CompressFn compressors[] = {
+			[](const void* pIn, unsigned nIn, void* pOut, unsigned nOut)
+			{ return SRC::LzfWrapper::lzf_compress(pIn, nIn, pOut, nOut); },
+			[](const void* pIn, unsigned nIn, void* pOut, unsigned nOut)
+			{ return SRC::LzfWrapper::lzf_compress_fast(pIn, nIn, pOut, nOut); },
+			[](const void* pIn, unsigned nIn, void* pOut, unsigned nOut)
+			{ return SRC::LzfWrapper::lzf_compress_dense(pIn, nIn, pOut, nOut); },
+		};
+
+		std::vector<unsigned char> vCompressed(vData.size() + vData.size() / 16 + 64);
+		for (CompressFn compress : compressors)
+		{
+			unsigned nCompressed =
+				compress(vData.data(), unsigned(vData.size()), vCompressed.data(), unsigned(vCompressed.size()));
+			if (nCompressed == 0)
+				continue;
+			std::vector<unsigned char> vIn(vCompressed.begin(), vCompressed.begin() + nCompressed);
+
+			unsigned nSize = unsigned(vData.size());
+			Run(vIn, nSize);
+			Run(vIn, nSize + 100);
+			Run(vIn, nSize - 1);
+			Run(vIn, nSize / 2);
+			Run(vIn, 0);
+
+			std::vector<unsigned char> vShort(vIn);
+			for (unsigned x = 0; x < 4 && vShort.size() > 1; ++x)
+			{
+				vShort.resize(1 + r() % (vShort.size() - 1));
+				Run(vShort, nSize);
+			}
+		}
+	}
+};
+}  // namespace
+
+void TestLzfDecompressors()
+{
+	Checker checker;
+	std::mt19937 r;
+
+	for (unsigned nSize = 1; nSize < 3000; nSize += 1 + nSize / 8)
+	{
+		// random bytes, which mostly come out as literal runs
+		std::vector<unsigned char> vData(nSize);
+		for (unsigned char& c : vData)
+			c = static_cast<unsigned char>(r());
+		checker.RunAll(vData, r);
+
+		// a few distinct bytes, which gives lots of short matches
+		for (unsigned char& c : vData)
+			c = static_cast<unsigned char>('a' + r() % 3);
+		checker.RunAll(vData, r);
+	}
+
+	// long runs repeating every 1 to 40 bytes, which is where the matches overlap what they are writing
+	for (unsigned nPeriod = 1; nPeriod <= 40; ++nPeriod)
+	{
+		std::vector<unsigned char> vData(20000 + r() % 1000);
+		for (size_t x = 0; x < vData.size(); ++x)
+			vData[x] = static_cast<unsigned char>(x % nPeriod * 37);
+		checker.RunAll(vData, r);
+	}
+
+	// text, as it is in the files
+	std::vector<unsigned char> vText;
+	while (vText.size() < 300000)
+	{
+		SRC::AString str = EnglishNumber(int(r() % 100000));
+		vText.insert(vText.end(), str.c_str(), str.c_str() + str.size());
+	}
+	checker.RunAll(vText, r);
+
+	// back references from further back than the start of the output, at the start and after some literals
+	for (unsigned nLiterals = 0; nLiterals < 40; ++nLiterals)
+	{
+		std::vector<unsigned char> vIn;
+		if (nLiterals != 0)
+		{
+			vIn.push_back(static_cast<unsigned char>(nLiterals - 1));
+			for (unsigned x = 0; x < nLiterals; ++x)
+				vIn.push_back(static_cast<unsigned char>('a' + x % 26));
+		}
+		for (unsigned nOffset : { nLiterals, nLiterals + 1, nLiterals + 100, 8192u })
+		{
+			// a 3 byte match (ctrl 1 << 5) from nOffset + 1 back
+			std::vector<unsigned char> vBad(vIn);
+			vBad.push_back(static_cast<unsigned char>((1 << 5) | ((nOffset >> 8) & 0x1f)));
+			vBad.push_back(static_cast<unsigned char>(nOffset & 0xff));
+			checker.Run(vBad, 1000);
+
+			// the same as a long match (ctrl 7 << 5 and a length byte)
+			vBad.resize(vIn.size());
+			vBad.push_back(static_cast<unsigned char>((7 << 5) | ((nOffset >> 8) & 0x1f)));
+			vBad.push_back(200);
+			vBad.push_back(static_cast<unsigned char>(nOffset & 0xff));
+			checker.Run(vBad, 1000);
+		}
+	}
+
+	// random garbage, which is mostly rejected one way or another
+	for (unsigned x = 0; x < 2000; ++x)
+	{
+		std::vector<unsigned char> vIn(1 + r() % 200);
+		for (unsigned char& c : vIn)
+			c = static_cast<unsigned char>(r());
+		checker.Run(vIn, r() % 2000);
+	}
+
+	Check(checker.m_bOk && checker.m_nErrors > 1000, "LZF decompressors match the reference");
+}
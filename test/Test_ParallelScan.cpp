@@ -0,0 +1,56 @@
+#include <atomic>
+#include <mutex>
+
+#include "TestUtil.h"
+
+void TestParallelScan()
+{
+	WriteTestFile(U16("temp_scan.yxdb"), true, E_Append_Records, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_scan.yxdb"));
+
+	// ordered, with as few blocks held back as it allows, the callback is on this thread so it can use the file's fields
+	int64_t nNext = 0;
+	bool bOk = true;
+	file.ParallelScan(
+		[&](unsigned nBlock, int64_t nRecord, const SRC::RecordData* pRec)
+		{
+			bOk = bOk && nRecord == nNext++ && nBlock == unsigned(nRecord / Alteryx::OpenYXDB::RecordsPerBlock) &&
+				  IsTestRecord(file.m_recordInfo, pRec, nRecord);
+		},
+		4,
+		true,
+		1);
+	Check(bOk && nNext == NumTestRecords, "ordered ParallelScan");
+
+	// unordered, the callback is on the worker threads, so each one checks the records with its own RecordInfo
+	std::vector<std::atomic<int>> vSeen(static_cast<size_t>(NumTestRecords));
+	std::atomic<bool> bAllOk(true);
+	std::mutex mutex;
+	file.ParallelScan(
+		[&](unsigned, int64_t nRecord, const SRC::RecordData* pRec)
+		{
+			thread_local SRC::RecordInfo recordInfo;
+			if (recordInfo.NumFields() == 0)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				recordInfo.InitFromXml(file.GetRecordXmlMetaData().c_str());
+			}
+			if (nRecord < 0 || nRecord >= NumTestRecords || !IsTestRecord(recordInfo, pRec, nRecord))
+				bAllOk = false;
+			else
+				vSeen[size_t(nRecord)]++;
+		},
+		4,
+		false);
+	for (const std::atomic<int>& nSeen : vSeen)
+		bAllOk = bAllOk && nSeen == 1;
+	Check(bAllOk, "unordered ParallelScan");
+
+	// the scan doesn't move the read position
+	file.GoRecord(12345);
+	file.ParallelScan([](unsigned, int64_t, const SRC::RecordData*) {}, 2);
+	const SRC::RecordData* pRec = file.ReadRecord();
+	Check(pRec && IsTestRecord(file.m_recordInfo, pRec, 12345), "ParallelScan read position");
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "TestUtil.h"
+
+namespace {
+// appends the test records from nThreads threads at once, each taking every nThreads'th record.
+// Half the threads use AppendRecords
+void AppendTestRecords(Alteryx::OpenYXDB::YXDBPartitionedWriter& r_writer, unsigned nThreads)
+{
+	std::vector<std::thread> vThreads;
+	for (unsigned t = 0; t < nThreads; ++t)
+	{
+		vThreads.emplace_back([&r_writer, nThreads, t] {
+			std::vector<SRC::SmartPointerRefObj<SRC::Record>> vRecords;
+			std::vector<const SRC::RecordData*> vBatch;
+			for (int64_t nRecord = t; nRecord < NumTestRecords; nRecord += nThreads)
+			{
+				if (t % 2 == 0)
+				{
+					if (vRecords.empty())
+						vRecords.push_back(r_writer.m_recordInfo.CreateRecord());
+					FillTestRecord(r_writer.m_recordInfo, vRecords[0].Get(), nRecord);
+					r_writer.AppendRecord(vRecords[0]->GetRecord());
+					continue;
+				}
+
+				vRecords.push_back(r_writer.m_recordInfo.CreateRecord());
+				FillTestRecord(r_writer.m_recordInfo, vRecords.back().Get(), nRecord);
+				if (vRecords.size() == 100 || nRecord + nThreads >= NumTestRecords)
+				{
+					vBatch.clear();
+					for (const SRC::SmartPointerRefObj<SRC::Record>& pRec : vRecords)
+						vBatch.push_back(pRec->GetRecord());
+					r_writer.AppendRecords(vBatch.data(), vBatch.size());
+					vRecords.clear();
+				}
+			}
+		});
+	}
+	for (std::thread& thread : vThreads)
+		thread.join();
+}
+
+// every file is as the writer says, and together they have every record exactly once.
+// Returns the partition of each record
+std::vector<unsigned> CheckFiles(const Alteryx::OpenYXDB::YXDBPartitionedWriter& writer, const char* pWhat)
+{
+	std::vector<unsigned> vPartitions(static_cast<size_t>(NumTestRecords), unsigned(-1));
+	bool bOk = true;
+	const std::vector<Alteryx::OpenYXDB::YXDBPartitionedWriter::OutputFile>& vFiles = writer.GetFiles();
+	for (size_t x = 0; x < vFiles.size(); ++x)
+	{
+		bOk = bOk && (x == 0 || vFiles[x - 1].m_nPartition <= vFiles[x].m_nPartition);
+
+		Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+		file.Open(vFiles[x].m_strFile.c_str());
+		bOk = bOk && file.GetNumRecords() == vFiles[x].m_nNumRecords;
+		while (const SRC::RecordData* pRec = file.ReadRecord())
+		{
+			int64_t nRecord = file.m_recordInfo[0]->GetAsInt64(pRec).value;
+			bOk = bOk && nRecord >= 0 && nRecord < NumTestRecords && IsTestRecord(file.m_recordInfo, pRec, nRecord) &&
+				  vPartitions[size_t(nRecord)] == unsigned(-1);
+			if (bOk)
+				vPartitions[size_t(nRecord)] = vFiles[x].m_nPartition;
+		}
+	}
+	for (unsigned nPartition : vPartitions)
+		bOk = bOk && nPartition != unsigned(-1);
+	Check(bOk, pWhat);
+	return vPartitions;
+}
+}  // namespace
+
+void TestPartitionedWriter()
+{
+	// hashed on the Name, which repeats every 100000 records, with files small enough that each partition
+	// needs a few of them
+	Alteryx::OpenYXDB::YXDBPartitionedWriter writer;
+	writer.SetPartitioning(Alteryx::OpenYXDB::YXDBPartitionedWriter::E_Partitioning_Hash, 3, 2);
+	writer.SetMaxFileSize(1024 * 1024);
+	writer.SetFileOptions([](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetZoneMaps(true); });
+	writer.Create(U16("temp_partitioned"), TestRecordInfoXml(true).c_str());
+	AppendTestRecords(writer, 4);
+	writer.Close();
+
+	std::vector<unsigned> vPartitions = CheckFiles(writer, "partitioned by hash");
+	std::vector<int64_t> vCounts(3);
+	bool bOk = true;
+	for (int64_t nRecord = 0; nRecord < NumTestRecords; ++nRecord)
+	{
+		bOk = bOk && vPartitions[size_t(nRecord)] < 3;
+		if (nRecord >= 100000)
+			bOk = bOk && vPartitions[size_t(nRecord)] == vPartitions[size_t(nRecord - 100000)];
+		if (bOk)
+			vCounts[vPartitions[size_t(nRecord)]]++;
+	}
+	Check(bOk && vCounts[0] != 0 && vCounts[1] != 0 && vCounts[2] != 0, "partitioned by hash key");
+	Check(writer.GetFiles().size() > 3, "partitioned max file size");
+
+	// the manifest names every file, relative to itself
+	FILE* pManifest = fopen(SRC::ConvertToAString(writer.GetManifestFile().c_str()).c_str(), "rb");
+	Check(pManifest != NULL, "partitioned manifest");
+	std::string strManifest;
+	if (pManifest)
+	{
+		char buffer[4096];
+		for (size_t nRead; (nRead = fread(buffer, 1, sizeof(buffer), pManifest)) != 0;)
+			strManifest.append(buffer, nRead);
+		fclose(pManifest);
+	}
+	bOk = strManifest.find("NumRecords=\"" + std::to_string(NumTestRecords) + "\"") != std::string::npos;
+	for (const Alteryx::OpenYXDB::YXDBPartitionedWriter::OutputFile& file : writer.GetFiles())
+	{
+		std::string strFile = SRC::ConvertToAString(file.m_strFile.c_str()).c_str();
+		bOk = bOk && strManifest.find("<File Name=\"" + strFile + "\"") != std::string::npos;
+	}
+	Check(bOk, "partitioned manifest");
+
+	// round robin from a single thread spreads the records evenly
+	Alteryx::OpenYXDB::YXDBPartitionedWriter roundRobin;
+	roundRobin.SetPartitioning(Alteryx::OpenYXDB::YXDBPartitionedWriter::E_Partitioning_RoundRobin, 3);
+	roundRobin.Create(U16("temp_round_robin"), TestRecordInfoXml(false).c_str());
+	AppendTestRecords(roundRobin, 1);
+	roundRobin.Close();
+
+	vPartitions = CheckFiles(roundRobin, "partitioned round robin");
+	vCounts.assign(3, 0);
+	for (unsigned nPartition : vPartitions)
+		vCounts[nPartition < 3 ? nPartition : 0]++;
+	const auto minMax = std::minmax_element(vCounts.begin(), vCounts.end());
+	Check(roundRobin.GetFiles().size() == 3 && *minMax.second - *minMax.first <= 1, "partitioned round robin counts");
+}
@@ -0,0 +1,46 @@
+#include <cstring>
+
+#include "TestUtil.h"
+
+void TestProjection()
+{
+	WriteTestFile(U16("temp_projection.yxdb"), true, E_Append_Records, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_projection.yxdb"));
+
+	// a var data column and a nullable fixed width one, in a different order than the record has them
+	for (bool bByName : { false, true })
+	{
+		if (bByName)
+			file.SetProjection(std::vector<SRC::StringNoCase>{ U16("name"), U16("VALUE") });
+		else
+			file.SetProjection(std::vector<unsigned>{ 2, 1 });
+
+		Alteryx::OpenYXDB::ProjectedBlock block;
+		file.GoRecord(0);
+		int64_t nRecord = 0;
+		bool bOk = true;
+		for (unsigned nBlock = 0; nBlock < file.GetNumRecordBlocks(); ++nBlock)
+		{
+			file.ReadProjectedBlock(nBlock, block);
+			bOk = bOk && block.m_nBlock == nBlock && block.m_nFirstRecord == nRecord && block.m_vColumns.size() == 2;
+
+			const Alteryx::OpenYXDB::ProjectedColumn& name = block.m_vColumns[0];
+			const Alteryx::OpenYXDB::ProjectedColumn& value = block.m_vColumns[1];
+			bOk = bOk && name.m_nField == 2 && name.m_bIsBytes && value.m_nField == 1 && !value.m_bIsBytes;
+			for (unsigned x = 0; bOk && x < block.m_nNumRecords; ++x, ++nRecord)
+			{
+				const SRC::RecordData* pRec = file.ReadRecord();
+				SRC::TFieldVal<double> dValue = file.m_recordInfo[1]->GetAsDouble(pRec);
+				SRC::AString strName = file.m_recordInfo[2]->GetAsAString(pRec).value.pValue;
+
+				SRC::BlobVal bytes = name.GetBytes(x);
+				bOk = pRec && !name.GetNull(x) && bytes.nLength == strName.size() &&
+					  memcmp(bytes.pValue, strName.c_str(), bytes.nLength) == 0 && value.GetNull(x) == dValue.bIsNull &&
+					  value.GetValues<double>()[x] == (dValue.bIsNull ? 0 : dValue.value);
+			}
+		}
+		Check(bOk && nRecord == NumTestRecords, bByName ? "projection by name" : "projection by number");
+	}
+}
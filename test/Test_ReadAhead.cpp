@@ -0,0 +1,43 @@
+#include "TestUtil.h"
+
+void TestReadAhead()
+{
+	WriteTestFile(U16("temp_readahead.yxdb"),
+				  true,
+				  E_Append_Records,
+				  [](Alteryx::OpenYXDB::Open_AlteryxYXDB& file)
+				  { file.SetCompressionBlockSize(Alteryx::OpenYXDB::MinLzfBlockSize); });
+
+	// without the mapping the read ahead thread reads with ReadAt while this thread moves the file position
+	for (bool bMemoryMap : { false, true })
+	{
+		for (unsigned nBlocks : { 1u, 4u })
+		{
+			Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+			file.SetMemoryMapping(bMemoryMap);
+			file.SetReadAhead(nBlocks);
+			file.Open(U16("temp_readahead.yxdb"));
+
+			int64_t nRecord = 0;
+			bool bOk = true;
+			while (const SRC::RecordData* pRec = file.ReadRecord())
+				bOk = bOk && IsTestRecord(file.m_recordInfo, pRec, nRecord++);
+			bOk = bOk && nRecord == NumTestRecords;
+
+			// GoRecord restarts the read ahead somewhere else, and reading a little way on from there has
+			// to still give the right records
+			std::mt19937 r(nBlocks);
+			for (unsigned x = 0; bOk && x < 20; ++x)
+			{
+				nRecord = int64_t(r() % NumTestRecords);
+				file.GoRecord(nRecord);
+				for (int y = 0; bOk && y < 5000 && nRecord < NumTestRecords; ++y, ++nRecord)
+				{
+					const SRC::RecordData* pRec = file.ReadRecord();
+					bOk = pRec && IsTestRecord(file.m_recordInfo, pRec, nRecord);
+				}
+			}
+			Check(bOk, bMemoryMap ? "read ahead with the memory mapping" : "read ahead without the memory mapping");
+		}
+	}
+}
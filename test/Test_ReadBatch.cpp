@@ -0,0 +1,50 @@
+#include <cstring>
+
+#include "TestUtil.h"
+
+void TestReadBatch()
+{
+	WriteTestFile(U16("temp_batch.yxdb"), true, E_Append_Records, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+
+	// batches that end inside a block, exactly on one and span several
+	for (unsigned nBatch : { 1u, 999u, unsigned(Alteryx::OpenYXDB::RecordsPerBlock), 150001u })
+	{
+		Alteryx::OpenYXDB::Open_AlteryxYXDB fileBatch, fileRecord;
+		fileBatch.Open(U16("temp_batch.yxdb"));
+		fileRecord.Open(U16("temp_batch.yxdb"));
+
+		int64_t nRecord = 0;
+		bool bOk = true;
+		for (;;)
+		{
+			SRC::TBlobVal<const SRC::RecordData*> batch = fileBatch.ReadBatch(nBatch);
+			if (batch.nLength == 0)
+				break;
+			bOk = bOk && batch.nLength <= nBatch;
+
+			const unsigned char* pNext = reinterpret_cast<const unsigned char*>(batch.pValue[0]);
+			for (unsigned x = 0; x < batch.nLength; ++x, ++nRecord)
+			{
+				// the records are back to back, and the same as ReadRecord gives
+				const SRC::RecordData* pRec = fileRecord.ReadRecord();
+				size_t nLen = fileBatch.m_recordInfo.GetRecordLen(batch.pValue[x]);
+				bOk = bOk && pRec && reinterpret_cast<const unsigned char*>(batch.pValue[x]) == pNext &&
+					  nLen == fileRecord.m_recordInfo.GetRecordLen(pRec) && memcmp(batch.pValue[x], pRec, nLen) == 0 &&
+					  IsTestRecord(fileBatch.m_recordInfo, batch.pValue[x], nRecord);
+				pNext += nLen;
+			}
+		}
+		Check(bOk && nRecord == NumTestRecords && fileRecord.ReadRecord() == nullptr, "ReadBatch");
+	}
+
+	// ReadBatch carries on from wherever GoRecord and ReadRecord left off
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_batch.yxdb"));
+	file.GoRecord(NumTestRecords - 70000);
+	file.ReadRecord();
+	SRC::TBlobVal<const SRC::RecordData*> batch = file.ReadBatch(100000);
+	bool bOk = batch.nLength == 69999;
+	for (unsigned x = 0; bOk && x < batch.nLength; ++x)
+		bOk = IsTestRecord(file.m_recordInfo, batch.pValue[x], NumTestRecords - 69999 + x);
+	Check(bOk && file.ReadBatch(10).nLength == 0, "ReadBatch after GoRecord");
+}
@@ -0,0 +1,116 @@
+#include <cstring>
+
+#include "TestUtil.h"
+
+#include "RecordLib/RecordAllocator.h"
+
+namespace {
+// a batch of test records all alive at once, so they can't be sharing a buffer.
+// They're checked in memory, then written to a file and read back
+bool CheckRecords(SRC::RecordAllocator& r_allocator, int64_t nFirst, int nRecords)
+{
+	SRC::RecordInfo recordInfo;
+	recordInfo.InitFromXml(TestRecordInfoXml(true).c_str());
+
+	std::vector<SRC::SmartPointerRefObj<SRC::Record>> vRecords;
+	for (int x = 0; x < nRecords; ++x)
+	{
+		vRecords.push_back(recordInfo.CreateRecord(r_allocator));
+		FillTestRecord(recordInfo, vRecords.back().Get(), nFirst + x);
+	}
+
+	bool bOk = true;
+	Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+	fileOut.Create(U16("temp_allocator.yxdb"), TestRecordInfoXml(true).c_str());
+	for (int x = 0; x < nRecords; ++x)
+	{
+		bOk = bOk && IsTestRecord(recordInfo, vRecords[x]->GetRecord(), nFirst + x);
+		fileOut.AppendRecord(vRecords[x]->GetRecord());
+	}
+	fileOut.Close();
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_allocator.yxdb"));
+	int64_t nRecord = nFirst;
+	while (const SRC::RecordData* pRec = file.ReadRecord())
+		bOk = bOk && IsTestRecord(file.m_recordInfo, pRec, nRecord++);
+	return bOk && nRecord == nFirst + nRecords;
+}
+}  // namespace
+
+void TestRecordAllocator()
+{
+	// records built through each allocator read back the same.  The names get long enough to make
+	// the records grow past their first buffer
+	Check(CheckRecords(SRC::RecordAllocator::GetDefault(), 0, 1000), "RecordAllocator default");
+	SRC::RecordArenaAllocator arena(16 * 1024);
+	Check(CheckRecords(arena, 0, 1000), "RecordArenaAllocator records");
+	SRC::RecordPoolAllocator pool;
+	Check(CheckRecords(pool, 0, 1000), "RecordPoolAllocator records");
+
+	// after a Reset the arena hands out the same memory again instead of reserving more
+	const size_t nReserved = arena.GetBytesReserved();
+	Check(nReserved >= 1000 * 40, "RecordArenaAllocator reserved");
+	arena.Reset();
+	Check(CheckRecords(arena, 0, 1000), "RecordArenaAllocator records after Reset");
+	Check(arena.GetBytesReserved() == nReserved, "RecordArenaAllocator reuse after Reset");
+
+	arena.Reset();
+	char* p1 = static_cast<char*>(arena.Reallocate(NULL, 0, 100));
+	memset(p1, 1, 100);
+	// the last allocation grows in place, and is aligned
+	Check(arena.Reallocate(p1, 100, 200) == p1 && (reinterpret_cast<uintptr_t>(p1) & 15) == 0,
+		  "RecordArenaAllocator grow in place");
+	char* p2 = static_cast<char*>(arena.Reallocate(NULL, 0, 50));
+	Check(p2 >= p1 + 200 && (reinterpret_cast<uintptr_t>(p2) & 15) == 0, "RecordArenaAllocator bump");
+	// growing anything else moves it and keeps the contents
+	char* p3 = static_cast<char*>(arena.Reallocate(p1, 200, 300));
+	Check(p3 != p1 && p3 >= p2 + 50 && p3[0] == 1 && p3[99] == 1, "RecordArenaAllocator move");
+	// more than a chunk gets a chunk of its own
+	char* pBig = static_cast<char*>(arena.Reallocate(NULL, 0, 100000));
+	memset(pBig, 2, 100000);
+	Check(p3[0] == 1 && arena.GetBytesReserved() >= nReserved + 100000, "RecordArenaAllocator big");
+	arena.Reset();
+	Check(arena.Reallocate(NULL, 0, 100) == p1, "RecordArenaAllocator Reset");
+
+	// a freed buffer is handed out again for any size in its class
+	SRC::RecordPoolAllocator pool2(4096);
+	void* pA = pool2.Reallocate(NULL, 0, 100);
+	void* pB = pool2.Reallocate(NULL, 0, 1000);
+	pool2.Free(pA, 100);
+	pool2.Free(pB, 1000);
+	Check(pool2.Reallocate(NULL, 0, 120) == pA, "RecordPoolAllocator recycle");
+	Check(pool2.Reallocate(NULL, 0, 600) == pB, "RecordPoolAllocator recycle");
+	void* pC = pool2.Reallocate(NULL, 0, 100);
+	Check(pC != pA && pC != pB, "RecordPoolAllocator empty free list");
+
+	// growing within the class keeps the buffer, growing past it recycles the old one
+	memset(pC, 3, 100);
+	Check(pool2.Reallocate(pC, 100, 128) == pC, "RecordPoolAllocator grow in class");
+	char* pD = static_cast<char*>(pool2.Reallocate(pC, 128, 300));
+	Check(pD != pC && pD[0] == 3 && pD[99] == 3, "RecordPoolAllocator grow");
+	Check(pool2.Reallocate(NULL, 0, 65) == pC, "RecordPoolAllocator grow recycles");
+
+	// past the biggest class it's just malloc
+	char* pE = static_cast<char*>(pool2.Reallocate(NULL, 0, 10000));
+	memset(pE, 4, 10000);
+	pE = static_cast<char*>(pool2.Reallocate(pE, 10000, 20000));
+	Check(pE[0] == 4 && pE[9999] == 4, "RecordPoolAllocator unpooled");
+	pool2.Free(pE, 20000);
+	pool2.Free(pD, 300);
+	pool2.Trim();
+
+	// records that come and go reuse each other's buffers
+	SRC::RecordInfo recordInfo;
+	recordInfo.InitFromXml(TestRecordInfoXml(true).c_str());
+	const SRC::RecordData* pFirst;
+	{
+		SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord(pool);
+		FillTestRecord(recordInfo, pRec.Get(), 5);
+		pFirst = pRec->GetRecord();
+	}
+	SRC::SmartPointerRefObj<SRC::Record> pRec = recordInfo.CreateRecord(pool);
+	FillTestRecord(recordInfo, pRec.Get(), 5);
+	Check(pRec->GetRecord() == pFirst && IsTestRecord(recordInfo, pRec->GetRecord(), 5),
+		  "RecordPoolAllocator record reuse");
+}
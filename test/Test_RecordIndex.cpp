@@ -0,0 +1,73 @@
+#include "TestUtil.h"
+
+namespace {
+// GoRecord to every nStep'th record, backwards from the end, then forwards
+bool CheckGoRecord(const U16unit* pFile, int64_t nStep)
+{
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(pFile);
+	bool bOk = file.GetNumRecords() == NumTestRecords;
+	for (int64_t nRecord = NumTestRecords - 1; bOk && nRecord >= 0; nRecord -= nStep)
+	{
+		file.GoRecord(nRecord);
+		const SRC::RecordData* pRec = file.ReadRecord();
+		bOk = pRec && IsTestRecord(file.m_recordInfo, pRec, nRecord);
+	}
+	for (int64_t nRecord = 0; bOk && nRecord < NumTestRecords; nRecord += nStep)
+	{
+		file.GoRecord(nRecord);
+		const SRC::RecordData* pRec = file.ReadRecord();
+		bOk = pRec && IsTestRecord(file.m_recordInfo, pRec, nRecord);
+	}
+	return bOk;
+}
+}  // namespace
+
+void TestRecordBlockIndex()
+{
+	// the record block index is written on Close, so a file we create has its blocks
+	WriteTestFile(U16("temp_index.yxdb"), true, E_Append_Record, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+	{
+		Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+		file.Open(U16("temp_index.yxdb"));
+		Check(file.GetNumRecordBlocks() ==
+				  unsigned((NumTestRecords + Alteryx::OpenYXDB::RecordsPerBlock - 1) / Alteryx::OpenYXDB::RecordsPerBlock),
+			  "record block index");
+	}
+	Check(CheckGoRecord(U16("temp_index.yxdb"), 997), "GoRecord with the record block index");
+
+	for (bool bVarData : { false, true })
+	{
+		WriteTestFile(U16("temp_index.yxdb"),
+					  bVarData,
+					  E_Append_Raw,
+					  [](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetDenseIndexInterval(128); });
+		CheckTestFile(U16("temp_index.yxdb"), "dense index");
+		Check(CheckGoRecord(U16("temp_index.yxdb"), 997), "GoRecord with the dense index");
+	}
+}
+
+void TestRecordOffsetIndex()
+{
+	for (unsigned nInterval : { 1u, 256u, unsigned(Alteryx::OpenYXDB::RecordsPerBlock) })
+	{
+		WriteTestFile(U16("temp_offsets.yxdb"),
+					  true,
+					  E_Append_Records,
+					  [&](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetRecordOffsetIndexInterval(nInterval); });
+		CheckTestFile(U16("temp_offsets.yxdb"), "record offset index");
+		Check(CheckGoRecord(U16("temp_offsets.yxdb"), 1009), "GoRecord with the record offset index");
+	}
+
+	bool bThrew = false;
+	try
+	{
+		Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+		file.SetRecordOffsetIndexInterval(1000);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "a record offset index interval that isn't a power of 2");
+}
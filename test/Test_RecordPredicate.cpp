@@ -0,0 +1,149 @@
+#include "TestUtil.h"
+
+namespace {
+typedef SRC::RecordPredicate RP;
+
+// Select has to pick out just the records Matches does, and Refine the same out of every other record.
+// Adds the number of matches to r_nMatches
+bool CheckSelect(const RP& predicate, const SRC::RecordData* const* ppRecords, size_t nRecords, size_t& r_nMatches)
+{
+	std::vector<uint32_t> vExpected, vOdd;
+	for (size_t x = 0; x < nRecords; ++x)
+	{
+		if (predicate.Matches(ppRecords[x]))
+		{
+			vExpected.push_back(uint32_t(x));
+			if (x % 2)
+				vOdd.push_back(uint32_t(x));
+		}
+	}
+	r_nMatches += vExpected.size();
+
+	std::vector<uint32_t> vSelection(nRecords);
+	vSelection.resize(predicate.Select(ppRecords, nRecords, vSelection.data()));
+	bool bOk = vSelection == vExpected;
+
+	vSelection.clear();
+	for (size_t x = 1; x < nRecords; x += 2)
+		vSelection.push_back(uint32_t(x));
+	vSelection.resize(predicate.Refine(ppRecords, vSelection.data(), vSelection.size()));
+	return bOk && vSelection == vOdd;
+}
+
+// every predicate over every batch of the file, and that each one matches some records but not all of them
+void CheckFile(const U16unit* pFile, const std::vector<std::pair<const char*, RP>>& vPredicates)
+{
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(pFile);
+	std::vector<char> vOk(vPredicates.size(), 1);
+	std::vector<size_t> vMatches(vPredicates.size());
+	size_t nRecords = 0;
+	while (true)
+	{
+		// batches of odd sizes, so the refine doesn't always see whole multiples of anything
+		SRC::TBlobVal<const SRC::RecordData*> batch = file.ReadBatch(3001);
+		if (batch.nLength == 0)
+			break;
+		nRecords += batch.nLength;
+		for (size_t x = 0; x < vPredicates.size(); ++x)
+			vOk[x] = vOk[x] && CheckSelect(vPredicates[x].second, batch.pValue, batch.nLength, vMatches[x]);
+	}
+	for (size_t x = 0; x < vPredicates.size(); ++x)
+		Check(vOk[x] && vMatches[x] != 0 && vMatches[x] != nRecords, vPredicates[x].first);
+}
+}  // namespace
+
+void TestRecordPredicate()
+{
+	for (bool bVarData : { false, true })
+	{
+		WriteTestFile(
+			U16("temp_predicate.yxdb"), bVarData, E_Append_Records, [](Alteryx::OpenYXDB::Open_AlteryxYXDB&) {});
+
+		// the predicates are built on a RecordInfo of their own with the same layout as the file's
+		SRC::RecordInfo recordInfo;
+		recordInfo.InitFromXml(TestRecordInfoXml(bVarData).c_str());
+		const SRC::FieldBase& id = *recordInfo[0];
+		const SRC::FieldBase& value = *recordInfo[1];
+		const SRC::FieldBase& name = *recordInfo[2];
+
+		const RP small = RP::Compare(id, RP::E_Compare_Less, 3000);
+		const RP twenties = RP::StartsWith(name, U16("twenty"));
+		const RP numbers = RP::In(id, std::vector<int64_t>{ 5, 77, 3001, 65536, 199999, 250000 });
+		const RP halves = RP::In(value, std::vector<double>{ 0.5, 1.5, 1000.0, 32768.0, -1 });
+		const RP names = RP::In(name, std::vector<SRC::WString>{ U16("seven"), U16("twelve"), U16("one thousand") });
+		std::vector<std::pair<const char*, RP>> vPredicates = {
+			{ "Select And", RP::And(small, RP::IsNotNull(value)) },
+			{ "Select Or", RP::Or(small, twenties) },
+			{ "Select nested Or",
+			  RP::Or(RP::Or(numbers, names), RP::And(RP::Or(halves, twenties), RP::IsNull(value))) },
+			{ "Select And of Ors", RP::And(RP::Or(small, twenties), RP::Or(RP::IsNull(value), names)) },
+			{ "Select In Int64", numbers },
+			{ "Select In Double", halves },
+			{ "Select In String", names },
+			{ "Select StartsWith", twenties },
+			{ "Select String Equal", RP::Compare(name, RP::E_Compare_Equal, U16("fourty two")) },
+			{ "Select String NotEqual", RP::Compare(name, RP::E_Compare_NotEqual, U16("one")) },
+			{ "Select String Less", RP::Compare(name, RP::E_Compare_Less, U16("fifty")) },
+			{ "Select String LessOrEqual", RP::Compare(name, RP::E_Compare_LessOrEqual, U16("one")) },
+			{ "Select String Greater", RP::Compare(name, RP::E_Compare_Greater, U16("t")) },
+			{ "Select String GreaterOrEqual", RP::Compare(name, RP::E_Compare_GreaterOrEqual, U16("seventy")) },
+			{ "Select Double Greater", RP::Compare(value, RP::E_Compare_Greater, 12345.25) },
+		};
+		CheckFile(U16("temp_predicate.yxdb"), vPredicates);
+	}
+
+	// the wide strings, and the narrow ones against wide values.  The String holds Latin-1, which widens
+	// straight to UTF-16
+	SRC::String strXml = U16("<RecordInfo>");
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Code"), SRC::E_FT_String, 6);
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Wide Code"), SRC::E_FT_WString, 6);
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Text"), SRC::E_FT_V_String, 100);
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Wide Text"), SRC::E_FT_V_WString, 100);
+	strXml += U16("</RecordInfo>");
+	{
+		Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+		fileOut.Create(U16("temp_predicate_wide.yxdb"), strXml.c_str());
+		const U16unit* pValues[] = { NULL,      U16(""),       U16("a"),      U16("ab"),
+									 U16("abc"), U16("b"),      U16("café"),   U16("cafe"),
+									 U16("ÿ"),   U16("abcdef"), U16("zz top"), U16("中文") };
+		SRC::SmartPointerRefObj<SRC::Record> pRec = fileOut.m_recordInfo.CreateRecord();
+		for (unsigned nRecord = 0; nRecord < 5000; ++nRecord)
+		{
+			pRec->Reset();
+			for (unsigned x = 0; x < 4; ++x)
+			{
+				// the narrow fields can't hold the Chinese
+				unsigned nValue = (nRecord * (x + 3) + nRecord / 12) % (x % 2 ? 12 : 11);
+				if (pValues[nValue])
+					fileOut.m_recordInfo[x]->SetFromString(pRec.Get(), pValues[nValue]);
+				else
+					fileOut.m_recordInfo[x]->SetNull(pRec.Get());
+			}
+			fileOut.AppendRecord(pRec->GetRecord());
+		}
+	}
+
+	SRC::RecordInfo recordInfo;
+	recordInfo.InitFromXml(strXml.c_str());
+	std::vector<std::pair<const char*, RP>> vPredicates;
+	const char* pNames[] = { "Select String", "Select WString", "Select V_String", "Select V_WString" };
+	for (unsigned x = 0; x < 4; ++x)
+	{
+		const SRC::FieldBase& field = *recordInfo[x];
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_Equal, U16("café")) });
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_NotEqual, U16("")) });
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_Less, U16("abc")) });
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_LessOrEqual, U16("b")) });
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_Greater, U16("cafe")) });
+		vPredicates.push_back({ pNames[x], RP::Compare(field, RP::E_Compare_GreaterOrEqual, U16("ÿ")) });
+		vPredicates.push_back({ pNames[x], RP::StartsWith(field, U16("ab")) });
+		vPredicates.push_back({ pNames[x], RP::StartsWith(field, U16("")) });
+		vPredicates.push_back(
+			{ pNames[x], RP::In(field, std::vector<SRC::WString>{ U16(""), U16("b"), U16("ÿ"), U16("中") }) });
+		const RP nextSet = RP::IsNotNull(*recordInfo[(x + 1) % 4]);
+		const RP startsC = RP::StartsWith(field, U16("c"));
+		vPredicates.push_back({ pNames[x], RP::Or(RP::IsNull(field), RP::And(nextSet, startsC)) });
+	}
+	CheckFile(U16("temp_predicate_wide.yxdb"), vPredicates);
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "TestUtil.h"
+
+namespace {
+// an SHP point (type 1) or polygon (type 5, just its bounding box and no parts)
+std::vector<unsigned char> ShpBlob(int nType, const Alteryx::OpenYXDB::SpatialBoundingBox& box)
+{
+	std::vector<double> vValues = { box.m_dMinX, box.m_dMinY };
+	if (nType != 1)
+		vValues.insert(vValues.end(), { box.m_dMaxX, box.m_dMaxY });
+
+	std::vector<unsigned char> vBlob(sizeof(nType) + vValues.size() * sizeof(double) + (nType != 1 ? 8 : 0));
+	memcpy(vBlob.data(), &nType, sizeof(nType));
+	memcpy(vBlob.data() + sizeof(nType), vValues.data(), vValues.size() * sizeof(double));
+	return vBlob;
+}
+
+// Id and Shape - nulls, points and small polygons, clustered by record number like real data tends to be.
+// Returns the bounding box of each record's shape
+std::vector<Alteryx::OpenYXDB::SpatialBoundingBox> WriteSpatialFile(const U16unit* pFile, bool bSpatialIndex)
+{
+	SRC::String strXml = U16("<RecordInfo>");
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Id"), SRC::E_FT_Int64);
+	strXml += SRC::RecordInfo::CreateFieldXml(U16("Shape"), SRC::E_FT_SpatialObj);
+	strXml += U16("</RecordInfo>");
+
+	std::mt19937 r;
+	std::uniform_real_distribution<double> coord(-180, 180);
+	std::vector<Alteryx::OpenYXDB::SpatialBoundingBox> vBoxes;
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB fileOut;
+	fileOut.SetSpatialIndex(bSpatialIndex);
+	fileOut.Create(pFile, strXml.c_str());
+
+	SRC::SmartPointerRefObj<SRC::Record> pRec = fileOut.m_recordInfo.CreateRecord();
+	for (int64_t nRecord = 0; nRecord < NumTestRecords; ++nRecord)
+	{
+		pRec->Reset();
+		fileOut.m_recordInfo[0]->SetFromInt64(pRec.Get(), nRecord);
+
+		double dX = double(nRecord / 1000 % 360) - 180 + coord(r) / 180, dY = coord(r) / 2;
+		if (nRecord % 10 == 0)
+		{
+			fileOut.m_recordInfo[1]->SetNull(pRec.Get());
+			vBoxes.push_back(Alteryx::OpenYXDB::SpatialBoundingBox());
+		}
+		else
+		{
+			double dSize = nRecord % 2 ? 0 : std::abs(coord(r)) / 50;
+			vBoxes.push_back(Alteryx::OpenYXDB::SpatialBoundingBox(dX, dY, dX + dSize, dY + dSize));
+			std::vector<unsigned char> vBlob = ShpBlob(nRecord % 2 ? 1 : 5, vBoxes.back());
+			fileOut.m_recordInfo[1]->SetFromBlob(pRec.Get(), SRC::BlobVal(unsigned(vBlob.size()), vBlob.data()));
+		}
+		fileOut.AppendRecord(pRec->GetRecord());
+	}
+	fileOut.Close();
+	return vBoxes;
+}
+
+inline unsigned BlockOf(int64_t nRecord)
+{
+	return unsigned(nRecord / Alteryx::OpenYXDB::RecordsPerBlock);
+}
+
+// the index has to give back every record a brute force check of the boxes does.  It keeps the boxes as
+// floats rounded outwards, so it can also give back records that only just miss, but nothing further off
+void CheckSpatialQueries(
+	const Alteryx::OpenYXDB::Open_AlteryxYXDB& file,
+	const std::vector<Alteryx::OpenYXDB::SpatialBoundingBox>& vBoxes,
+	const char* pWhat)
+{
+	std::mt19937 r(1);
+	std::uniform_real_distribution<double> coord(-180, 180);
+	bool bOk = true, bBlocksOk = true;
+	for (unsigned x = 0; x < 50; ++x)
+	{
+		double dX = coord(r), dY = coord(r) / 2, dSize = std::abs(coord(r)) / 20;
+		Alteryx::OpenYXDB::SpatialBoundingBox box(dX, dY, dX + dSize, dY + dSize);
+		Alteryx::OpenYXDB::SpatialBoundingBox near(dX - 1e-3, dY - 1e-3, dX + dSize + 1e-3, dY + dSize + 1e-3);
+
+		std::vector<int64_t> vExpected;
+		std::vector<unsigned> vExpectedBlocks;
+		for (int64_t nRecord = 0; nRecord < NumTestRecords; ++nRecord)
+		{
+			if (!vBoxes[size_t(nRecord)].Intersects(box))
+				continue;
+			vExpected.push_back(nRecord);
+			if (vExpectedBlocks.empty() || vExpectedBlocks.back() != BlockOf(nRecord))
+				vExpectedBlocks.push_back(BlockOf(nRecord));
+		}
+
+		std::vector<int64_t> vFound = file.QuerySpatialIndex(box);
+		size_t nExpected = 0;
+		for (size_t n = 0; n < vFound.size(); ++n)
+		{
+			const Alteryx::OpenYXDB::SpatialBoundingBox& found = vBoxes[size_t(vFound[n])];
+			bOk = bOk && (n == 0 || vFound[n - 1] < vFound[n]) && !found.IsEmpty() && found.Intersects(near);
+			if (nExpected < vExpected.size() && vExpected[nExpected] == vFound[n])
+				++nExpected;
+		}
+		bOk = bOk && nExpected == vExpected.size();
+
+		// the blocks can only differ by the ones holding just near misses
+		std::vector<unsigned> vFoundBlocks = file.QuerySpatialIndexBlocks(box);
+		for (unsigned nBlock : vExpectedBlocks)
+			bBlocksOk = bBlocksOk && std::find(vFoundBlocks.begin(), vFoundBlocks.end(), nBlock) != vFoundBlocks.end();
+		for (unsigned nBlock : vFoundBlocks)
+		{
+			bBlocksOk = bBlocksOk && std::any_of(vFound.begin(), vFound.end(), [nBlock](int64_t nRecord) {
+							return BlockOf(nRecord) == nBlock;
+						});
+		}
+	}
+	Check(bOk, (SRC::AString("QuerySpatialIndex ") + pWhat).c_str());
+	Check(bBlocksOk, (SRC::AString("QuerySpatialIndexBlocks ") + pWhat).c_str());
+}
+}  // namespace
+
+void TestSpatialIndex()
+{
+	std::vector<Alteryx::OpenYXDB::SpatialBoundingBox> vBoxes = WriteSpatialFile(U16("temp_spatial.yxdb"), true);
+
+	// the index written with the file is there as soon as it's opened, and the records are all still there
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_spatial.yxdb"));
+	Check(file.GetSpatialIndexField() == 1, "spatial index field");
+	int64_t nRecord = 0;
+	bool bOk = true;
+	while (const SRC::RecordData* pRec = file.ReadRecord())
+		bOk = bOk && file.m_recordInfo[0]->GetAsInt64(pRec).value == nRecord++;
+	Check(bOk && nRecord == NumTestRecords, "spatial index records");
+	CheckSpatialQueries(file, vBoxes, "written with the file");
+}
+
+void TestBuildSpatialIndex()
+{
+	std::vector<Alteryx::OpenYXDB::SpatialBoundingBox> vBoxes = WriteSpatialFile(U16("temp_spatial.yxdb"), false);
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_spatial.yxdb"));
+	Check(file.GetSpatialIndexField() == -1, "no spatial index");
+
+	// building it doesn't move the read position, on one thread or several
+	for (unsigned nThreads : { 1u, 4u })
+	{
+		file.GoRecord(1234);
+		file.BuildSpatialIndex(-1, nThreads);
+		const SRC::RecordData* pRec = file.ReadRecord();
+		Check(file.GetSpatialIndexField() == 1 && pRec && file.m_recordInfo[0]->GetAsInt64(pRec).value == 1234,
+			  "BuildSpatialIndex");
+		CheckSpatialQueries(file, vBoxes, nThreads == 1 ? "built on 1 thread" : "built on 4 threads");
+	}
+
+	// only a spatial field can be indexed
+	bool bThrew = false;
+	try
+	{
+		file.BuildSpatialIndex(0);
+	}
+	catch (const SRC::Error&)
+	{
+		bThrew = true;
+	}
+	Check(bThrew, "BuildSpatialIndex on a field that isn't spatial");
+}
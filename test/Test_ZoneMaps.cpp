@@ -0,0 +1,70 @@
+#include "TestUtil.h"
+
+namespace {
+// a scan has to give back just the records that checking every one of them does, in order
+bool CheckScan(Alteryx::OpenYXDB::Open_AlteryxYXDB& file, const Alteryx::OpenYXDB::ScanPredicate& predicate)
+{
+	std::vector<int64_t> vExpected;
+	file.GoRecord(0);
+	for (int64_t nRecord = 0; const SRC::RecordData* pRec = file.ReadRecord(); ++nRecord)
+	{
+		if (predicate.Matches(pRec))
+			vExpected.push_back(nRecord);
+	}
+
+	std::vector<int64_t> vFound;
+	bool bOk = true;
+	file.Scan(
+		predicate,
+		[&](unsigned, int64_t nRecord, const SRC::RecordData* pRec)
+		{
+			bOk = bOk && IsTestRecord(file.m_recordInfo, pRec, nRecord);
+			vFound.push_back(nRecord);
+		},
+		4);
+	return bOk && vFound == vExpected;
+}
+}  // namespace
+
+void TestZoneMaps()
+{
+	WriteTestFile(U16("temp_zonemaps.yxdb"),
+				  true,
+				  E_Append_Records,
+				  [](Alteryx::OpenYXDB::Open_AlteryxYXDB& file) { file.SetZoneMaps(true); });
+	CheckTestFile(U16("temp_zonemaps.yxdb"), "zone maps");
+
+	Alteryx::OpenYXDB::Open_AlteryxYXDB file;
+	file.Open(U16("temp_zonemaps.yxdb"));
+	Check(file.HasZoneMaps(), "HasZoneMaps");
+
+	// the Ids of block 1 are 65536 to 131071, and every 7th Value is null
+	const Alteryx::OpenYXDB::ZoneMapStats* pIds = file.GetZoneMapStats(1, 0);
+	const Alteryx::OpenYXDB::ZoneMapStats* pValues = file.GetZoneMapStats(1, 1);
+	Check(pIds && pIds->nMin == 65536 && pIds->nMax == 131071 && pIds->nNullCount == 0, "ZoneMapStats Int64");
+	Check(pValues && pValues->dMin == 65536 * 0.5 && pValues->dMax == 131071 * 0.5 && pValues->nNullCount == 9362,
+		  "ZoneMapStats Double");
+	Check(file.GetZoneMapStats(1, 2) == NULL, "ZoneMapStats V_String");
+
+	// the Ids are in order, so a range of them is in as few blocks as it spans
+	Alteryx::OpenYXDB::ScanPredicate ids(file.m_recordInfo);
+	ids.AddIntRange(0, 70000, 80000);
+	Check(file.GetMatchingBlocks(ids) == std::vector<unsigned>{ 1 }, "GetMatchingBlocks Int64 range");
+	Check(CheckScan(file, ids), "Scan Int64 range");
+
+	Alteryx::OpenYXDB::ScanPredicate values(file.m_recordInfo);
+	values.AddDoubleRange(1, 32000, 33000).AddIsNotNull(1);
+	Check(file.GetMatchingBlocks(values) == (std::vector<unsigned>{ 0, 1 }), "GetMatchingBlocks Double range");
+	Check(CheckScan(file, values), "Scan Double range");
+
+	// no block rules out nulls, and nothing matches a range past the end
+	Alteryx::OpenYXDB::ScanPredicate nulls(file.m_recordInfo);
+	nulls.AddIsNull(1);
+	Check(file.GetMatchingBlocks(nulls).size() == 4, "GetMatchingBlocks IsNull");
+	Check(CheckScan(file, nulls), "Scan IsNull");
+
+	Alteryx::OpenYXDB::ScanPredicate none(file.m_recordInfo);
+	none.AddIntRange(0, NumTestRecords, NumTestRecords + 1000);
+	Check(file.GetMatchingBlocks(none).empty(), "GetMatchingBlocks past the end");
+	Check(CheckScan(file, none), "Scan past the end");
+}
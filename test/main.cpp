@@ -1,12 +1,7 @@
 #include <iostream>
 #include <random>
 
-#include "FieldType.h"
-#include "Open_AlteryxYXDB.h"
-#include "SrcLib_Replacement.h"
-
-// only used for generating sample data
-SRC::AString EnglishNumber(int n);
+#include "TestUtil.h"
 
 void WriteSampleFile(const U16unit* pFile)
 {
@@ -111,13 +106,41 @@ int main()
 	{
 		WriteSampleFile(U16("temp.yxdb"));
 		ReadSampleFile(U16("temp.yxdb"));
+
+		TestAppendRecords();
+		TestParallelScan();
+		TestCompressionThreads();
+		TestReadBatch();
+		TestProjection();
+		TestRecordBlockIndex();
+		TestRecordOffsetIndex();
+		TestReadAhead();
+		TestCodecs();
+		TestCompressionBlockSize();
+		TestLzfDecompressors();
+		TestCompressionLevels();
+		TestFieldNumBatch();
+		TestFieldAccessor();
+		TestFieldScratch();
+		TestFieldStringAccessor();
+		TestRecordAllocator();
+		TestBuildSpatialIndex();
+		TestSpatialIndex();
+		TestZoneMaps();
+		TestRecordPredicate();
+		TestDataset();
+		TestPartitionedWriter();
+		TestBlockCache();
 	}
 	catch (const SRC::Error& e)
 	{
 		std::cout << SRC::ConvertToAString(e.GetErrorDescription()) << "\n";
+		++g_nFailures;
 	}
 
-	return 0;
+	if (g_nFailures != 0)
+		std::cout << g_nFailures << " checks FAILED\n";
+	return g_nFailures == 0 ? 0 : 1;
 }
 
 // only used for generating sample data